@@ -0,0 +1,174 @@
+// Append cost and recovery time of the order journal (OrderJournal.h).
+// A fresh journal gets the records of --orders orders: every order is received, every other one is sent and every
+// fourth one is answered, so half of them end up queued and a quarter in flight, the time per append is measured.
+// Then an OrderManagement is constructed on the journal, which replays it record by record (no snapshot yet) and
+// rolls it, and once more, which loads the snapshot the first recovery has written. Both recoveries are timed and
+// have to restore exactly the queued and in flight orders, the program exits with 1 if either doesn't.
+// The other parameters come from --config, OrderPoolSize and InFlightTableSize are raised to fit the orders and
+// JournalCapacity to hold their reserve (see OrderJournal.h).
+// Results are printed and, with --json, written to a file that can be compared between commits.
+//
+// Usage: JournalBenchmark [--config file] [--journal file] [--orders N] [--sync None|Periodic|EveryRecord]
+//                         [--json file]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "OrderManagement.h"
+#include "OrderJournal.h"
+#include "Clock.h"
+
+using namespace ordermanagement;
+
+namespace {
+
+struct Options {
+    std::string configFile = "config/benchmark_config.txt";
+    std::string journalFile = "/tmp/JournalBenchmark.journal";
+    uint64_t orders = 1000000;
+    JournalSyncPolicy syncPolicy = JournalSyncPolicy::None;
+    std::string jsonFile;
+};
+
+struct RecoveryResult {
+    const char* name;
+    JournalRecoveryStats stats;
+    bool valid;
+};
+
+// Returns the number of records appended
+uint64_t writeJournal(const Config& config, uint64_t orders, double& nsPerAppend)
+{
+    OrderJournal journal(config);
+    uint64_t records = 0;
+    const uint64_t startTicks = getMonotonicTicks();
+    for (uint64_t orderId = 1; orderId <= orders; ++orderId) {
+        journal.append(JournalRecord{orderId, orderId, static_cast<int32_t>(orderId % 100000), 100,
+                                     static_cast<int32_t>(orderId % 64), NO_CLIENT,
+                                     static_cast<uint8_t>(orderId % 2), JournalEvent::Received});
+        ++records;
+        if (orderId % 2 == 0) {
+            journal.append(JournalRecord{orderId, orderId, 0, 0, 0, NO_CLIENT, 0, JournalEvent::Sent});
+            ++records;
+        }
+        if (orderId % 4 == 0) {
+            journal.append(JournalRecord{orderId, orderId, 0, 0, 0, NO_CLIENT,
+                                         static_cast<uint8_t>(ResponseType::Accept), JournalEvent::Responded});
+            ++records;
+        }
+    }
+    nsPerAppend = static_cast<double>(ticksToNs(getMonotonicTicks() - startTicks)) / records;
+    return records;
+}
+
+RecoveryResult recover(const char* name, const Config& config, uint64_t orders)
+{
+    OrderManagement manager(config, VenueServices{});
+    const JournalRecoveryStats& stats = manager.getJournalRecoveryStats();
+    return RecoveryResult{name, stats, stats.queuedOrders == orders / 2 && stats.inFlightOrders == orders / 4
+                                           && stats.droppedOrders == 0};
+}
+
+void writeJson(const std::string& filename, const Options& options, uint64_t records, double nsPerAppend,
+               const std::vector<RecoveryResult>& results)
+{
+    std::ofstream out(filename);
+    out << "{\n  \"orders\": " << options.orders << ",\n"
+        << "  \"records\": " << records << ",\n"
+        << "  \"syncPolicy\": " << static_cast<int>(options.syncPolicy) << ",\n"
+        << "  \"nsPerAppend\": " << nsPerAppend << ",\n"
+        << "  \"recoveryMs\": {";
+    for (size_t index = 0; index < results.size(); ++index) {
+        out << (index ? ", " : "") << "\"" << results[index].name << "\": "
+            << results[index].stats.durationNs / 1e6;
+    }
+    out << "}\n}\n";
+}
+
+void usage()
+{
+    std::cerr << "Usage: JournalBenchmark [--config file] [--journal file] [--orders N] "
+                 "[--sync None|Periodic|EveryRecord] [--json file]" << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int arg = 1; arg < argc; ++arg) {
+        if (arg + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++arg];
+        if (std::strcmp(argv[arg - 1], "--config") == 0) {
+            options.configFile = value;
+        } else if (std::strcmp(argv[arg - 1], "--journal") == 0) {
+            options.journalFile = value;
+        } else if (std::strcmp(argv[arg - 1], "--orders") == 0) {
+            options.orders = std::max(4ull, std::stoull(value));
+        } else if (std::strcmp(argv[arg - 1], "--sync") == 0) {
+            if (std::strcmp(value, "None") == 0) {
+                options.syncPolicy = JournalSyncPolicy::None;
+            } else if (std::strcmp(value, "Periodic") == 0) {
+                options.syncPolicy = JournalSyncPolicy::Periodic;
+            } else if (std::strcmp(value, "EveryRecord") == 0) {
+                options.syncPolicy = JournalSyncPolicy::EveryRecord;
+            } else {
+                return false;
+            }
+        } else if (std::strcmp(argv[arg - 1], "--json") == 0) {
+            options.jsonFile = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 1;
+    }
+    Config config(options.configFile);
+    config.journalFile = options.journalFile;
+    config.journalSyncPolicy = options.syncPolicy;
+    config.orderPoolSize = static_cast<uint32_t>(std::max<uint64_t>(config.orderPoolSize, options.orders / 2));
+    config.inFlightTableSize = static_cast<uint32_t>(std::max<uint64_t>(config.inFlightTableSize, options.orders / 4));
+    // the journal has to keep a reserve for all the orders the pool and the in flight table can hold
+    config.journalCapacity = std::max(options.orders * 2, 2 * OrderJournal::reservedRecords(config));
+    // starts from scratch
+    std::remove(config.journalFile.c_str());
+    std::remove((config.journalFile + ".snapshot").c_str());
+    std::remove((config.journalFile + ".snapshot.previous").c_str());
+
+    double nsPerAppend = 0.0;
+    const uint64_t records = writeJournal(config, options.orders, nsPerAppend);
+    std::cout << "append: " << nsPerAppend << " ns/record, " << records << " records" << std::endl;
+
+    std::vector<RecoveryResult> results;
+    results.push_back(recover("journal", config, options.orders));
+    results.push_back(recover("snapshot", config, options.orders));
+    bool valid = true;
+    for (const auto& result : results) {
+        std::cout << "recovery from " << result.name << ": " << result.stats.durationNs / 1e6 << " ms, "
+                  << result.stats.replayedRecords << " records replayed, snapshot of "
+                  << result.stats.snapshotOrders << " orders, " << result.stats.queuedOrders << " queued, "
+                  << result.stats.inFlightOrders << " in flight" << (result.valid ? "" : " (WRONG)") << std::endl;
+        valid = valid && result.valid;
+    }
+    if (!options.jsonFile.empty()) {
+        writeJson(options.jsonFile, options, records, nsPerAppend, results);
+    }
+    std::remove(config.journalFile.c_str());
+    std::remove((config.journalFile + ".snapshot").c_str());
+    std::remove((config.journalFile + ".snapshot.previous").c_str());
+    return valid ? 0 : 1;
+}
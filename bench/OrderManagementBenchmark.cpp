@@ -0,0 +1,542 @@
+// Throughput/latency benchmark of OrderManagement.
+// N producer threads submit New/Modify/Cancel requests on a fixed open loop schedule (the offered rate doesn't
+// drop when onData() gets slow, late producers show up as producer lag) to an OrderManagement instance that
+// transmits to an in process exchange answering every order straight from the transmitter thread, or with
+// --exchange stress to a StressExchangeSimulator configured by the Exchange* config parameters (latency model,
+// reject ratio, exchange side rate limit, response threads), or with --exchange socket through a
+// SocketExchangeGateway to an exchange process at ExchangeAddress (tools/StandInExchange), in which case the
+// write and read syscalls per order are reported too. With --basket N every producer submits N requests at a time
+// through onDataBatch() and the enqueue latency is the time of the call divided by N.
+// Measured per run: enqueue latency (onData() call), queue wait and round trip (LatencyStatsCollectorCallback
+// subscribed to the stats bus), transmit rate and the maximum producer lag. With --sweep the offered rate is
+// multiplied by the factor from run to run and the knee point, the highest rate that the engine still
+// sustains (transmit rate keeps up, producers keep their schedule, queue wait doesn't explode), is reported.
+// Results are printed and, with --json, written to a file that can be compared between commits.
+//
+// Usage: OrderManagementBenchmark [--config file] [--producers N] [--rate requests/s] [--duration s]
+//                                 [--mix new:modify:cancel] [--sweep from:to:factor] 
+//                                 [--exchange inline|stress|socket] [--basket N] [--json file]
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "OrderManagement.h"
+#include "ExchangeSimulator.h"
+#include "StressExchangeSimulator.h"
+#include "SocketExchangeGateway.h"
+#include "LatencyStatsCollector.h"
+#include "Clock.h"
+
+using namespace ordermanagement;
+
+namespace {
+
+constexpr double PERCENTILES[] = {50.0, 99.0, 99.9};
+// a run is saturated when producers fall this far behind their schedule
+constexpr uint64_t MAX_PRODUCER_LAG_NS = 10000000;
+// or the transmitter sends less than this share of the orders it could have sent
+constexpr double MIN_TRANSMIT_RATIO = 0.95;
+// or the queue wait p99 grows this many times over the one of the first run (and above 1ms)
+constexpr double MAX_QUEUE_WAIT_GROWTH = 10.0;
+constexpr uint64_t MIN_DEGRADED_QUEUE_WAIT_NS = 1000000;
+constexpr size_t RECENT_ORDERS = 1024;
+
+enum class ExchangeKind {
+    Inline,
+    Stress,
+    Socket
+};
+
+const char* exchangeKindName(ExchangeKind exchange)
+{
+    switch (exchange) {
+        case ExchangeKind::Stress: return "stress";
+        case ExchangeKind::Socket: return "socket";
+        default: return "inline";
+    }
+}
+
+struct Options {
+    std::string configFile = "../config/benchmark_config.txt";
+    uint32_t producers = 2;
+    double rate = 100000.0;
+    double durationSec = 2.0;
+    uint32_t mixNew = 80;
+    uint32_t mixModify = 10;
+    uint32_t mixCancel = 10;
+    double sweepFrom = 0.0;
+    double sweepTo = 0.0;
+    double sweepFactor = 2.0;
+    ExchangeKind exchange = ExchangeKind::Inline;
+    uint32_t basket = 1;
+    std::string jsonFile;
+};
+
+struct RunResult {
+    double offeredRate = 0.0;
+    uint64_t newRequests = 0;
+    uint64_t modifyRequests = 0;
+    uint64_t cancelRequests = 0;
+    uint64_t transmitted = 0;
+    // modifies of in flight orders sent as cancel-replaces, part of transmitted
+    uint64_t replaced = 0;
+    double transmitRate = 0.0;
+    uint64_t maxProducerLagNs = 0;
+    uint64_t droppedStats = 0;
+    // socket exchange only
+    GatewayStats gatewayStats;
+    LatencyHistogram enqueueLatency;
+    LatencyHistogram queueWait;
+    LatencyHistogram roundTrip;
+};
+
+// Counts the orders and answers every order with an Accept straight from the transmitter thread,
+// or passes them on to the downstream exchange if there is one
+class BenchmarkExchange : public IExchangeSimulator {
+public:
+    BenchmarkExchange(OrderManagement* manager, IExchangeSimulator* downstream)
+        : m_manager(manager)
+        , m_downstream(downstream)
+    {
+    }
+
+    void send(const ordermanagement::OrderRequest& request) override
+    {
+        m_lastSendTimeNs.store(getCurrentTimeNs(), std::memory_order_relaxed);
+        m_sent.fetch_add(1, std::memory_order_relaxed);
+        if (m_downstream) {
+            m_downstream->send(request);
+        } else {
+            m_manager->onData(ordermanagement::OrderResponse{request.orderId, ResponseType::Accept});
+        }
+    }
+    void sendBatch(std::span<const ordermanagement::OrderRequest> requests) override
+    {
+        if (!m_downstream) {
+            IExchangeSimulator::sendBatch(requests);
+            return;
+        }
+        m_lastSendTimeNs.store(getCurrentTimeNs(), std::memory_order_relaxed);
+        m_sent.fetch_add(requests.size(), std::memory_order_relaxed);
+        m_downstream->sendBatch(requests);
+    }
+    void sendReplace(const ordermanagement::OrderRequest& request) override
+    {
+        m_replaced.fetch_add(1, std::memory_order_relaxed);
+        if (m_downstream) {
+            m_lastSendTimeNs.store(getCurrentTimeNs(), std::memory_order_relaxed);
+            m_sent.fetch_add(1, std::memory_order_relaxed);
+            m_downstream->sendReplace(request);
+        } else {
+            send(request);
+        }
+    }
+    void sendLogon(const Logon& logon) override
+    {
+        if (m_downstream) {
+            m_downstream->sendLogon(logon);
+        }
+        m_loggedIn = true;
+    }
+    void sendLogout(const Logout& logout) override
+    {
+        m_loggedIn = false;
+        if (m_downstream) {
+            m_downstream->sendLogout(logout);
+        }
+    }
+
+    bool loggedIn() const { return m_loggedIn; }
+    // including the replaces
+    uint64_t sent() const { return m_sent.load(std::memory_order_relaxed); }
+    uint64_t replaced() const { return m_replaced.load(std::memory_order_relaxed); }
+    uint64_t lastSendTimeNs() const { return m_lastSendTimeNs.load(std::memory_order_relaxed); }
+
+private:
+    OrderManagement* m_manager;
+    IExchangeSimulator* m_downstream;
+    std::atomic_bool m_loggedIn = false;
+    std::atomic<uint64_t> m_sent = 0;
+    std::atomic<uint64_t> m_replaced = 0;
+    std::atomic<uint64_t> m_lastSendTimeNs = 0;
+};
+
+struct ProducerResult {
+    uint64_t newRequests = 0;
+    uint64_t modifyRequests = 0;
+    uint64_t cancelRequests = 0;
+    uint64_t maxLagNs = 0;
+    LatencyHistogram enqueueLatency;
+};
+
+void waitUntil(uint64_t timeNs)
+{
+    constexpr uint64_t SPIN_THRESHOLD_NS = 50000;
+    uint64_t currentTime = getCurrentTimeNs();
+    if (timeNs > currentTime + SPIN_THRESHOLD_NS) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(timeNs - currentTime - SPIN_THRESHOLD_NS));
+    }
+    // yielding rather than spinning, so that producers don't starve the engine threads when there are
+    // fewer cores than threads
+    while (getCurrentTimeNs() < timeNs) {
+        std::this_thread::yield();
+    }
+}
+
+void produce(OrderManagement& manager, const Options& options, uint32_t producer, double rate,
+             uint64_t startTimeNs, uint64_t endTimeNs, ProducerResult& result)
+{
+    // a basket of requests is submitted at every scheduled time
+    const double intervalNs = options.producers * 1e9 * options.basket / rate;
+    // producers are spread evenly over the interval
+    const double offsetNs = intervalNs * producer / options.producers;
+    std::mt19937 generator(producer + 1);
+    std::uniform_int_distribution<uint32_t> mixDistribution(0, options.mixNew + options.mixModify + options.mixCancel - 1);
+    std::vector<uint64_t> recentOrders;
+    recentOrders.reserve(RECENT_ORDERS);
+    // the producer number in the top bits keeps order ids unique across producers
+    uint64_t nextOrderId = (static_cast<uint64_t>(producer) + 1) << 48;
+    std::vector<BatchRequest> basket(options.basket);
+    std::vector<RejectCode> basketResults(options.basket);
+
+    for (uint64_t request = 0; ; ++request) {
+        const uint64_t scheduledTime = startTimeNs + static_cast<uint64_t>(offsetNs + request * intervalNs);
+        if (scheduledTime >= endTimeNs) {
+            break;
+        }
+        waitUntil(scheduledTime);
+        for (auto& [orderRequest, requestType] : basket) {
+            const uint32_t mix = mixDistribution(generator);
+            orderRequest = ordermanagement::OrderRequest{static_cast<int>(producer), 100.0, 1, 'B', 0};
+            requestType = RequestType::New;
+            if (mix >= options.mixNew && !recentOrders.empty()) {
+                orderRequest.orderId = recentOrders[generator() % recentOrders.size()];
+                requestType = mix < options.mixNew + options.mixModify ? RequestType::Modify : RequestType::Cancel;
+            } else {
+                orderRequest.orderId = nextOrderId++;
+                if (recentOrders.size() < RECENT_ORDERS) {
+                    recentOrders.push_back(orderRequest.orderId);
+                } else {
+                    recentOrders[orderRequest.orderId % RECENT_ORDERS] = orderRequest.orderId;
+                }
+            }
+            switch (requestType) {
+                case RequestType::New: ++result.newRequests; break;
+                case RequestType::Modify: ++result.modifyRequests; break;
+                default: ++result.cancelRequests; break;
+            }
+        }
+
+        const uint64_t startTicks = getMonotonicTicks();
+        const uint64_t currentTime = getCurrentTimeNs();
+        if (options.basket == 1) {
+            manager.onData(ordermanagement::OrderRequest(basket[0].request), basket[0].requestType);
+        } else {
+            manager.onDataBatch(basket, basketResults);
+        }
+        result.enqueueLatency.record(ticksToNs(getMonotonicTicks() - startTicks) / options.basket);
+        result.maxLagNs = std::max(result.maxLagNs, currentTime - scheduledTime);
+    }
+}
+
+RunResult runBenchmark(const Options& options, double rate)
+{
+    OrderManagement manager(options.configFile, nullptr);
+    auto latencyStats = std::make_unique<LatencyStatsCollectorCallback>();
+    const LatencyStatsCollectorCallback& latencyCollector = *latencyStats;
+    // large enough for the whole run, the bus drops records that don't fit
+    const SubscriberId latencySubscriber = manager.getStatsBus().subscribe(std::move(latencyStats), 1 << 22);
+
+    // the exchange is open for the whole run
+    Config& config = manager.getConfig();
+    const uint64_t currentTime = getCurrentTimeNs();
+    const uint64_t currentTimeOffsetFromDayStart = currentTime % NS_IN_DAY;
+    config.sessions.clear();
+    config.openTimeOffsetFromDayStartNs = currentTimeOffsetFromDayStart - NS_IN_SECOND;
+    config.closeTimeOffsetFromDayStartNs = currentTimeOffsetFromDayStart
+        + static_cast<uint64_t>((options.durationSec + 60.0) * NS_IN_SECOND);
+    std::unique_ptr<StressExchangeSimulator> stressExchange;
+    std::unique_ptr<SocketExchangeGateway> socketExchange;
+    IExchangeSimulator* downstream = nullptr;
+    if (options.exchange == ExchangeKind::Stress) {
+        stressExchange = std::make_unique<StressExchangeSimulator>(&manager);
+        downstream = stressExchange.get();
+    } else if (options.exchange == ExchangeKind::Socket) {
+        socketExchange = std::make_unique<SocketExchangeGateway>(&manager);
+        downstream = socketExchange.get();
+    }
+    BenchmarkExchange exchange(&manager, downstream);
+    manager.setExchangeSimulator(&exchange);
+    manager.start();
+    while (!exchange.loggedIn()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const uint64_t startTime = getCurrentTimeNs() + 1000000;
+    const uint64_t endTime = startTime + static_cast<uint64_t>(options.durationSec * NS_IN_SECOND);
+    std::vector<ProducerResult> producerResults(options.producers);
+    std::vector<std::thread> producers;
+    for (uint32_t producer = 0; producer < options.producers; ++producer) {
+        producers.emplace_back(produce, std::ref(manager), std::cref(options), producer, rate,
+                               startTime, endTime, std::ref(producerResults[producer]));
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    // wait until the queue is drained and every response has reached the latency collector
+    uint64_t transmitted = exchange.sent();
+    uint64_t completed = manager.getStatsBus().getSubscriberStats(latencySubscriber).published;
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const uint64_t nowTransmitted = exchange.sent();
+        const SubscriberStats stats = manager.getStatsBus().getSubscriberStats(latencySubscriber);
+        if (nowTransmitted == transmitted && stats.published == completed && stats.lag == 0) {
+            break;
+        }
+        transmitted = nowTransmitted;
+        completed = stats.published;
+    }
+
+    RunResult result;
+    result.offeredRate = rate;
+    for (const auto& producerResult : producerResults) {
+        result.newRequests += producerResult.newRequests;
+        result.modifyRequests += producerResult.modifyRequests;
+        result.cancelRequests += producerResult.cancelRequests;
+        result.maxProducerLagNs = std::max(result.maxProducerLagNs, producerResult.maxLagNs);
+        result.enqueueLatency.merge(producerResult.enqueueLatency);
+    }
+    result.transmitted = exchange.sent();
+    result.replaced = exchange.replaced();
+    const uint64_t transmitEndTime = std::max(exchange.lastSendTimeNs(), endTime);
+    result.transmitRate = result.transmitted * 1e9 / (transmitEndTime - startTime);
+    result.droppedStats = manager.getStatsBus().getSubscriberStats(latencySubscriber).dropped;
+    if (socketExchange) {
+        result.gatewayStats = socketExchange->getStats();
+    }
+    const LatencySnapshot snapshot = latencyCollector.snapshot(StatsWindow::Session);
+    for (size_t type = 0; type < LatencySnapshot::RESPONSE_TYPES; ++type) {
+        result.queueWait.merge(snapshot.queueWait[type]);
+        result.roundTrip.merge(snapshot.roundTrip[type]);
+    }
+    manager.getStatsBus().unsubscribe(latencySubscriber);
+    // the transmitters must not send anything to the exchanges while they are destroyed
+    manager.shutDown();
+    return result;
+}
+
+// Returns an empty string if the run kept up with the offered rate
+std::string saturationReason(const RunResult& run, const RunResult& baseline, double durationSec)
+{
+    if (run.maxProducerLagNs > MAX_PRODUCER_LAG_NS) {
+        return "producers fell behind";
+    }
+    // cancelled orders are never sent, so they don't count against the transmitter
+    const double sendableRate = (run.newRequests - std::min(run.newRequests, run.cancelRequests)) / durationSec;
+    if (run.transmitRate < MIN_TRANSMIT_RATIO * sendableRate) {
+        return "transmit rate fell behind";
+    }
+    const uint64_t queueWait = run.queueWait.valueAtPercentile(99.0);
+    if (queueWait > MIN_DEGRADED_QUEUE_WAIT_NS
+        && queueWait > MAX_QUEUE_WAIT_GROWTH * baseline.queueWait.valueAtPercentile(99.0)) {
+        return "queue wait exploded";
+    }
+    return "";
+}
+
+void printHistogram(std::ostream& out, const char* name, const LatencyHistogram& histogram)
+{
+    out << "  " << name << ":";
+    for (double percentile : PERCENTILES) {
+        out << " p" << percentile << "=" << histogram.valueAtPercentile(percentile);
+    }
+    out << " max=" << histogram.maxValue() << " (ns)\n";
+}
+
+void printRun(std::ostream& out, const RunResult& run)
+{
+    out << "offered " << run.offeredRate << " req/s: new=" << run.newRequests << " modify=" << run.modifyRequests
+        << " cancel=" << run.cancelRequests << " transmitted=" << run.transmitted
+        << " replaced=" << run.replaced
+        << " transmitRate=" << run.transmitRate << "/s maxProducerLag=" << run.maxProducerLagNs << "ns"
+        << " droppedStats=" << run.droppedStats << "\n";
+    if (run.gatewayStats.ordersSent > 0) {
+        const GatewayStats& gateway = run.gatewayStats;
+        const uint64_t responses = std::max<uint64_t>(1, gateway.responsesReceived);
+        out << "  gateway: writes/order=" << static_cast<double>(gateway.writeCalls) / gateway.ordersSent
+            << " reads/response=" << static_cast<double>(gateway.readCalls) / responses
+            << " bytesWritten=" << gateway.bytesWritten << " connects=" << gateway.connects
+            << " localRejects=" << gateway.localRejects << "\n";
+    }
+    printHistogram(out, "enqueue", run.enqueueLatency);
+    printHistogram(out, "queueWait", run.queueWait);
+    printHistogram(out, "roundTrip", run.roundTrip);
+    out.flush();
+}
+
+void writeHistogramJson(std::ostream& out, const char* name, const LatencyHistogram& histogram)
+{
+    out << "\"" << name << "\": {\"count\": " << histogram.totalCount()
+        << ", \"mean\": " << histogram.mean();
+    for (double percentile : PERCENTILES) {
+        out << ", \"p" << percentile << "\": " << histogram.valueAtPercentile(percentile);
+    }
+    out << ", \"max\": " << histogram.maxValue() << "}";
+}
+
+void writeJson(const std::string& filename, const Options& options, const std::vector<RunResult>& runs,
+               double kneeRate)
+{
+    std::ofstream out(filename);
+    out << "{\n  \"config\": \"" << options.configFile << "\",\n"
+        << "  \"producers\": " << options.producers << ",\n"
+        << "  \"durationSec\": " << options.durationSec << ",\n"
+        << "  \"exchange\": \"" << exchangeKindName(options.exchange) << "\",\n"
+        << "  \"basket\": " << options.basket << ",\n"
+        << "  \"mix\": {\"new\": " << options.mixNew << ", \"modify\": " << options.mixModify
+        << ", \"cancel\": " << options.mixCancel << "},\n"
+        << "  \"kneeRate\": " << kneeRate << ",\n"
+        << "  \"runs\": [\n";
+    for (size_t index = 0; index < runs.size(); ++index) {
+        const RunResult& run = runs[index];
+        out << "    {\"offeredRate\": " << run.offeredRate
+            << ", \"new\": " << run.newRequests
+            << ", \"modify\": " << run.modifyRequests
+            << ", \"cancel\": " << run.cancelRequests
+            << ", \"transmitted\": " << run.transmitted
+            << ", \"replaced\": " << run.replaced
+            << ", \"transmitRate\": " << run.transmitRate
+            << ", \"maxProducerLagNs\": " << run.maxProducerLagNs
+            << ", \"droppedStats\": " << run.droppedStats
+            << ", \"gatewayWriteCalls\": " << run.gatewayStats.writeCalls
+            << ", \"gatewayReadCalls\": " << run.gatewayStats.readCalls
+            << ", \"gatewayLocalRejects\": " << run.gatewayStats.localRejects << ", ";
+        writeHistogramJson(out, "enqueueNs", run.enqueueLatency);
+        out << ", ";
+        writeHistogramJson(out, "queueWaitNs", run.queueWait);
+        out << ", ";
+        writeHistogramJson(out, "roundTripNs", run.roundTrip);
+        out << "}" << (index + 1 < runs.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+bool parseList(const char* argument, char separator, std::vector<double>& values, size_t count)
+{
+    std::stringstream stream(argument);
+    std::string value;
+    values.clear();
+    while (std::getline(stream, value, separator)) {
+        values.push_back(std::stod(value));
+    }
+    return values.size() == count;
+}
+
+void usage()
+{
+    std::cerr << "Usage: OrderManagementBenchmark [--config file] [--producers N] [--rate requests/s] [--duration s]\n"
+              << "                                [--mix new:modify:cancel] [--sweep from:to:factor]"
+              << "\n                                [--exchange inline|stress|socket] [--basket N] [--json file]"
+              << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    std::vector<double> values;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (arg + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++arg];
+        if (std::strcmp(argv[arg - 1], "--config") == 0) {
+            options.configFile = value;
+        } else if (std::strcmp(argv[arg - 1], "--producers") == 0) {
+            options.producers = std::max(1, std::atoi(value));
+        } else if (std::strcmp(argv[arg - 1], "--rate") == 0) {
+            options.rate = std::stod(value);
+        } else if (std::strcmp(argv[arg - 1], "--duration") == 0) {
+            options.durationSec = std::stod(value);
+        } else if (std::strcmp(argv[arg - 1], "--exchange") == 0
+                   && (std::strcmp(value, "inline") == 0 || std::strcmp(value, "stress") == 0
+                       || std::strcmp(value, "socket") == 0)) {
+            options.exchange = std::strcmp(value, "stress") == 0 ? ExchangeKind::Stress
+                : std::strcmp(value, "socket") == 0 ? ExchangeKind::Socket : ExchangeKind::Inline;
+        } else if (std::strcmp(argv[arg - 1], "--basket") == 0) {
+            options.basket = std::max(1, std::atoi(value));
+        } else if (std::strcmp(argv[arg - 1], "--json") == 0) {
+            options.jsonFile = value;
+        } else if (std::strcmp(argv[arg - 1], "--mix") == 0 && parseList(value, ':', values, 3)
+                   && values[0] + values[1] + values[2] > 0) {
+            options.mixNew = static_cast<uint32_t>(values[0]);
+            options.mixModify = static_cast<uint32_t>(values[1]);
+            options.mixCancel = static_cast<uint32_t>(values[2]);
+        } else if (std::strcmp(argv[arg - 1], "--sweep") == 0 && parseList(value, ':', values, 3)
+                   && values[0] > 0 && values[1] >= values[0] && values[2] > 1.0) {
+            options.sweepFrom = values[0];
+            options.sweepTo = values[1];
+            options.sweepFactor = values[2];
+        } else {
+            return false;
+        }
+    }
+    return options.rate > 0 && options.durationSec > 0;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            usage();
+            return 1;
+        }
+    } catch (const std::exception&) {
+        usage();
+        return 1;
+    }
+
+    std::vector<double> rates;
+    if (options.sweepFrom > 0) {
+        for (double rate = options.sweepFrom; rate <= options.sweepTo * 1.0001; rate *= options.sweepFactor) {
+            rates.push_back(rate);
+        }
+    } else {
+        rates.push_back(options.rate);
+    }
+
+    std::vector<RunResult> runs;
+    double kneeRate = 0.0;
+    bool saturated = false;
+    for (double rate : rates) {
+        runs.push_back(runBenchmark(options, rate));
+        printRun(std::cout, runs.back());
+        const std::string reason = saturationReason(runs.back(), runs.front(), options.durationSec);
+        if (!reason.empty()) {
+            std::cout << "  saturated: " << reason << std::endl;
+            saturated = true;
+            // the rest of the sweep would only be slower
+            break;
+        }
+        kneeRate = rate;
+    }
+    if (rates.size() > 1) {
+        std::cout << "Knee: " << kneeRate << " req/s" << (saturated ? "" : " (not saturated within the sweep)")
+                  << std::endl;
+    }
+    if (!options.jsonFile.empty()) {
+        writeJson(options.jsonFile, options, runs, kneeRate);
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+// Round trip check and ns per message benchmark of the binary wire codec (WireCodec.h).
+// First every message type is encoded into a SendBuffer, split back into messages with forEachMessage() and
+// decoded, random orders (prices below a million with up to 9 decimals, all sides, symbols and quantities)
+// must come back unchanged, the program exits with 1 if any doesn't. Then the time per message is measured for:
+//   encodeOrder    - OrderRequest encoded into a reused SendBuffer, a batch of --batch orders per buffer
+//   decodeOrder    - OrderRequest decoded from a buffer of orders
+//   encodeResponse - OrderResponse encoded the same way
+//   decodeResponse - orderId and response type read in place (Decoder) while walking a buffer of responses
+// Results are printed and, with --json, written to a file that can be compared between commits.
+//
+// Usage: WireCodecBenchmark [--iterations N] [--batch N] [--json file]
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "WireCodec.h"
+#include "Clock.h"
+
+using namespace ordermanagement;
+
+namespace {
+
+struct Options {
+    uint32_t iterations = 20000;
+    uint32_t batch = 256;
+    std::string jsonFile;
+};
+
+struct BenchResult {
+    const char* name;
+    double nsPerMessage;
+};
+
+std::vector<ordermanagement::OrderRequest> randomOrders(size_t count, uint32_t seed)
+{
+    std::mt19937_64 generator(seed);
+    std::uniform_int_distribution<int> decimals(0, 9);
+    std::vector<ordermanagement::OrderRequest> orders;
+    for (size_t i = 0; i < count; ++i) {
+        double scale = 1.0;
+        for (int decimal = decimals(generator); decimal > 0; --decimal) {
+            scale *= 10.0;
+        }
+        // prices below a million, the range the codec keeps exact with 9 decimals
+        const int64_t maxMantissa = static_cast<int64_t>(1e6 * scale);
+        const int64_t mantissa = std::uniform_int_distribution<int64_t>(-maxMantissa, maxMantissa)(generator);
+        orders.push_back(ordermanagement::OrderRequest{static_cast<int>(generator()), mantissa / scale,
+                                                       generator(), generator() % 2 ? 'B' : 'S', generator()});
+    }
+    return orders;
+}
+
+bool sameOrder(const ordermanagement::OrderRequest& left, const ordermanagement::OrderRequest& right)
+{
+    return left.symbolId == right.symbolId && left.price == right.price && left.qty == right.qty
+        && left.side == right.side && left.orderId == right.orderId;
+}
+
+// Returns the number of messages that didn't survive the round trip
+size_t checkRoundTrip()
+{
+    const auto orders = randomOrders(100000, 1);
+    wire::SendBuffer buffer(orders.size() * wire::NewOrderMessage::MESSAGE_SIZE + 1024);
+    for (const auto& order : orders) {
+        wire::encode(order, buffer);
+    }
+    const ordermanagement::OrderResponse responses[] = {{1, ResponseType::Accept}, {~0ull, ResponseType::Reject},
+                                                        {42, ResponseType::Unknown}};
+    for (const auto& response : responses) {
+        wire::encode(response, buffer);
+    }
+    wire::encode(Logon{"sixteen_chars_us", "1234"}, buffer);
+    wire::encode(Logout{"user"}, buffer);
+    wire::encodeReplace(orders.back(), buffer);
+
+    size_t failures = 0;
+    size_t orderIndex = 0;
+    size_t responseIndex = 0;
+    size_t otherMessages = 0;
+    // fed in uneven chunks, so that messages are split between the calls like on a socket
+    size_t offset = 0;
+    size_t received = 0;
+    std::mt19937 generator(2);
+    while (offset < buffer.size()) {
+        received = std::min(buffer.size(), received + 1 + generator() % 200);
+        offset += wire::forEachMessage(
+            std::span<const uint8_t>(buffer.data() + offset, received - offset),
+            [&](const wire::MessageHeader& header, const uint8_t* message) {
+                switch (header.templateId) {
+                    case wire::NewOrderMessage::TEMPLATE_ID:
+                        failures += !sameOrder(wire::decodeOrderRequest(message), orders[orderIndex++]);
+                        break;
+                    case wire::OrderResponseMessage::TEMPLATE_ID: {
+                            const auto response = wire::decodeOrderResponse(message);
+                            failures += response.orderId != responses[responseIndex].orderId
+                                || response.responseType != responses[responseIndex].responseType;
+                            ++responseIndex;
+                        }
+                        break;
+                    case wire::LogonMessage::TEMPLATE_ID: {
+                            const auto logon = wire::decodeLogon(message);
+                            failures += logon.username != "sixteen_chars_us" || logon.password != "1234";
+                            ++otherMessages;
+                        }
+                        break;
+                    case wire::LogoutMessage::TEMPLATE_ID:
+                        failures += wire::decodeLogout(message).username != "user";
+                        ++otherMessages;
+                        break;
+                    case wire::CancelReplaceMessage::TEMPLATE_ID:
+                        failures += !sameOrder(wire::decodeOrderRequest(message), orders.back());
+                        ++otherMessages;
+                        break;
+                }
+            });
+    }
+    // a username that doesn't fit is refused, not truncated
+    failures += wire::encode(Logout{"seventeen_chars_u"}, buffer);
+    return failures + (orders.size() - orderIndex) + (std::size(responses) - responseIndex) + (3 - otherMessages);
+}
+
+template <typename Step>
+double nsPerMessage(const Options& options, Step&& step)
+{
+    const uint64_t startTicks = getMonotonicTicks();
+    for (uint32_t iteration = 0; iteration < options.iterations; ++iteration) {
+        step();
+    }
+    return static_cast<double>(ticksToNs(getMonotonicTicks() - startTicks)) / options.iterations / options.batch;
+}
+
+std::vector<BenchResult> runBenchmarks(const Options& options, uint64_t& checksum)
+{
+    const auto orders = randomOrders(options.batch, 3);
+    std::vector<ordermanagement::OrderResponse> responses;
+    for (const auto& order : orders) {
+        responses.push_back(ordermanagement::OrderResponse{order.orderId, ResponseType::Accept});
+    }
+    wire::SendBuffer orderBuffer(options.batch * wire::NewOrderMessage::MESSAGE_SIZE);
+    wire::SendBuffer responseBuffer(options.batch * wire::OrderResponseMessage::MESSAGE_SIZE);
+    std::vector<BenchResult> results;
+
+    results.push_back({"encodeOrder", nsPerMessage(options, [&]() {
+        orderBuffer.clear();
+        for (const auto& order : orders) {
+            wire::encode(order, orderBuffer);
+        }
+        checksum += orderBuffer.data()[orderBuffer.size() - 1];
+    })});
+    results.push_back({"decodeOrder", nsPerMessage(options, [&]() {
+        for (size_t offset = 0; offset < orderBuffer.size(); offset += wire::NewOrderMessage::MESSAGE_SIZE) {
+            checksum += wire::decodeOrderRequest(orderBuffer.data() + offset).qty;
+        }
+    })});
+    results.push_back({"encodeResponse", nsPerMessage(options, [&]() {
+        responseBuffer.clear();
+        for (const auto& response : responses) {
+            wire::encode(response, responseBuffer);
+        }
+        checksum += responseBuffer.data()[responseBuffer.size() - 1];
+    })});
+    results.push_back({"decodeResponse", nsPerMessage(options, [&]() {
+        wire::forEachMessage(std::span<const uint8_t>(responseBuffer.data(), responseBuffer.size()),
+                             [&](const wire::MessageHeader&, const uint8_t* message) {
+                                 const wire::Decoder<wire::OrderResponseMessage> decoder(message);
+                                 checksum += decoder.get<wire::OrderId>() + decoder.get<wire::ResponseKind>();
+                             });
+    })});
+    return results;
+}
+
+void writeJson(const std::string& filename, const Options& options, const std::vector<BenchResult>& results)
+{
+    std::ofstream out(filename);
+    out << "{\n  \"iterations\": " << options.iterations << ",\n"
+        << "  \"batch\": " << options.batch << ",\n"
+        << "  \"nsPerMessage\": {";
+    for (size_t index = 0; index < results.size(); ++index) {
+        out << (index ? ", " : "") << "\"" << results[index].name << "\": " << results[index].nsPerMessage;
+    }
+    out << "}\n}\n";
+}
+
+void usage()
+{
+    std::cerr << "Usage: WireCodecBenchmark [--iterations N] [--batch N] [--json file]" << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int arg = 1; arg < argc; ++arg) {
+        if (arg + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++arg];
+        if (std::strcmp(argv[arg - 1], "--iterations") == 0) {
+            options.iterations = std::max(1, std::atoi(value));
+        } else if (std::strcmp(argv[arg - 1], "--batch") == 0) {
+            options.batch = std::max(1, std::atoi(value));
+        } else if (std::strcmp(argv[arg - 1], "--json") == 0) {
+            options.jsonFile = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 1;
+    }
+    const size_t failures = checkRoundTrip();
+    if (failures != 0) {
+        std::cerr << "round trip failed for " << failures << " messages" << std::endl;
+        return 1;
+    }
+    std::cout << "round trip: ok\n";
+
+    uint64_t checksum = 0;
+    const auto results = runBenchmarks(options, checksum);
+    for (const auto& result : results) {
+        std::cout << result.name << ": " << result.nsPerMessage << " ns/message\n";
+    }
+    // keeps the compiler from dropping the decoded values
+    std::cout << "checksum " << checksum << std::endl;
+    if (!options.jsonFile.empty()) {
+        writeJson(options.jsonFile, options, results);
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Compact binary order stats log.
+// The file starts with a versioned BinaryStatsFileHeader followed by fixed size BinaryStatsRecord records.
+// BinaryStatsFileWriterCallback preallocates the file and maps it into memory, so writing a record is
+// a 40 byte copy into the mapping (no formatting, no write syscall), the kernel writes the pages out
+// in the background and flush() only schedules an asynchronous msync. When the preallocated space runs out
+// the file is extended and remapped. The committed record count is stored in the header after every
+// record with release semantics, so a reader mapping a file that is still being written sees only
+// complete records.
+// MappedStatsFile maps an existing file read only and validates its header, it is used by
+// the StatsReader command line tool (tools/StatsReader.cpp) that computes latency percentiles,
+// per second throughput and reject ratio, and converts the file to the CSV format of
+// OrderStatsFileWriterCallback.
+
+#ifndef BINARY_STATS_FILE_H
+#define BINARY_STATS_FILE_H
+
+#include <string>
+#include <span>
+
+#include "OrderStatsCollector.h"
+
+namespace ordermanagement {
+
+constexpr char BINARY_STATS_MAGIC[8] = {'O', 'M', 'S', 'T', 'A', 'T', 'S', '\0'};
+constexpr uint32_t BINARY_STATS_VERSION = 1;
+
+struct BinaryStatsFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t recordCount;   // committed records, updated after every record
+    uint64_t createTimeNs;
+    uint8_t reserved[32];
+};
+static_assert(sizeof(BinaryStatsFileHeader) == 64, "header layout is part of the file format");
+
+struct BinaryStatsRecord {
+    uint64_t orderId;
+    uint64_t orderManagerReceiveTimeNs;
+    uint64_t requestSendTimeNs;
+    uint64_t responseReceivalTimeNs;
+    uint8_t responseType;
+    uint8_t reserved[7];
+};
+static_assert(sizeof(BinaryStatsRecord) == 40, "record layout is part of the file format");
+
+class BinaryStatsFileWriterCallback : public IOrderStatsCollectorCallBack {
+public:
+    // initialCapacity is the number of records the file is preallocated for
+    BinaryStatsFileWriterCallback(const std::string& filename, uint64_t initialCapacity = 1 << 20);
+    ~BinaryStatsFileWriterCallback();
+    void processOrderStatisticsInfo(OrderResponse && response,
+                                    const OrderStats& orderInfo) override;
+    void flush() override;
+
+private:
+    void map(uint64_t capacity);
+
+private:
+    int m_fd = -1;
+    void* m_mapping = nullptr;
+    size_t m_mappingSize = 0;
+    uint64_t m_capacity = 0;
+    uint64_t m_recordCount = 0;
+};
+
+class MappedStatsFile {
+public:
+    // Throws std::runtime_error if the file can't be mapped or it is not a valid stats file
+    explicit MappedStatsFile(const std::string& filename);
+    ~MappedStatsFile();
+    MappedStatsFile(const MappedStatsFile&) = delete;
+    MappedStatsFile& operator=(const MappedStatsFile&) = delete;
+
+    const BinaryStatsFileHeader& header() const { return *static_cast<const BinaryStatsFileHeader*>(m_mapping); }
+    std::span<const BinaryStatsRecord> records() const { return m_records; }
+
+private:
+    void* m_mapping = nullptr;
+    size_t m_mappingSize = 0;
+    std::span<const BinaryStatsRecord> m_records;
+};
+
+} // ordermanagement namespace
+
+#endif
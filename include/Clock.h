@@ -0,0 +1,62 @@
+// Low overhead clock behind getCurrentTimeNs().
+// On x86 CPUs with an invariant TSC (constant rate, doesn't stop in deep C states, checked through cpuid)
+// the time is computed from rdtsc: ns = nsBase + (tsc - tscBase) * multiplier, which costs a few ns instead of
+// a clock_gettime call. The conversion parameters are calibrated at the first use of the clock (a few ms
+// busy wait) against CLOCK_MONOTONIC for the TSC frequency and CLOCK_REALTIME for the wall clock anchor,
+// and published through a seqlock, so calibrateClock() can be called at any time (OrderManagement does it
+// every ClockCalibrationIntervalMs) to follow NTP adjustments of the wall clock without stalling readers.
+// Without a reliable TSC, or when rdtsc turns out to be slower than clock_gettime (e.g. it is emulated by
+// a hypervisor), every call goes to clock_gettime.
+// getMonotonicTicks() is the cheapest timestamp available (raw TSC), intended for measuring short intervals
+// on hot paths, tick differences are converted with ticksToNs(). Session logic and anything that
+// is compared with the time of day uses getCurrentTimeNs() (Utils.h).
+// IClock makes the time source injectable: SystemClock reads getCurrentTimeNs(), VirtualClock only moves
+// when it is advanced, which is what the discrete event simulation (Simulation.h) runs on.
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace ordermanagement {
+
+// Monotonic, only differences are meaningful
+uint64_t getMonotonicTicks();
+uint64_t ticksToNs(uint64_t ticks);
+// Re-anchors the TSC to CLOCK_REALTIME and refines its frequency, can be called from any thread
+void calibrateClock();
+// Whether the TSC fast path is used
+bool isTscClock();
+
+class IClock {
+public:
+    virtual ~IClock() = default;
+    // Wall clock time in ns since the epoch
+    virtual uint64_t nowNs() const = 0;
+};
+
+class SystemClock : public IClock {
+public:
+    uint64_t nowNs() const override;
+};
+
+class VirtualClock : public IClock {
+public:
+    explicit VirtualClock(uint64_t startTimeNs) : m_nowNs(startTimeNs) {}
+    uint64_t nowNs() const override { return m_nowNs.load(std::memory_order_acquire); }
+    // Time never goes backwards, earlier times are ignored
+    void advanceTo(uint64_t timeNs)
+    {
+        if (timeNs > m_nowNs.load(std::memory_order_relaxed)) {
+            m_nowNs.store(timeNs, std::memory_order_release);
+        }
+    }
+
+private:
+    std::atomic<uint64_t> m_nowNs;
+};
+
+} // ordermanagement namespace
+
+#endif
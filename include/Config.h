@@ -5,24 +5,76 @@
 // username/password parameter to login to the exchange.
 // I use simple paramName=paramValue format in the config, as I am not allowed
 // to use third party libraries to work with more widespread config file formats (e.g. XML).
-// I am also assuming that the time range covered by open/close times does not cross the midnight
-// in UTC timezone (i.e. trading can't open at 9pm today and close at 4am tomorrow,
-// however it can open at 9am today and close at 4pm today).
-// I understand that there are exchanges that trade 23 hours a day (e.g. CME), but for the sake of
-// simplicity I am doing this assumption.
+// Several trading sessions per day can be configured with the Sessions parameter
+// (e.g. Sessions=9:30:00am-4:00:00pm,6:00:00pm-5:00:00am), in which case Open/Close are not used.
+// A session whose close time is before its open time is an overnight session that closes
+// on the next day (in UTC timezone), sessions are assumed not to overlap.
 // Sample config file can be found in ordermanagement/config/config.txt file
+// A config file can have [Name] sections (one per venue of a VenueEngine, see VenueEngine.h), parameters of
+// a section override the ones at the top of the file, which are shared by all the sections.
 
 #ifndef CONFIG_H
 #define CONFIG_H
 
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
+#include <utility>
+
+#include "WaitStrategy.h"
 
 namespace ordermanagement {
+
+// How upstream requests reach the transmitter thread.
+// Locked - requests are applied to the orders queue under m_ordersQueueMutex by the calling thread.
+// Ring   - requests are published into a bounded lock free MPSC ring and applied by the transmitter thread.
+enum class IngressMode {
+    Locked = 0,
+    Ring = 1
+};
+
+// What to do with a request when the ingress ring is full.
+// Reject - reject the request straight away.
+// Block  - wait until the transmitter frees a slot in the ring.
+// Spill  - append the request to an unbounded (mutex protected) side queue.
+enum class OverflowPolicy {
+    Reject = 0,
+    Block = 1,
+    Spill = 2
+};
+
+// How the Rate/MonitorWindowSec limit is enforced, see ThrottleCoordinator.h
+enum class ThrottleMode {
+    SlidingWindow = 0,
+    Gcra = 1
+};
+
+// Response latency distribution of StressExchangeSimulator, see StressExchangeSimulator.h
+enum class LatencyModelType {
+    Fixed = 0,
+    LogNormal = 1,
+    Histogram = 2
+};
+
+// When the order journal is written to the disk, see OrderJournal.h
+// None        - by the kernel, whenever it writes dirty pages back (survives a crash of the process, not of the host).
+// Periodic    - msync every JournalSyncIntervalMs.
+// EveryRecord - msync of the record page before the append returns.
+enum class JournalSyncPolicy {
+    None = 0,
+    Periodic = 1,
+    EveryRecord = 2
+};
+
+struct TradingSession {
+    uint64_t openTimeOffsetFromDayStartNs;
+    uint64_t closeTimeOffsetFromDayStartNs;
+};
     
 struct Config {
-    explicit Config(const std::string& configFileName);
+    // section "" reads only the parameters at the top of the file
+    explicit Config(const std::string& configFileName, const std::string& section = "");
     void dumpConfig() const;
 
     uint64_t openTimeOffsetFromDayStartNs;
@@ -31,6 +83,87 @@ struct Config {
     uint32_t throttlingRate;
     std::string username;
     std::string password;
+
+    // Optional parameters, defaults are used if they are missing in the config file
+    IngressMode ingressMode = IngressMode::Locked;
+    uint32_t ingressRingSize = 65536;
+    OverflowPolicy ingressOverflowPolicy = OverflowPolicy::Spill;
+    // Number of preallocated order slots (and initial capacity of the orderId indexes)
+    uint32_t orderPoolSize = 65536;
+    // Number of shards, each with its own orders queue, indexes, ingress ring and transmitter thread.
+    // Orders are routed by symbolId, the Rate/MonitorWindowSec limit is shared by all of them.
+    // OrderPoolSize and IngressRingSize are per shard.
+    uint32_t shardCount = 1;
+    // Prices are kept as int32_t numbers of ticks internally, PriceDecimals is the number of decimals of
+    // the prices of all the symbols except the ones listed in SymbolPriceDecimals (e.g. 7:2,12:0), see PackedOrder.h
+    uint32_t priceDecimals = 4;
+    std::vector<std::pair<int32_t, uint32_t>> symbolPriceDecimals;
+    // Maximum number of orders waiting for exchange response (at least 1), the transmitters stop sending while it
+    // is reached
+    uint32_t inFlightTableSize = 65536;
+    ThrottleMode throttleMode = ThrottleMode::SlidingWindow;
+    // Gcra mode only, number of orders that can be sent back to back
+    uint32_t throttleBurst = 1;
+    // Additional per second limit applied on top of Rate/MonitorWindowSec, 0 means disabled
+    uint32_t ratePerSecond = 0;
+    // How idle threads wait for work or for a deadline, see WaitStrategy.h
+    WaitStrategyType waitStrategy = WaitStrategyType::Backoff;
+    uint32_t waitSpinIterations = 10000;
+    uint32_t waitYieldIterations = 100;
+    // Trading sessions from the Sessions parameter, if empty a single
+    // openTimeOffsetFromDayStartNs-closeTimeOffsetFromDayStartNs session is used
+    std::vector<TradingSession> sessions;
+    // Precision of the session timers (logon/logout and other scheduled actions)
+    uint64_t timerPrecisionNs = 1000;
+    // Send all orders the throttle permits at once with IExchangeSimulator::sendBatch
+    bool transmitBatching = false;
+    uint32_t maxTransmitBatchSize = 256;
+    // StatsBus subscriber queue parameters, see StatsBus.h. The delivery threads of the stats callbacks wake up and
+    // flush them every StatsFlushIntervalMs, with 0 every record wakes them up and every delivered batch is flushed.
+    uint32_t statsRingSize = 65536;
+    uint64_t statsFlushIntervalMs = 100;
+    OverflowPolicy statsOverflowPolicy = OverflowPolicy::Reject;
+    // default per client order event queue size and what happens to an event that doesn't fit, see OrderEvents.h
+    uint32_t orderEventQueueSize = 65536;
+    OverflowPolicy orderEventOverflowPolicy = OverflowPolicy::Spill;
+    // StressExchangeSimulator parameters, see StressExchangeSimulator.h
+    LatencyModelType exchangeLatencyModel = LatencyModelType::Fixed;
+    // fixed latency, or the median of the lognormal distribution
+    uint64_t exchangeLatencyNs = 50000;
+    double exchangeLatencySigma = 0.5;
+    // Histogram model only, binary stats file whose round trip latencies are replayed
+    std::string exchangeLatencyFile;
+    double exchangeRejectRatio = 0.0;
+    // exchange side limit of ExchangeRateLimit orders per ExchangeRateWindowMs, orders above it are rejected,
+    // 0 means no limit
+    uint32_t exchangeRateLimit = 0;
+    uint64_t exchangeRateWindowMs = 1000;
+    uint32_t exchangeResponseThreads = 2;
+    // SocketExchangeGateway parameters, see SocketExchangeGateway.h. Address of the exchange
+    // (tcp:127.0.0.1:9000 or unix:/tmp/exchange.sock), reconnect interval while the session is wanted,
+    // size of each preallocated send buffer and of the response read buffer in bytes
+    std::string exchangeAddress = "tcp:127.0.0.1:9000";
+    uint64_t gatewayReconnectIntervalMs = 1000;
+    uint32_t gatewaySendBufferSize = 65536;
+    uint32_t gatewayReadBufferSize = 65536;
+    // VenueEngine parameters, names of the venues (each with its own [Name] section) and the number of
+    // threads that run the transmitters of all their shards
+    std::vector<std::string> venues;
+    uint32_t transmitterThreads = 1;
+    // how often the TSC clock is re-anchored to the wall clock (see Clock.h), 0 disables recalibration
+    uint64_t clockCalibrationIntervalMs = 1000;
+    // Order journal for crash recovery, see OrderJournal.h. File of the journal (empty disables it, every venue
+    // needs its own, VenueEngine throws otherwise), number of records it is preallocated for (at least 8 per order
+    // OrderPoolSize, ShardCount and InFlightTableSize allow, it is rolled when half full), when it is synced to the
+    // disk and how often the live orders are snapshotted while running (0 disables it, the journal since the last
+    // roll is replayed then).
+    // Recovered in flight orders without a response JournalReconcileTimeoutMs after the first logon are rejected.
+    std::string journalFile;
+    uint64_t journalCapacity = 1 << 22;
+    JournalSyncPolicy journalSyncPolicy = JournalSyncPolicy::None;
+    uint64_t journalSyncIntervalMs = 100;
+    uint64_t journalSnapshotIntervalMs = 1000;
+    uint64_t journalReconcileTimeoutMs = 5000;
 };
 
 }
@@ -3,6 +3,10 @@
 // Dummy response for each order. IExchangeSimulator provides interface of an Exchange
 // and ExchangeResponseSimulator implements a mock exchange for testing purposes
 // Please note that I use dependency injection for this project components testing.
+// In simulation mode the simulator has no thread and doesn't print anything: every order is answered
+// responseLatencyNs after it was sent according to the injected virtual clock, when the simulation
+// driver calls respondDue(), and the responses are drawn from a generator with a fixed seed,
+// so a simulation run is reproducible.
 
 #ifndef EXCHANGE_SIMULATOR_H 
 #define EXCHANGE_SIMULATOR_H
@@ -11,8 +15,10 @@
 #include <queue>
 #include <string>
 #include <random>
+#include <span>
 
 #include "OrderManagement.h"
+#include "WaitStrategy.h"
 
 namespace ordermanagement {
 
@@ -22,6 +28,19 @@ class IExchangeSimulator {
 public:
     virtual ~IExchangeSimulator() = default;
     virtual void send(const OrderRequest& request) = 0;
+    // Exchanges that can take several orders in one go (one lock, one syscall etc.) should override it
+    virtual void sendBatch(std::span<const OrderRequest> requests)
+    {
+        for (const auto& request : requests) {
+            send(request);
+        }
+    }
+    // Cancel-replace of an order that the exchange has already accepted: request carries its orderId and the
+    // new price, quantity and side. Exchanges without such a message get it as an order with the same id.
+    virtual void sendReplace(const OrderRequest& request)
+    {
+        send(request);
+    }
     virtual void sendLogon(const Logon& logon) = 0;
     virtual void sendLogout(const Logout& logout) = 0;
 }; 
@@ -31,20 +50,40 @@ public:
 class ExchangeResponseSimulator : public IExchangeSimulator {
 public:
     ExchangeResponseSimulator(OrderManagement* manager);
+    // Simulation mode
+    ExchangeResponseSimulator(OrderManagement* manager, const IClock* simulationClock,
+                              uint64_t responseLatencyNs, uint32_t seed);
     ~ExchangeResponseSimulator();
     void sendLogon(const Logon& logon) override;
     void sendLogout(const Logout& logout) override;
     void send(const OrderRequest& request) override;
+    void sendBatch(std::span<const OrderRequest> requests) override;
+
+    // Simulation mode only, sends the responses that are due, returns the time the next one is due
+    // (WaitStrategy::NO_DEADLINE if no order is waiting for a response)
+    uint64_t respondDue();
 
 private:
+    struct PendingResponse {
+        uint64_t orderId;
+        uint64_t dueTimeNs;
+    };
+
+    void addRequest(const OrderRequest& request);
     void respond();
+    void respondTo(uint64_t orderId);
 private:
     OrderManagement* m_manager;
+    // simulation mode only
+    const IClock* m_simulationClock = nullptr;
+    const uint64_t m_responseLatencyNs = 0;
     std::mutex m_requestsLock;
-    std::queue<uint64_t> m_requests;
+    std::queue<PendingResponse> m_requests;
     std::atomic_bool m_loggedIn = false;
     std::atomic_bool m_terminated = false;
     std::unique_ptr<std::thread> m_respondThread;
+    // uses the same wait strategy type as the manager, send() notifies the response thread
+    WaitStrategy m_waitStrategy;
     
     std::random_device m_rd;
     std::mt19937 m_gen;
@@ -0,0 +1,148 @@
+// Flat open addressing hash map keyed by orderId.
+// All entries live in one contiguous array, collisions are resolved with linear probing
+// and erase uses backward shift deletion, so there are no tombstones and lookups stay short
+// even after millions of insert/erase cycles.
+// Unlike std::unordered_map it doesn't allocate a node per insert, the only allocation
+// happens when the table has to grow beyond its initial capacity (load factor above 1/2).
+// It is not thread safe, callers are responsible for the synchronisation.
+
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+#include "Utils.h"
+
+namespace ordermanagement {
+
+template <typename V>
+class FlatHashMap {
+public:
+    explicit FlatHashMap(size_t capacity)
+        : m_entries(roundUpToPowerOfTwo(capacity * 2))
+        , m_mask(m_entries.size() - 1)
+    {
+    }
+
+    // Returns nullptr if the key is not in the map
+    V* find(uint64_t key)
+    {
+        for (size_t i = hashOrderId(key) & m_mask; m_entries[i].used; i = (i + 1) & m_mask) {
+            if (m_entries[i].key == key) {
+                return &m_entries[i].value;
+            }
+        }
+        return nullptr;
+    }
+
+    // Inserts the value if the key is not in the map yet, otherwise keeps the existing value.
+    // Returns false if the key was already there.
+    bool emplace(uint64_t key, V value)
+    {
+        if ((m_size + 1) * 2 > m_entries.size()) {
+            grow();
+        }
+        size_t i = hashOrderId(key) & m_mask;
+        for (; m_entries[i].used; i = (i + 1) & m_mask) {
+            if (m_entries[i].key == key) {
+                return false;
+            }
+        }
+        m_entries[i].key = key;
+        m_entries[i].value = std::move(value);
+        m_entries[i].used = true;
+        ++m_size;
+        return true;
+    }
+
+    bool erase(uint64_t key)
+    {
+        size_t i = hashOrderId(key) & m_mask;
+        for (; m_entries[i].used; i = (i + 1) & m_mask) {
+            if (m_entries[i].key == key) {
+                break;
+            }
+        }
+        if (!m_entries[i].used) {
+            return false;
+        }
+        // Backward shift: move the following entries of the probe chain into the hole
+        // unless their home bucket lies cyclically in (hole, current]
+        size_t hole = i;
+        for (size_t j = (i + 1) & m_mask; m_entries[j].used; j = (j + 1) & m_mask) {
+            const size_t home = hashOrderId(m_entries[j].key) & m_mask;
+            const bool homeBetween = hole <= j ? (hole < home && home <= j)
+                                               : (hole < home || home <= j);
+            if (!homeBetween) {
+                m_entries[hole] = std::move(m_entries[j]);
+                hole = j;
+            }
+        }
+        m_entries[hole].used = false;
+        --m_size;
+        return true;
+    }
+
+    void clear()
+    {
+        for (auto& entry : m_entries) {
+            entry.used = false;
+        }
+        m_size = 0;
+    }
+
+    // Calls function(key, value) for every entry, in no particular order
+    template <typename Function>
+    void forEach(Function&& function) const
+    {
+        for (const auto& entry : m_entries) {
+            if (entry.used) {
+                function(entry.key, entry.value);
+            }
+        }
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+private:
+    struct Entry {
+        uint64_t key = 0;
+        V value{};
+        bool used = false;
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 16;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    void grow()
+    {
+        std::vector<Entry> oldEntries(m_entries.size() * 2);
+        oldEntries.swap(m_entries);
+        m_mask = m_entries.size() - 1;
+        m_size = 0;
+        for (auto& entry : oldEntries) {
+            if (entry.used) {
+                emplace(entry.key, std::move(entry.value));
+            }
+        }
+    }
+
+private:
+    std::vector<Entry> m_entries;
+    size_t m_mask;
+    size_t m_size = 0;
+};
+
+} // ordermanagement namespace
+
+#endif
@@ -0,0 +1,99 @@
+// Table of orders that have been sent to the exchange and wait for their response.
+// Any number of writers (the transmitters of all the shards insert orders right before sending them) and
+// response threads that complete them work on it concurrently, without any lock:
+// it is an open addressing table with linear probing where every entry has an atomic state
+// (Empty/Free -> Reserved -> InFlight -> Completing -> Free). A writer claims an Empty or Free entry with one
+// CAS (Reserved) and publishes it as InFlight once the order is written, a response claims its entry with one CAS,
+// copies the stats out and marks the entry Free, so it can be reused for new orders. Entries never go back
+// to Empty, so probe chains are never broken, and lookups stop after the longest probe distance any writer
+// has ever used (raised with a CAS loop), so unknown order ids are rejected quickly even when the table has no
+// Empty entries. The maxOrdersInFlight limit is a slot count that writers reserve before they probe, a
+// transmitter reserves the slots of the orders it is about to send before it takes send credits for them, so
+// the insert of a sent order always succeeds and a full table never holds a transmitter up.
+// A response for an unknown order id or a duplicate response simply finds no InFlight entry.
+// An order that gets modified while it is in flight is marked Amended (InFlight with an amend waiting for its
+// response, see OrderManagement), complete() reports the mark, so responses of orders that weren't modified
+// never have to look for an amend. Entries also remember whether the order went out as a cancel-replace, so that
+// the response of a Replace can be told from the one of a New order.
+// The table is sized to twice the configured maximum number of orders in flight to keep the probes short.
+
+#ifndef IN_FLIGHT_TABLE_H
+#define IN_FLIGHT_TABLE_H
+
+#include <atomic>
+#include <memory>
+
+#include "Utils.h"
+
+namespace ordermanagement {
+
+class InFlightTable {
+public:
+    // Throws std::runtime_error if maxOrdersInFlight is 0
+    explicit InFlightTable(uint32_t maxOrdersInFlight);
+
+    // Any thread. Reserves up to count slots for orders about to be inserted, returns the number of slots
+    // reserved, 0 if maxOrdersInFlight orders are already in flight (or reserved).
+    uint32_t reserve(uint32_t count);
+    // Any thread. Gives back reserved slots that won't be used.
+    void unreserve(uint32_t count) { m_size.fetch_sub(count, std::memory_order_relaxed); }
+    // Any thread. Inserts the order into a slot reserved before, which always finds an entry.
+    // replace is set for the cancel-replace of an order the exchange has already accepted.
+    void insertReserved(uint64_t orderId, const OrderStats& stats, ClientId clientId, bool replace);
+    // Any thread. Returns false if maxOrdersInFlight orders are already in flight.
+    bool insert(uint64_t orderId, const OrderStats& stats, ClientId clientId, bool replace)
+    {
+        if (reserve(1) == 0) {
+            return false;
+        }
+        insertReserved(orderId, stats, clientId, replace);
+        return true;
+    }
+    // Any thread. Removes the order from the table and copies its stats (responseReceivalTimeNs is 0) and
+    // client out, returns false if the order is not in flight (unknown order id or duplicate response).
+    // amended is set if markAmended() was called for the order, replace if it was inserted as a replace.
+    bool complete(uint64_t orderId, OrderStats& stats, ClientId& clientId, bool& amended, bool& replace);
+    // Any thread. Returns false if the order is not in flight.
+    bool markAmended(uint64_t orderId);
+
+    size_t size() const { return m_size.load(std::memory_order_relaxed); }
+    bool full() const { return size() >= m_maxOrdersInFlight; }
+
+private:
+    enum State : uint32_t {
+        Empty = 0,
+        InFlight = 1,
+        Completing = 2,
+        Free = 3,
+        // in flight with a pending amend
+        Amended = 4,
+        // claimed by a writer that is writing its order into it
+        Reserved = 5
+    };
+
+    // half a cache line, the response time isn't known while the order is in flight
+    struct alignas(32) Entry {
+        std::atomic<uint64_t> orderId{0};
+        std::atomic<uint32_t> state{Empty};
+        ClientId clientId = NO_CLIENT;
+        bool replace = false;
+        uint64_t orderManagerReceiveTimeNs = 0;
+        uint64_t requestSendTimeNs = 0;
+    };
+    static_assert(sizeof(Entry) == 32, "InFlightTable entry must stay half a cache line");
+
+    // Claims the InFlight/Amended entry of the order (state Completing), previousState gets its state before.
+    // Returns nullptr if the order is not in flight.
+    Entry* claim(uint64_t orderId, uint32_t& previousState);
+
+private:
+    const uint32_t m_maxOrdersInFlight;
+    size_t m_mask;
+    std::unique_ptr<Entry[]> m_entries;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_maxProbe = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_size = 0;
+};
+
+} // ordermanagement namespace
+
+#endif
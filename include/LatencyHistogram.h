@@ -0,0 +1,64 @@
+// Log-linear (HDR style) latency histogram.
+// Values are grouped by their highest set bit and every power of two range is split into SUB_BUCKETS
+// linear sub buckets, so the relative error of any recorded value is below 1/SUB_BUCKETS (~3%)
+// over the whole range, while the histogram has a fixed number of buckets (no allocation when recording).
+// Values up to MAX_VALUE (~18 minutes in ns) are tracked, larger ones are counted in the last bucket.
+// LatencyHistogram itself is single threaded, it is what snapshots are merged into, the
+// concurrent recording side lives in LatencyStatsCollector.h and only uses bucketIndex().
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <bit>
+
+namespace ordermanagement {
+
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAX_VALUE_BITS = 40;
+    static constexpr uint64_t MAX_VALUE = (1ull << MAX_VALUE_BITS) - 1;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+    static size_t bucketIndex(uint64_t value)
+    {
+        if (value > MAX_VALUE) {
+            value = MAX_VALUE;
+        }
+        if (value < SUB_BUCKETS) {
+            return value;
+        }
+        const uint32_t shift = std::bit_width(value) - 1 - SUB_BUCKET_BITS;
+        return SUB_BUCKETS * shift + (value >> shift);
+    }
+    // Lowest value that falls into the bucket
+    static uint64_t bucketLowestValue(size_t index);
+    // Number of distinct values that fall into the bucket
+    static uint64_t bucketWidth(size_t index);
+
+    LatencyHistogram();
+
+    void record(uint64_t value, uint64_t count = 1);
+    void addToBucket(size_t index, uint64_t count) { m_counts[index] += count; m_totalCount += count; }
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t totalCount() const { return m_totalCount; }
+    uint64_t bucketCount(size_t index) const { return m_counts[index]; }
+    // Middle of the bucket containing the value at the given percentile (0..100), 0 if empty
+    uint64_t valueAtPercentile(double percentile) const;
+    uint64_t maxValue() const;
+    double mean() const;
+
+private:
+    std::vector<uint64_t> m_counts;
+    uint64_t m_totalCount = 0;
+};
+
+} // ordermanagement namespace
+
+#endif
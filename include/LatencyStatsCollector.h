@@ -0,0 +1,101 @@
+// In process latency aggregation.
+// LatencyStatsCollectorCallback records the queue wait (requestSendTimeNs - orderManagerReceiveTimeNs)
+// and round trip (responseReceivalTimeNs - requestSendTimeNs) of every order into log-linear histograms
+// (LatencyHistogram.h), split by ResponseType. Recording is a couple of relaxed increments:
+// every thread that reports stats gets its own set of histograms (looked up through a thread local
+// cache), so recording threads never share a cache line and nothing is locked on the recording path.
+// Besides the session histograms (everything since the collector was created) every thread keeps
+// one histogram set per second for the last minute in a ring indexed by the response receival second,
+// which gives the rolling LastSecond (previous complete second) and LastMinute (previous 60 complete
+// seconds) windows. snapshot() merges the histograms of all threads while they keep recording,
+// a per second slot that is being recycled while it is read is detected through its second tag
+// (seqlock style) and skipped.
+
+#ifndef LATENCY_STATS_COLLECTOR_H
+#define LATENCY_STATS_COLLECTOR_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "OrderStatsCollector.h"
+#include "LatencyHistogram.h"
+
+namespace ordermanagement {
+
+enum class StatsWindow {
+    LastSecond,
+    LastMinute,
+    Session
+};
+
+struct LatencySnapshot {
+    static constexpr size_t RESPONSE_TYPES = 3;
+    // indexed by ResponseType
+    std::array<LatencyHistogram, RESPONSE_TYPES> queueWait;
+    std::array<LatencyHistogram, RESPONSE_TYPES> roundTrip;
+
+    const LatencyHistogram& queueWaitFor(ResponseType type) const { return queueWait[static_cast<size_t>(type)]; }
+    const LatencyHistogram& roundTripFor(ResponseType type) const { return roundTrip[static_cast<size_t>(type)]; }
+};
+
+class LatencyStatsCollectorCallback : public IOrderStatsCollectorCallBack {
+public:
+    LatencyStatsCollectorCallback();
+    void processOrderStatisticsInfo(OrderResponse && response,
+                                    const OrderStats& orderInfo) override;
+
+    // Can be called from any thread while orders are being recorded
+    LatencySnapshot snapshot(StatsWindow window) const { return snapshot(window, getCurrentTimeNs()); }
+    LatencySnapshot snapshot(StatsWindow window, uint64_t currentTimeNs) const;
+    // Prints count, p50, p99, p99.9 and max of every non empty histogram of the window
+    void printSummary(std::ostream& out, StatsWindow window) const;
+
+private:
+    static constexpr size_t HISTOGRAMS = 2 * LatencySnapshot::RESPONSE_TYPES;
+    static constexpr size_t WINDOW_SECONDS = 60;
+    // the current, incomplete second has its own slot too
+    static constexpr size_t SECOND_SLOTS = WINDOW_SECONDS + 1;
+
+    template <typename Count>
+    struct Buckets {
+        Buckets() : counts(std::make_unique<std::atomic<Count>[]>(HISTOGRAMS * LatencyHistogram::BUCKET_COUNT)) {}
+        // single writer, so a relaxed load and store is enough
+        void increment(size_t index)
+        {
+            counts[index].store(counts[index].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        std::unique_ptr<std::atomic<Count>[]> counts;
+    };
+
+    struct SecondSlot {
+        static constexpr uint64_t RECYCLING = UINT64_MAX;
+        std::atomic<uint64_t> second = RECYCLING;
+        Buckets<uint32_t> buckets;
+    };
+
+    struct Recorder {
+        explicit Recorder(std::thread::id owner) : owner(owner) {}
+        const std::thread::id owner;
+        Buckets<uint64_t> session;
+        std::array<SecondSlot, SECOND_SLOTS> seconds;
+    };
+
+    Recorder& localRecorder();
+    static void recycle(SecondSlot& slot, uint64_t second);
+    template <typename Count>
+    static void addTo(LatencySnapshot& snapshot, const Count* counts);
+
+private:
+    const uint64_t m_id;
+    mutable std::mutex m_recordersMutex;
+    std::vector<std::unique_ptr<Recorder>> m_recorders;
+};
+
+} // ordermanagement namespace
+
+#endif
@@ -0,0 +1,214 @@
+// Low latency asynchronous logger for the hot paths.
+// OM_LOG_INFO("Order {} was rejected: {}", orderId, reason) doesn't format anything on the calling thread:
+// the format string is registered once per call site (a function local static holds its id) and the call
+// copies the format id, a timestamp and the raw argument values (integers, doubles, chars and strings,
+// strings are copied and truncated to what fits) into a fixed size record of a per thread single producer
+// ring, so logging is a few stores without locks, allocations or syscalls. A background thread drains
+// the rings every few milliseconds, replaces the {} placeholders with the arguments and writes Debug/Info
+// lines to std::cout and Warning/Error lines to std::cerr.
+// When the ring of a thread is full the record is dropped rather than blocking the caller, the formatter
+// reports the number of dropped records.
+// Levels below OM_LOG_LEVEL (compile time, Info by default, e.g. -DOM_LOG_LEVEL=0 enables Debug) are
+// compiled out, the rest can be switched off at runtime with Logger::setLevel().
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <deque>
+
+#include "Utils.h"
+#include "WaitStrategy.h"
+
+#ifndef OM_LOG_LEVEL
+#define OM_LOG_LEVEL 1
+#endif
+
+#define OM_LOG(level, format, ...)                                                                          \
+    do {                                                                                                    \
+        if constexpr (static_cast<int>(level) >= OM_LOG_LEVEL) {                                           \
+            if (::ordermanagement::Logger::isEnabled(level)) {                                             \
+                static const uint32_t omLogFormatId = ::ordermanagement::Logger::registerFormat(level, format); \
+                ::ordermanagement::Logger::log(omLogFormatId __VA_OPT__(,) __VA_ARGS__);                   \
+            }                                                                                               \
+        }                                                                                                   \
+    } while (false)
+
+#define OM_LOG_DEBUG(format, ...) OM_LOG(::ordermanagement::LogLevel::Debug, format __VA_OPT__(,) __VA_ARGS__)
+#define OM_LOG_INFO(format, ...) OM_LOG(::ordermanagement::LogLevel::Info, format __VA_OPT__(,) __VA_ARGS__)
+#define OM_LOG_WARNING(format, ...) OM_LOG(::ordermanagement::LogLevel::Warning, format __VA_OPT__(,) __VA_ARGS__)
+#define OM_LOG_ERROR(format, ...) OM_LOG(::ordermanagement::LogLevel::Error, format __VA_OPT__(,) __VA_ARGS__)
+
+namespace ordermanagement {
+
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warning = 2,
+    Error = 3,
+    Off = 4
+};
+
+enum class LogArgType : uint8_t {
+    Int,
+    UInt,
+    Double,
+    Char,
+    String
+};
+
+struct LogRecord {
+    static constexpr size_t PAYLOAD_SIZE = 112;
+
+    uint64_t timestampNs;
+    uint32_t formatId;
+    uint16_t size;          // used bytes of payload
+    uint8_t argCount;
+    uint8_t reserved;
+    // every argument is a LogArgType byte followed by its value,
+    // strings are stored as a length byte followed by the characters
+    uint8_t payload[PAYLOAD_SIZE];
+};
+static_assert(sizeof(LogRecord) == 128, "log records should stay two cache lines long");
+
+class Logger {
+public:
+    static constexpr size_t THREAD_RING_SIZE = 4096;
+    static constexpr uint64_t DRAIN_INTERVAL_NS = 10000000; // 10 millis
+
+    static Logger& instance();
+
+    static bool isEnabled(LogLevel level) { return level >= s_level.load(std::memory_order_relaxed); }
+    static void setLevel(LogLevel level) { s_level.store(level, std::memory_order_relaxed); }
+    // Called once per call site by the OM_LOG macros, returns the id the records refer to
+    static uint32_t registerFormat(LogLevel level, const char* format);
+
+    template <typename... Args>
+    static void log(uint32_t formatId, const Args&... args);
+
+    // Blocks until everything logged before the call has been written out
+    static void flush();
+
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+private:
+    // Single producer/single consumer ring of one logging thread
+    struct ThreadLog {
+        ThreadLog() : records(std::make_unique<LogRecord[]>(THREAD_RING_SIZE)) {}
+
+        std::unique_ptr<LogRecord[]> records;
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head = 0;    // written by the logging thread
+        uint64_t cachedTail = 0;
+        std::atomic<uint64_t> dropped = 0;
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail = 0;    // written by the formatter
+        uint64_t reportedDropped = 0;
+        // set when the thread exits, the formatter forgets the log once it is drained
+        std::atomic_bool retired = false;
+    };
+
+    struct LogFormat {
+        LogLevel level;
+        std::string format;
+    };
+
+    Logger();
+    static ThreadLog& threadLog();
+    static LogRecord* claim(ThreadLog& log);
+    static void publish(ThreadLog& log) { log.head.store(log.head.load(std::memory_order_relaxed) + 1,
+                                                         std::memory_order_release); }
+
+    template <typename T>
+    static void encode(LogRecord& record, const T& arg);
+    static void encodeString(LogRecord& record, std::string_view arg);
+
+    void formatRecords();
+    void drain();
+    void formatRecord(const LogRecord& record, std::string& infoOutput, std::string& errorOutput);
+
+private:
+    static inline std::atomic<LogLevel> s_level = LogLevel::Debug;
+
+    std::mutex m_formatsMutex;
+    std::deque<LogFormat> m_formats;
+    // formatter thread's copy of m_formats
+    std::vector<LogFormat> m_knownFormats;
+
+    std::mutex m_threadLogsMutex;
+    std::vector<std::shared_ptr<ThreadLog>> m_threadLogs;
+
+    std::atomic<uint64_t> m_flushRequests = 0;
+    std::atomic<uint64_t> m_flushedRequests = 0;
+
+    WaitStrategy m_waitStrategy;
+    std::atomic_bool m_terminate = false;
+    std::unique_ptr<std::thread> m_formatterThread;
+};
+
+template <typename T>
+void Logger::encode(LogRecord& record, const T& arg)
+{
+    using Type = std::decay_t<T>;
+    if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        encodeString(record, arg);
+        return;
+    } else {
+        LogArgType type;
+        uint64_t value;
+        if constexpr (std::is_same_v<Type, char>) {
+            type = LogArgType::Char;
+            value = static_cast<unsigned char>(arg);
+        } else if constexpr (std::is_floating_point_v<Type>) {
+            type = LogArgType::Double;
+            const double doubleValue = arg;
+            std::memcpy(&value, &doubleValue, sizeof(value));
+        } else if constexpr (std::is_enum_v<Type>) {
+            type = LogArgType::Int;
+            value = static_cast<uint64_t>(static_cast<int64_t>(arg));
+        } else if constexpr (std::is_signed_v<Type>) {
+            type = LogArgType::Int;
+            value = static_cast<uint64_t>(static_cast<int64_t>(arg));
+        } else {
+            static_assert(std::is_unsigned_v<Type>, "unsupported log argument type");
+            type = LogArgType::UInt;
+            value = arg;
+        }
+        if (record.size + 1 + sizeof(value) > LogRecord::PAYLOAD_SIZE) {
+            return;
+        }
+        record.payload[record.size] = static_cast<uint8_t>(type);
+        std::memcpy(record.payload + record.size + 1, &value, sizeof(value));
+        record.size += 1 + sizeof(value);
+        ++record.argCount;
+    }
+}
+
+template <typename... Args>
+void Logger::log(uint32_t formatId, const Args&... args)
+{
+    ThreadLog& log = threadLog();
+    LogRecord* record = claim(log);
+    if (record == nullptr) {
+        log.dropped.store(log.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    record->timestampNs = getCurrentTimeNs();
+    record->formatId = formatId;
+    record->size = 0;
+    record->argCount = 0;
+    (encode(*record, args), ...);
+    publish(log);
+}
+
+} // ordermanagement namespace
+
+#endif
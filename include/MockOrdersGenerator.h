@@ -8,10 +8,15 @@
 // (clientPrefix digit it receives in its constructor), so that we can easily distinguish
 // between orders from different generators (OrderIds of MockOrdersGenerator1 will start with 1,
 // OrderIds generated by MockOrdersGenerator2 will start with digit 2 etc.).
+// The pause between requests (100ms by default) and the console output can be configured, the requests
+// are sent on a fixed schedule (open loop), so a slow onData() doesn't lower the offered rate.
+// In simulation mode the generator has no thread and doesn't print anything, the simulation driver
+// calls sendNextRequest() and schedules the next call after the returned pause on its virtual clock.
 
 #ifndef MOCK_ORDERS_GENERATOR_H
 #define MOCK_ORDERS_GENERATOR_H
 
+#include <atomic>
 #include <thread>
 #include <vector>
 #include <functional>
@@ -25,8 +30,20 @@ class OrderManagement;
 class MockOrdersGenerator {
 public:
     MockOrdersGenerator(OrderManagement* orderManager, uint8_t clientPrefix);
+    // Simulation mode
+    MockOrdersGenerator(OrderManagement* orderManager, uint8_t clientPrefix, bool simulation);
+    static constexpr uint64_t DEFAULT_REQUEST_PAUSE_NS = 100000000;
+
+    // Sends a request every requestPauseNs, prints every request only if verbose is true,
+    // order events go to clientId (see OrderEvents.h)
+    MockOrdersGenerator(OrderManagement* orderManager, uint8_t clientPrefix, uint64_t requestPauseNs, bool verbose,
+                        ClientId clientId = NO_CLIENT);
     ~MockOrdersGenerator();
 
+    // Sends one request (new, or the cancel/modify that precedes some of them),
+    // returns the pause in ns before the next one
+    uint64_t sendNextRequest();
+
 private:    
     void generateOrders();
     uint64_t getNextSeqNumber();
@@ -34,8 +51,14 @@ private:
 private:
     OrderManagement* m_orderManager;
     uint8_t  m_clientPrefix;
-    uint8_t  m_terminate;
+    std::atomic_bool m_terminate;
     uint64_t m_orderSeqNum;
+    uint64_t m_requestPauseNs = DEFAULT_REQUEST_PAUSE_NS;
+    bool m_verbose = true;
+    ClientId m_clientId = NO_CLIENT;
+    // the new order that goes out after the cancel/modify request that has just been sent
+    bool m_newOrderPending = false;
+    uint64_t m_pendingOrderId = 0;
     std::unique_ptr<std::thread> m_generatorThread;
 };
 
@@ -0,0 +1,155 @@
+// Bounded lock free multi producer/single consumer ring buffer.
+// The implementation follows the well known Dmitry Vyukov bounded queue design:
+// every cell carries a sequence number, producers claim a cell by advancing the shared
+// enqueue position with a single CAS and publish it by bumping the cell sequence,
+// so a push is a couple of atomic operations and never takes a lock or allocates.
+// As there is only one consumer, the dequeue position is a plain (non atomic) counter
+// owned by the consumer thread.
+// tryPushBatch() claims a run of consecutive cells with one CAS, so a basket of items costs one
+// reservation instead of one per item.
+// Capacity is rounded up to the next power of two so that index wrapping is a simple mask.
+
+#ifndef MPSC_RING_BUFFER_H
+#define MPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <utility>
+
+#include "Utils.h"
+
+namespace ordermanagement {
+
+template <typename T>
+class MpscRingBuffer {
+public:
+    explicit MpscRingBuffer(size_t capacity)
+        : m_capacity(roundUpToPowerOfTwo(capacity))
+        , m_mask(m_capacity - 1)
+        , m_cells(std::make_unique<Cell[]>(m_capacity))
+    {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+    // Can be called by any number of threads.
+    // Returns false (and leaves item untouched) if the ring is full.
+    template <typename U>
+    bool tryPush(U&& item)
+    {
+        Cell* cell;
+        uint64_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            const uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::forward<U>(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Can be called by any number of threads.
+    // Pushes all the items into consecutive cells, or nothing (returns false) if they don't all fit.
+    bool tryPushBatch(std::span<const T> items)
+    {
+        const uint64_t count = items.size();
+        if (count == 0) {
+            return true;
+        }
+        if (count > m_capacity) {
+            return false;
+        }
+        uint64_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            const uint64_t seq = m_cells[pos & m_mask].sequence.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                // the consumer frees cells in order, so all of them are free if the last one is
+                const uint64_t lastPos = pos + count - 1;
+                const uint64_t lastSeq = m_cells[lastPos & m_mask].sequence.load(std::memory_order_acquire);
+                if (static_cast<int64_t>(lastSeq) - static_cast<int64_t>(lastPos) < 0) {
+                    return false;
+                }
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            Cell& cell = m_cells[(pos + i) & m_mask];
+            cell.data = items[i];
+            cell.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return true;
+    }
+
+    // Must only be called by the consumer thread.
+    bool tryPop(T& item)
+    {
+        Cell& cell = m_cells[m_dequeuePos & m_mask];
+        if (cell.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) {
+            return false;
+        }
+        item = std::move(cell.data);
+        cell.sequence.store(m_dequeuePos + m_capacity, std::memory_order_release);
+        ++m_dequeuePos;
+        return true;
+    }
+
+    // Must only be called by the consumer thread.
+    // Returns true only if there are no claimed cells left, including the ones
+    // a producer has claimed but not published yet.
+    bool empty() const
+    {
+        return m_enqueuePos.load(std::memory_order_acquire) == m_dequeuePos;
+    }
+
+    size_t capacity() const { return m_capacity; }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Cell {
+        std::atomic<uint64_t> sequence;
+        T data;
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+private:
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_enqueuePos = 0;
+    alignas(CACHE_LINE_SIZE) uint64_t m_dequeuePos = 0;
+};
+
+} // ordermanagement namespace
+
+#endif
@@ -0,0 +1,139 @@
+// Order lifecycle notifications for the clients (strategies) that submit orders.
+// A client registers with OrderManagement::getOrderEvents() and passes the returned ClientId to onData(),
+// from then on it gets an OrderEvent for every step of its orders: Queued, Modified, Cancelled
+// (while still in the queue), Sent, Accepted/Rejected by the exchange, AmendRejected when the cancel-replace of a
+// live order fails (the order itself stays), and Rejected by OrderManagement
+// itself with a RejectCode (exchange closed, ingress queue full, closed while queued, too late to
+// modify/cancel...), instead of the reject only ending up in the log.
+// Every client has its own bounded lock free queue of POD events (SubscriberQueue.h), publishing an event is a
+// copy into that queue, so neither the transmitter nor a mass reject of the whole queue at close waits for a
+// client or allocates. A client either gives an IOrderEventListener, which is called with batches of events
+// on a delivery thread of its own (idling with the configured WaitStrategy, so it reacts within
+// microseconds), or polls its queue in batches into its own buffer with poll().
+// OrderEventOverflowPolicy decides what happens to an event that doesn't fit into the queue of a client: Spill
+// (the default) keeps it in an unbounded side queue, so no event is lost, terminal Rejected events of a mass reject
+// included, Block waits until the client has made room and Reject drops it for that client (and counts it).
+// Clients stay registered for the lifetime of the dispatcher.
+
+#ifndef ORDER_EVENTS_H
+#define ORDER_EVENTS_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+
+#include "Utils.h"
+#include "SubscriberQueue.h"
+#include "Config.h"
+
+namespace ordermanagement {
+
+enum class OrderEventType : uint8_t {
+    Queued = 0,
+    Modified = 1,
+    Cancelled = 2,
+    Sent = 3,
+    Accepted = 4,
+    Rejected = 5,
+    // the amend (cancel-replace) of a live order failed, the order stays with its previous values
+    AmendRejected = 6
+};
+
+enum class RejectCode : uint8_t {
+    None = 0,
+    ExchangeClosed = 1,             // the request arrived while the exchange was closed
+    UnknownRequestType = 2,
+    IngressQueueFull = 3,           // IngressOverflowPolicy=Reject and the ingress ring was full
+    ClosedWhileQueued = 4,          // the exchange closed while the order was waiting in the queue
+    Terminated = 5,                 // OrderManagement was shut down while the order was queued
+    TooLateToModify = 6,            // the order is neither queued nor waiting for its exchange response
+    TooLateToCancel = 7,            // the order had already been sent, the cancel is rejected
+    ExchangeReject = 8,             // the exchange responded with Reject
+    UnknownExchangeResponse = 9,
+    UnknownVenue = 10,              // VenueEngine has no venue with the VenueId of the request
+    InvalidOrder = 11,              // price, quantity or side can't be represented internally, see PackedOrder.h
+    SymbolChanged = 12,             // a Modify can't move the order to another symbol (and shard)
+    Unreconciled = 13,              // recovered in flight from the journal, no response after the logon
+    JournalFull = 14                // the journal only has room left for the orders it holds, see OrderJournal.h
+};
+
+const char* rejectCodeText(RejectCode code);
+
+struct OrderEvent {
+    uint64_t orderId;
+    uint64_t timeNs;
+    OrderEventType type;
+    RejectCode rejectCode;          // Rejected events only
+};
+
+class IOrderEventListener {
+public:
+    virtual ~IOrderEventListener() = default;
+    // Called on the delivery thread of the client with events in the order they were published
+    virtual void onOrderEvents(std::span<const OrderEvent> events) = 0;
+};
+
+struct ClientStats {
+    uint64_t published = 0;    // events offered to the client
+    uint64_t delivered = 0;    // events passed to the listener or returned by poll()
+    uint64_t dropped = 0;      // events dropped because the client queue was full (Reject policy)
+};
+
+class OrderEventDispatcher {
+public:
+    static constexpr size_t MAX_CLIENTS = 64;
+    static constexpr size_t DELIVERY_BATCH_SIZE = 256;
+
+    // Uses OrderEventQueueSize (default client queue size), OrderEventOverflowPolicy and the WaitStrategy config
+    // parameters
+    explicit OrderEventDispatcher(const Config& config);
+    // Delivers what is still queued to the listeners and stops the delivery threads
+    ~OrderEventDispatcher();
+
+    // The listener is called on a delivery thread owned by the client. queueSize 0 means OrderEventQueueSize.
+    // Returns NO_CLIENT if MAX_CLIENTS are already registered.
+    ClientId registerClient(std::unique_ptr<IOrderEventListener> listener, size_t queueSize = 0);
+    // The client reads its events with poll()
+    ClientId registerPollingClient(size_t queueSize = 0);
+
+    // Any thread, never blocks unless OrderEventOverflowPolicy is Block. Events of NO_CLIENT (and of unknown
+    // clients) are ignored.
+    void publish(ClientId clientId, const OrderEvent& event)
+    {
+        if (clientId != NO_CLIENT) {
+            publishToClient(clientId, event);
+        }
+    }
+
+    // Polling clients only, one polling thread per client. Fills events from the front, returns the count.
+    size_t poll(ClientId clientId, std::span<OrderEvent> events);
+
+    ClientStats getClientStats(ClientId clientId) const;
+
+private:
+    struct Client {
+        Client(std::unique_ptr<IOrderEventListener> listener, size_t queueSize, const Config& config);
+        std::unique_ptr<IOrderEventListener> listener;
+        SubscriberQueue<OrderEvent> events;
+    };
+
+    ClientId addClient(std::unique_ptr<IOrderEventListener> listener, size_t queueSize);
+    Client* findClient(ClientId clientId) const;
+    void publishToClient(ClientId clientId, const OrderEvent& event);
+
+private:
+    // only the queue size, the overflow policy and the wait strategy parameters are used
+    const Config m_config;
+    // slot i holds client i + 1
+    std::array<std::atomic<Client*>, MAX_CLIENTS> m_clients{};
+    // serializes registrations, the owning pointers are only touched under it
+    std::mutex m_clientsMutex;
+    std::array<std::unique_ptr<Client>, MAX_CLIENTS> m_ownedClients;
+};
+
+} // ordermanagement namespace
+
+#endif
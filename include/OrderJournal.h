@@ -0,0 +1,235 @@
+// Append only, memory mapped journal of order lifecycle events, so that the orders of a session survive a crash
+// and a restart resumes them instead of starting cold.
+// OrderManagement appends a 32 byte JournalRecord whenever it changes the state of an order: received into the
+// queue, modified (in the queue or as the pending amend of an in flight order), cancelled, sent, responded and
+// rejected out of the queue. The file is preallocated (sparse) for JournalCapacity records and mapped, an append
+// is an atomic slot reservation and a 32 byte copy into the mapping, the event byte is stored last with release
+// semantics, so a record is complete once its event isn't None.
+// The last records of the journal are reserved for the orders it already holds: Received and Modified records
+// (tryAppend) are refused once only the reserve is left, OrderManagement rejects those requests with
+// RejectCode::JournalFull, while the Sent, Responded, Cancelled and Rejected records of the orders that are in
+// (append) always fit. The reserve is RECORDS_PER_LIVE_ORDER records for every order OrderManagement can hold
+// (queued in any shard or in flight), enough to end the lifecycle of all of them without another Modified record.
+// Durability follows JournalSyncPolicy: None leaves the writing to the kernel (the records survive a crash of
+// the process, not of the host), Periodic msyncs every JournalSyncIntervalMs and EveryRecord msyncs the page of
+// every record before the append returns.
+// JournalReplay is the state machine that turns the records back into the live orders: the queued ones (in queue
+// order), the ones in flight and their pending amends. At startup OrderManagement loads the snapshot of the
+// journal (<JournalFile>.snapshot), replays the records that follow it and rebuilds its queues, in flight table
+// and pending amends from the result. Then it rolls the journal: the recovered orders are written to a snapshot
+// of a new, empty journal. While running, the same replay follows the journal on the session timer thread and
+// snapshots the live orders every JournalSnapshotIntervalMs, so a restart never replays more than one snapshot
+// interval of records, and once half of the records tryAppend() accepts are used it rolls the journal the same
+// way: appends wait while it brings the replay up to date, snapshots it for a new journal and resets the file.
+// Snapshots are written to a temporary file (synced unless the policy is None) and renamed over the previous one.
+// A snapshot only belongs to the journal it was taken of (createTimeNs). A roll keeps the snapshot of the old
+// journal as <JournalFile>.snapshot.previous until the new journal exists, so a crash during the roll replays the
+// old journal from that one.
+// A crash can leave a record unfinished while later ones are complete, replay stops at the first unfinished one.
+
+#ifndef ORDER_JOURNAL_H
+#define ORDER_JOURNAL_H
+
+#include <atomic>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Config.h"
+#include "FlatHashMap.h"
+#include "PackedOrder.h"
+
+namespace ordermanagement {
+
+constexpr char ORDER_JOURNAL_MAGIC[8] = {'O', 'M', 'J', 'R', 'N', 'L', '\0', '\0'};
+constexpr char ORDER_SNAPSHOT_MAGIC[8] = {'O', 'M', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr uint32_t ORDER_JOURNAL_VERSION = 1;
+
+enum class JournalEvent : uint8_t {
+    None = 0,           // slot not written (yet)
+    Received = 1,       // New order added to the queue
+    Modified = 2,       // queued order modified, or amend of an in flight order
+    Cancelled = 3,      // queued order cancelled, or pending amend of an in flight order dropped
+    Sent = 4,
+    Responded = 5,
+    Rejected = 6        // taken out of the queue by OrderManagement itself (e.g. exchange closed)
+};
+
+struct JournalRecord {
+    uint64_t orderId;
+    // receive time of the request for Received/Modified, time of the event otherwise
+    uint64_t timeNs;
+    int32_t priceTicks;
+    uint32_t qty;
+    int32_t symbolId;
+    ClientId clientId;
+    // Side for Received/Modified, ResponseType for Responded
+    uint8_t value;
+    // stored last
+    JournalEvent event;
+};
+static_assert(sizeof(JournalRecord) == 32, "record layout is part of the file format");
+
+struct JournalFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;
+    // identifies the journal, a snapshot belongs to the journal with the same createTimeNs
+    uint64_t createTimeNs;
+    uint8_t reserved[32];
+};
+static_assert(sizeof(JournalFileHeader) == 64, "header layout is part of the file format");
+
+class OrderJournal {
+public:
+    // A journal can end the lifecycle of any order it holds with this many records, see the reserve above
+    static constexpr uint64_t RECORDS_PER_LIVE_ORDER = 4;
+    // Records reserved for the orders OrderPoolSize, ShardCount and InFlightTableSize let OrderManagement hold
+    static uint64_t reservedRecords(const Config& config);
+
+    // Opens config.journalFile, or creates it for config.journalCapacity records.
+    // Throws std::runtime_error if it can't be mapped, isn't a journal or has less than twice the reserved records.
+    explicit OrderJournal(const Config& config);
+    ~OrderJournal();
+    OrderJournal(const OrderJournal&) = delete;
+    OrderJournal& operator=(const OrderJournal&) = delete;
+
+    // Any thread. Sent, Responded, Cancelled and Rejected records of orders the journal holds, they use the reserve
+    // if needed. Waits while the journal is being rolled.
+    void append(const JournalRecord& record);
+    // Any thread. Received and Modified records, returns false if only the reserve is left. Waits while the journal
+    // is being rolled.
+    bool tryAppend(const JournalRecord& record);
+    // Writes the records appended so far to the disk
+    void sync();
+    // Whether half of the records tryAppend() accepts are used
+    bool rollDue() const;
+    // Appends wait from now on until reset() or resumeAppends(), returns once the appends in progress are complete
+    void suspendAppends();
+    // Lets the appends suspended by suspendAppends() go on into the current journal
+    void resumeAppends();
+    // Drops all the records, the journal is identified by createTimeNs from now on. Appends suspended by
+    // suspendAppends() go on into the empty journal, nothing else may be appended concurrently. Throws
+    // std::runtime_error if the file can't be cleared.
+    void reset(uint64_t createTimeNs);
+
+    // Whether snapshots have to be synced to the disk like the records (any policy but None)
+    bool syncsToDisk() const { return m_syncPolicy != JournalSyncPolicy::None; }
+    // Complete records from position on, up to the first unfinished one
+    std::span<const JournalRecord> completeRecords(uint64_t position) const;
+    uint64_t createTimeNs() const { return header().createTimeNs; }
+    uint64_t droppedRecords() const { return m_droppedRecords.load(std::memory_order_relaxed); }
+    const std::string& filename() const { return m_filename; }
+    std::string snapshotFilename() const { return m_filename + ".snapshot"; }
+    // snapshot of the journal before the last roll, until the roll is complete
+    std::string previousSnapshotFilename() const { return m_filename + ".snapshot.previous"; }
+
+private:
+    const JournalFileHeader& header() const { return *static_cast<const JournalFileHeader*>(m_mapping); }
+    void initialize(uint64_t createTimeNs);
+    void write(uint64_t index, const JournalRecord& record);
+    void waitForResume() const;
+
+private:
+    std::string m_filename;
+    JournalSyncPolicy m_syncPolicy;
+    int m_fd = -1;
+    void* m_mapping = nullptr;
+    size_t m_mappingSize = 0;
+    JournalRecord* m_records = nullptr;
+    uint64_t m_capacity = 0;
+    // records tryAppend() accepts, the rest is the reserve
+    uint64_t m_admissionLimit = 0;
+    // m_nextRecord before the appends were suspended
+    uint64_t m_suspendedRecord = 0;
+    // APPENDS_SUSPENDED and above while the appends are suspended
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_nextRecord = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_droppedRecords = 0;
+};
+
+enum class RecoveredOrderState : uint8_t {
+    Queued = 0,
+    InFlight = 1
+};
+
+// Live order rebuilt from the journal
+struct RecoveredOrder {
+    // latest values, type New, or Replace for the amend of an order the exchange has accepted
+    PackedOrder order;
+    // pending amend of an in flight order (type Modify), valid if hasAmend
+    PackedOrder amend;
+    uint64_t sendTimeNs;
+    // position of the record that (re)queued the order, recovered orders are queued in this order
+    uint64_t queuePosition;
+    RecoveredOrderState state;
+    bool hasAmend;
+};
+static_assert(sizeof(RecoveredOrder) == 96, "record layout is part of the snapshot format");
+
+struct OrderSnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t journalCreateTimeNs;
+    // journal records the snapshot covers
+    uint64_t journalPosition;
+    uint64_t orderCount;
+    uint8_t reserved[24];
+};
+static_assert(sizeof(OrderSnapshotHeader) == 64, "header layout is part of the snapshot format");
+
+// Not thread safe, OrderManagement uses it on one thread at a time
+class JournalReplay {
+public:
+    // capacity is the initial capacity of the orderId index, it grows if needed
+    explicit JournalReplay(size_t capacity);
+
+    // Returns false (and keeps the state empty) if there is no snapshot of the journal or it can't be read
+    bool loadSnapshot(const std::string& filename, uint64_t journalCreateTimeNs);
+    // Throws std::runtime_error if the snapshot can't be written. With sync the snapshot is on the disk when it
+    // returns, otherwise it survives a crash of the process but not necessarily one of the host.
+    void writeSnapshot(const std::string& filename, uint64_t journalCreateTimeNs, bool sync) const;
+    // Applies the records that follow position()
+    void apply(std::span<const JournalRecord> records);
+    // The records applied so far won't be replayed again, the next ones come from a new journal (position 0), or
+    // from position on in the current one when a roll fails
+    void restart(uint64_t position = 0) { m_position = position; }
+    // Forgets the order, e.g. one that couldn't be restored
+    void remove(uint64_t orderId);
+
+    // journal records applied so far, including the ones the snapshot covers
+    uint64_t position() const { return m_position; }
+    size_t size() const { return m_index.size(); }
+    // Live orders, the queued ones in queue order first
+    std::vector<RecoveredOrder> orders() const;
+
+private:
+    RecoveredOrder* find(uint64_t orderId);
+    void add(const RecoveredOrder& order);
+    void apply(const JournalRecord& record);
+
+private:
+    uint64_t m_position = 0;
+    // orderId -> index in m_orders
+    FlatHashMap<uint32_t> m_index;
+    std::vector<RecoveredOrder> m_orders;
+    std::vector<uint32_t> m_freeSlots;
+};
+
+// What OrderManagement recovered from the journal at startup
+struct JournalRecoveryStats {
+    bool snapshotLoaded = false;
+    uint64_t snapshotOrders = 0;
+    uint64_t replayedRecords = 0;
+    uint64_t queuedOrders = 0;
+    uint64_t inFlightOrders = 0;
+    uint64_t pendingAmends = 0;
+    // recovered orders that didn't fit into the in flight table
+    uint64_t droppedOrders = 0;
+    uint64_t durationNs = 0;
+};
+
+} // ordermanagement namespace
+
+#endif
@@ -1,12 +1,13 @@
 // This is the main class that performs order management and exchange transmission rate limiting.
 // On a high level there are 2 threads working with orders, one that writes orders to a queue
 // and another one that reads from the queue and transmits orders to the exchange, with appropriate
-// pre configured rate limiting. There is also third thread that periodically checks the system time
-// to send login/logout requests when needed and sets and sets m_exchangeOpen flag,
+// pre configured rate limiting. There is also third, session timer thread, that drives a hierarchical
+// timer wheel. Logon/logout of every configured trading session (including overnight sessions) are
+// scheduled on it as timers, which send login/logout requests and set m_exchangeOpen flag,
 // indicating whether orders need to be processed or rejected by OrderManagement.
-// Note that this thread uses relatively long sleeps when exchange open/close times are far away
-// from the current time, however when exchange open/close times get closer to the current time,
-// this thread performs a busy wait, to start transmitting orders instantly when exchange opens up.
+// Between the timers this thread sleeps with the configured wait strategy until the next deadline,
+// with TimerPrecisionNs precision, so it doesn't burn CPU all day for two events. The same thread
+// periodically recalibrates the TSC based clock (see Clock.h).
 // Given the requirements of this exercise, I think there is no need for us to keep orders in the
 // queue once they have been transmitted to the exchange. This is because we only care about
 // order statistics information after order was transmitted to the exchange, so we can just save
@@ -18,6 +19,52 @@
 // time between order transmission and its response receival.
 // I also slightly modified one of the onData functions declaration, please see the comment above it
 // for the reasoning behind that design decision.
+// With IngressMode=Ring in the config, upstream threads don't touch the orders queue at all:
+// they publish requests into a bounded lock free MPSC ring and the transmitter thread, which
+// then is the only owner of the orders queue and the queued orders map, applies them before
+// every transmission attempt. What happens when the ring is full is controlled by IngressOverflowPolicy.
+// Queued orders are kept in a preallocated slab pool (OrderPool) and looked up by orderId through
+// flat open addressing indexes, so New/Modify/Cancel/transmit/response don't allocate in steady state.
+// Requests are converted to 32 byte PackedOrders (fixed point price, see PackedOrder.h) in onData(), the ingress
+// ring, the queue and the batches only move these, they are converted back to OrderRequest when they are sent.
+// A Modify of an order that has already been sent but not answered yet becomes a pending amend: repeated
+// modifies of the order collapse into the latest one, and when the exchange accepts the order the amend is queued
+// as a Replace, sent with IExchangeSimulator::sendReplace() (cancel-replace) once the throttle has a credit for it,
+// and modified in place while it waits. A Cancel drops a pending or queued amend, so no credit is spent on it
+// (the order itself is already at the exchange, so the Cancel is still rejected with TooLateToCancel).
+// When the exchange rejects a cancel-replace the original order is still live there, the client gets an
+// AmendRejected event instead of Rejected and a newer pending amend is still queued as a Replace.
+// Throttling is delegated to a ThrottleCoordinator (see ThrottleCoordinator.h) that computes the next
+// permitted send time in O(1), so the transmitter sleeps until then instead of polling.
+// Idle waits of the transmitter and session threads go through a WaitStrategy selected in the config
+// (busy spin, yield, park or spin-yield-park backoff), producers notify the transmitter when they publish work.
+// With TransmitBatching=true, the transmitter drains the whole throttle budget that is available at once:
+// it pops up to the budget under one queue lock and hands them to the exchange with a single sendBatch() call.
+// Sent orders are kept in a lock free InFlightTable until their response arrives, so the response threads
+// never block the transmitter. Stats of completed orders are published to a StatsBus (see StatsBus.h),
+// every subscriber gets them through its own queue, so a slow subscriber never holds up the response path.
+// Clients that register with the OrderEventDispatcher (see OrderEvents.h) and pass their ClientId to onData()
+// get Queued/Modified/Cancelled/Sent/Accepted/Rejected events of their orders, with a RejectCode for rejects,
+// through their own queues.
+// With ShardCount > 1 the orders are split by symbolId over several shards, each with its own orders queue,
+// orderId index, ingress ring and transmitter thread, so a busy symbol only delays the symbols of its own shard
+// and the transmitters run on several cores. The transmitters of all the shards (or the only one) take send
+// credits from a lock free ThrottleCoordinator (see ThrottleCoordinator.h), which keeps the Rate/MonitorWindowSec
+// limit exact for the whole venue. Modify/Cancel requests must carry the symbolId of the order, a Modify can't
+// change it (RejectCode::SymbolChanged).
+// Several venues can run in one process on a VenueEngine (see VenueEngine.h): every venue is an OrderManagement
+// instance with its own config, queues, throttle and exchange gateway, but without threads of its own. The engine
+// threads run its session timers and transmitters, and the stats bus, the order event dispatcher and the clock
+// are shared by all the venues (VenueServices).
+// With JournalFile set, every change of an order is appended to a memory mapped journal (see OrderJournal.h),
+// periodically snapshotted and rolled on the session timer thread. At construction the queues, the in flight
+// orders and their pending amends are rebuilt from the last snapshot and the journal records that follow it, and
+// the orders queued at shutdown are kept for the next start instead of being rejected with Terminated. Orders
+// recovered in flight aren't resent, a resend could duplicate them at the exchange: those still without a response
+// JournalReconcileTimeoutMs after the first logon are rejected with RejectCode::Unreconciled.
+// The time source can be injected (IClock), and in simulation mode (startSimulation()) no thread is
+// started at all: the transmitter and the session timers are stepped by a discrete event simulation
+// driver running on virtual time (see Simulation.h).
 
 
 #ifndef ORDER_MANAGEMENT_H
@@ -27,33 +74,89 @@ class OrderRequest;
 class OrderResponse;
 
 #include <atomic>
-#include <queue>
-#include <unordered_map>
 #include <mutex>
 #include <thread>
 #include <functional>
+#include <vector>
+#include <span>
 
 #include "Config.h"
 #include "Utils.h"
 #include "OrderStatsCollector.h"
+#include "StatsBus.h"
+#include "OrderEvents.h"
+#include "Clock.h"
+#include "MpscRingBuffer.h"
+#include "OrderPool.h"
+#include "PackedOrder.h"
+#include "FlatHashMap.h"
+#include "InFlightTable.h"
+#include "ThrottleCoordinator.h"
+#include "WaitStrategy.h"
+#include "TimerWheel.h"
+#include "OrderJournal.h"
 
 namespace ordermanagement {
 
 class IExchangeSimulator;
 
+// What a venue of a VenueEngine shares with the other venues instead of owning it,
+// null members (the default) are owned by the OrderManagement instance itself
+struct VenueServices {
+    StatsBus* statsBus = nullptr;
+    OrderEventDispatcher* orderEvents = nullptr;
+    const IClock* clock = nullptr;
+    // interrupted whenever an action is scheduled, the thread that runs the session timers waits on it
+    WaitStrategy* sessionWaitStrategy = nullptr;
+    // one per shard, notified when orders arrive, the thread that drives the shard waits on it
+    std::vector<WaitStrategy*> shardWaitStrategies;
+};
+
 class OrderManagement
 {
-public:    
+public:
+    // onDataBatch() packs and publishes a basket in chunks of this many requests, on the stack
+    static constexpr size_t BATCH_CHUNK_SIZE = 64;
+
+    // statsCollector (if not null) is subscribed to the stats bus with its own delivery thread.
+    // clock replaces getCurrentTimeNs() as the time source, it is meant for simulations (see Simulation.h)
     OrderManagement(const std::string& configFileName, 
-                    std::unique_ptr<IOrderStatsCollectorCallBack> statsCollector);
+                    std::unique_ptr<IOrderStatsCollectorCallBack> statsCollector,
+                    const IClock* clock = nullptr);
+    // Venue of a VenueEngine, the services are owned by the engine and have to outlive the venue
+    OrderManagement(const Config& config, const VenueServices& services);
     
     void start();
+    // Simulation mode: schedules the sessions like start() but doesn't start any thread, the simulation
+    // driver calls runDueTimers() and pollTransmitter() itself whenever its virtual clock moves
+    void startSimulation();
+    // Venue mode: schedules the sessions like start() but leaves running the session timers and the
+    // transmitters (runDueTimers() and pollShard()) to the threads of the VenueEngine
+    void startDriven();
+    // Executes the timer actions that are due, returns the next timer deadline
+    // (WaitStrategy::NO_DEADLINE if there is none)
+    uint64_t runDueTimers();
+    // One transmitter iteration of every shard, returns the time it needs to run again: the current time if
+    // it has sent something, the throttle deadline if it is throttled, a retry time shortly after if the in
+    // flight table is full, WaitStrategy::NO_DEADLINE if there is nothing to send until new requests arrive or
+    // the exchange opens
+    uint64_t pollTransmitter();
+    // Same as pollTransmitter() for one shard
+    uint64_t pollShard(size_t shard) { return transmitStep(*m_shards[shard], now()); }
+    size_t getShardCount() const { return m_shards.size(); }
+    // Stops the session timer and the transmitter threads, nothing is sent to the exchange once it returns
     void shutDown();
     ~OrderManagement();
 
     // These 2 functions will be used for testing
     Config& getConfig() { return m_config; }
     void setExchangeSimulator(IExchangeSimulator* simulator);
+    // Order stats subscribers can be added and removed at any time
+    StatsBus& getStatsBus() { return *m_statsBus; }
+    // Clients register here for the events of their orders
+    OrderEventDispatcher& getOrderEvents() { return *m_orderEvents; }
+    // What has been recovered from the journal at construction, all zero without a journal
+    const JournalRecoveryStats& getJournalRecoveryStats() const { return m_journalRecoveryStats; }
 
     // Please note that I slightly modified the onData function declaration here to accept RequestType. 
     // The alternative would be to make RequestType member of OrderRequest, but that would mean that 
@@ -61,10 +164,20 @@ public:
     // to make it as a function parameter and don't send modify requests to the exchange 
     // (rather support modifications of orders when they are still in our system)
     // I assume this function can be called by multiple upstream threads.
-    void onData(OrderRequest && request, RequestType requestType);
+    // Events of the order are published to clientId (nobody gets them for NO_CLIENT, rejects are logged then).
+    void onData(OrderRequest && request, RequestType requestType, ClientId clientId = NO_CLIENT);
+    // Basket of requests in one call: the exchange open check and the receive timestamp are done once for the
+    // basket, and the requests of every shard are published with one lock (Locked ingress) or one ring
+    // reservation (Ring ingress) per up to BATCH_CHUNK_SIZE requests. results[i] gets the ingress verdict of
+    // requests[i], RejectCode::None if it has been queued (what happens to it later comes as order events, like
+    // for onData()), results must be at least as long as requests (std::runtime_error otherwise).
+    void onDataBatch(std::span<const BatchRequest> requests, std::span<RejectCode> results,
+                     ClientId clientId = NO_CLIENT);
 
     void onData(OrderResponse && response);
     void send(const OrderRequest& request);
+    void sendBatch(std::span<const OrderRequest> requests);
+    void sendReplace(const OrderRequest& request);
 
     // Sends the logon message to exchange.
     void sendLogon();
@@ -72,37 +185,158 @@ public:
     // Sends the logout message to exchange.
     void sendLogout();
 
+    // Executes the action on the session timer thread at deadlineNs (wall clock time),
+    // can be called from any thread, including from scheduled actions
+    void scheduleAction(uint64_t deadlineNs, std::function<void()> action);
+
 private:
-    static constexpr uint64_t REGULAR_SLEEP_TIME_NS = 1000000ull;
-    static constexpr uint64_t SHORT_SLEEP_TIME_NS = 1ull; // 1 nano
-    void checkExchangeState();
-    void waitOrAct(std::function<void()> act, 
-                   uint64_t currentTimeOffsetFromDateStart,
-                   uint64_t actionTimeOffsetFromDateStart);
-    void rejectOrder(OrderRequest && request, const std::string rejectReason);
-    void addRequestToQueue(OrderRequest && request);
-    void transmitRemoteRequests();
-    void rejectOrdersInQueue(const std::string& rejectReason);
-    bool transmitOneOrder(uint64_t& sendTime);
+    // Schedules logon/logout of the next occurrence of the session that starts from dayStartNs day
+    void scheduleSession(const TradingSession& session, uint64_t dayStartNs);
+    void scheduleSessions();
+    // Recalibrates the clock at deadlineNs and then every ClockCalibrationIntervalMs
+    void scheduleClockCalibration(uint64_t deadlineNs);
+    // Journal sync (Periodic policy), snapshots and rolls, if there is a journal
+    void scheduleJournalTasks();
+    void scheduleJournalSync(uint64_t deadlineNs);
+    void scheduleJournalSnapshot(uint64_t deadlineNs);
+    // Rebuilds the orders from the snapshot and the journal, then starts a new journal
+    void recoverFromJournal();
+    // Snapshots the orders of the replay for a new, empty journal. snapshotOfJournal tells whether the snapshot
+    // file belongs to the current journal, it is kept as the previous snapshot until the new journal exists then.
+    void rollJournal(bool snapshotOfJournal);
+    // Received and Modified records, returns false if the journal has no room for the request, see OrderJournal.h
+    bool journalOrder(JournalEvent event, const PackedOrder& order)
+    {
+        return !m_journal
+            || m_journal->tryAppend(JournalRecord{order.orderId, order.orderManagerReceiveTimeNs, order.priceTicks,
+                                                  order.qty, order.symbolId, order.clientId,
+                                                  static_cast<uint8_t>(order.side), event});
+    }
+    // At the first logon, schedules the reject of the recovered in flight orders the exchange doesn't answer
+    void scheduleReconciliation();
+    void rejectUnreconciledOrders(const std::vector<uint64_t>& orderIds);
+    void journalEvent(JournalEvent event, uint64_t orderId, uint8_t value = 0)
+    {
+        if (m_journal) {
+            m_journal->append(JournalRecord{orderId, now(), 0, 0, 0, NO_CLIENT, value, event});
+        }
+    }
+    void setExchangeOpen(bool exchangeOpen);
+    void runSessionTimers();
+    void rejectOrder(uint64_t orderId, ClientId clientId, RejectCode rejectCode);
+    // The amend of the order failed, the order itself stays live at the exchange with its previous values
+    void rejectAmend(uint64_t orderId, ClientId clientId, RejectCode rejectCode);
+    void publishOrderEvent(ClientId clientId, uint64_t orderId, OrderEventType type)
+    {
+        if (clientId != NO_CLIENT) {
+            m_orderEvents->publish(clientId, OrderEvent{orderId, now(), type, RejectCode::None});
+        }
+    }
+    // Orders of the symbols routed to one transmitter thread
+    struct Shard {
+        // driverWaitStrategy is the one of the thread that drives the shard, null if the shard has its own thread
+        Shard(const Config& config, WaitStrategy* driverWaitStrategy);
+
+        std::mutex ordersQueueMutex;
+        // queued orders in FIFO order, orderId -> pool slot index of the queued order
+        OrderPool ordersQueue;
+        FlatHashMap<uint32_t> queuedOrdersMap;
+        // queued orders that haven't been cancelled, the transmitter takes send credits for them
+        size_t liveOrders = 0;
+
+        // Ring ingress mode only, spill queue is used with OverflowPolicy::Spill when the ring is full
+        MpscRingBuffer<PackedOrder> ingressRing;
+        std::mutex ingressSpillMutex;
+        std::vector<PackedOrder> ingressSpill;
+        std::vector<PackedOrder> ingressSpillDrain;
+        std::atomic_bool ingressSpillActive = false;
+
+        // only used by the transmitter thread, orders popped under the lock and their conversions sent after it
+        std::vector<PackedOrder> batchOrders;
+        std::vector<OrderRequest> batchRequests;
+        // set when orders are waiting but other shards have taken the send credits, or the in flight slots
+        bool throttled = false;
+        bool inFlightFull = false;
+        // transmitter thread waits here for new orders/throttle deadlines, producers notify it
+        std::unique_ptr<WaitStrategy> ownWaitStrategy;
+        WaitStrategy* waitStrategy;
+        std::unique_ptr<std::thread> transmitter;
+    };
+
+    Shard& shardOf(int32_t symbolId)
+    {
+        return *m_shards[static_cast<uint32_t>(symbolId) % m_shards.size()];
+    }
+    // Returns RejectCode::None if the request has been published (or spilled)
+    RejectCode addRequestToIngressRing(Shard& shard, const PackedOrder& request);
+    // Applies the request (Locked ingress) or publishes it to the ingress ring and notifies the shard
+    void enqueueRequest(Shard& shard, const PackedOrder& request);
+    // Keeps the modify as the pending amend of the in flight order. Returns TooLateToModify if the order isn't in
+    // flight and JournalFull if the journal has no room for the amend.
+    RejectCode amendInFlightOrder(const PackedOrder& request);
+    void dropPendingAmend(uint64_t orderId);
+    // Called with the response of an amended order, queues the amend as a Replace if the order is live at the
+    // exchange: it was accepted, or it was a Replace the exchange rejected (the original order stays)
+    void releasePendingAmend(uint64_t orderId, ResponseType responseType, bool replace);
+    // orders of one shard of an onDataBatch() basket, resultIndexes[i] is the results index of orders[i]
+    void submitBatchToShard(Shard& shard, std::span<const PackedOrder> orders, const uint32_t* resultIndexes,
+                            std::span<RejectCode> results);
+    // Caller must hold the shard ordersQueueMutex (Locked ingress) or be the shard transmitter thread (Ring ingress)
+    void applyRequest(Shard& shard, const PackedOrder& request);
+    void drainIngressRing(Shard& shard);
+    std::unique_lock<std::mutex> lockOrdersQueue(Shard& shard);
+    uint64_t now() const { return m_clock ? m_clock->nowNs() : getCurrentTimeNs(); }
+    uint64_t transmitStep(Shard& shard, uint64_t stepTime);
+    // When a transmitter that found the in flight table full steps again
+    uint64_t inFlightRetryTime(uint64_t currentTime) const;
+    void transmitRemoteRequests(Shard* shard);
+    void rejectOrdersInQueue(Shard& shard, RejectCode rejectCode);
+    bool transmitOneOrder(Shard& shard, uint64_t& sendTime);
+    // Pops up to maxOrders (capped by MaxTransmitBatchSize and the send credits it gets) orders under one lock
+    // and sends them as one batch
+    size_t transmitOrdersBatch(Shard& shard, size_t maxOrders, uint64_t& sendTime);
+    void addInFlightOrder(const PackedOrder& order, uint64_t sendTime);
 
 private:
     std::atomic_bool m_exchangeOpen = false;
     std::atomic_bool m_terminate = false;
     
     Config m_config;
+    // null unless a clock has been injected, getCurrentTimeNs() is used then
+    const IClock* m_clock;
     
-    std::mutex m_ordersQueueMutex;
-    std::mutex m_ordersStatsMutex;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    // orders sent to the exchange waiting for their responses, lock free
+    InFlightTable m_inFlightOrders;
+    // send credits of all the shards
+    ThrottleCoordinator m_throttle;
+    PriceScale m_priceScale;
+    // latest modify of every in flight order that has been modified, orders are marked Amended in m_inFlightOrders
+    std::mutex m_amendsMutex;
+    FlatHashMap<PackedOrder> m_pendingAmends;
+    // null unless JournalFile is set, the replay follows the journal on the session timer thread for the snapshots
+    std::unique_ptr<OrderJournal> m_journal;
+    std::unique_ptr<JournalReplay> m_journalReplay;
+    JournalRecoveryStats m_journalRecoveryStats;
+    // in flight orders recovered from the journal, session timer thread only once running
+    std::vector<uint64_t> m_recoveredInFlightOrders;
+    // not owned in venue mode
+    std::unique_ptr<WaitStrategy> m_ownSessionWaitStrategy;
+    WaitStrategy* m_sessionWaitStrategy;
 
-    // it will use deque as underlined structure by default
-    std::queue<OrderInfo> m_ordersQueue;
-    std::unordered_map<uint64_t, OrderInfo*> m_queuedOrdersMap;
-    std::unordered_map<uint64_t, OrderStats> m_ordersStatsMap;
+    std::mutex m_timersMutex;
+    TimerWheel m_timerWheel;
+    std::vector<TimerWheel::Callback> m_dueActions;
     
-    std::unique_ptr<std::thread> m_checkExchangeState;
-    std::unique_ptr<std::thread> m_transmitRemoteRequests;
+    std::unique_ptr<std::thread> m_sessionTimerThread;
+    // nobody completes in flight orders while the transmitter waits in simulation mode
+    bool m_simulation = false;
 
-    std::unique_ptr<IOrderStatsCollectorCallBack> m_statsCollector;
+    // the own ones are null in venue mode
+    std::unique_ptr<OrderEventDispatcher> m_ownOrderEvents;
+    std::unique_ptr<StatsBus> m_ownStatsBus;
+    OrderEventDispatcher* m_orderEvents;
+    StatsBus* m_statsBus;
     IExchangeSimulator* m_simulator;
 };
 
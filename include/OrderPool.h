@@ -0,0 +1,60 @@
+// Preallocated storage for the orders waiting in the queue behind the throttle.
+// Orders live in 32 byte PackedOrder slots (two per cache line) carved out of slabs of OrderPoolSize slots,
+// free slots are kept in a free list and the queue itself is a singly linked FIFO threaded through
+// the same slots, so queueing and dequeueing an order never allocates. The links are kept in a parallel
+// array of indexes of the slab, so that they don't push an order over half a cache line. Slots are addressed by a 32 bit index that stays valid while the order
+// is queued, which is what the orderId index stores instead of a raw pointer.
+// If the pool runs out of slots another slab is added, so a burst of orders is never rejected
+// because of the pool size, but in steady state all the slots are recycled.
+// It is not thread safe, callers are responsible for the synchronisation.
+
+#ifndef ORDER_POOL_H
+#define ORDER_POOL_H
+
+#include <memory>
+#include <vector>
+#include <limits>
+
+#include "PackedOrder.h"
+
+namespace ordermanagement {
+
+class OrderPool {
+public:
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    explicit OrderPool(uint32_t slabSize);
+
+    // Appends the order to the tail of the queue and returns the index of its slot
+    uint32_t pushBack(const PackedOrder& order);
+    // Removes the head of the queue and recycles its slot, the queue must not be empty
+    void popFront();
+    PackedOrder& front() { return slot(m_head); }
+    PackedOrder& at(uint32_t index) { return slot(index); }
+    bool empty() const { return m_head == INVALID_INDEX; }
+    size_t size() const { return m_size; }
+
+private:
+    struct Slab {
+        std::unique_ptr<PackedOrder[]> orders;
+        // index of the next slot of the queue or of the free list
+        std::unique_ptr<uint32_t[]> next;
+    };
+
+    PackedOrder& slot(uint32_t index) { return m_slabs[index >> m_slabShift].orders[index & m_slabMask]; }
+    uint32_t& next(uint32_t index) { return m_slabs[index >> m_slabShift].next[index & m_slabMask]; }
+    void addSlab();
+
+private:
+    uint32_t m_slabShift;
+    uint32_t m_slabMask;
+    std::vector<Slab> m_slabs;
+    uint32_t m_freeHead = INVALID_INDEX;
+    uint32_t m_head = INVALID_INDEX;
+    uint32_t m_tail = INVALID_INDEX;
+    size_t m_size = 0;
+};
+
+} // ordermanagement namespace
+
+#endif
@@ -12,15 +12,24 @@
 #define ORDER_STATS_COLLECTOR_H
 
 #include <fstream>
+#include <vector>
 #include "Utils.h"
 
 namespace ordermanagement {
 
+// Response and stats of one order, as queued by the asynchronous collectors and the stats bus
+struct StatsRecord {
+    OrderResponse response;
+    OrderStats stats;
+};
+
 class IOrderStatsCollectorCallBack {
 public:
     virtual ~IOrderStatsCollectorCallBack() {}
     virtual void processOrderStatisticsInfo(OrderResponse && response, 
                                             const OrderStats& orderInfo) = 0;
+    // Called periodically by the StatsBus delivery thread (see StatsBus.h) to push buffered data out
+    virtual void flush() {}
 };
 
 class OrderStatsFileWriterCallback : public IOrderStatsCollectorCallBack {  
@@ -29,7 +38,11 @@ public:
     OrderStatsFileWriterCallback(const std::string& filename);
     void processOrderStatisticsInfo(OrderResponse && response,
                                     const OrderStats& orderInfo) override;
+    void flush() override { m_StatsFile.flush(); }
 private:
+    static constexpr size_t FILE_BUFFER_SIZE = 1 << 20;
+    // large stream buffer, so that the file is written in big blocks
+    std::vector<char> m_fileBuffer;
     std::ofstream m_StatsFile;
 };
 
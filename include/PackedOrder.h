@@ -0,0 +1,74 @@
+// Internal representation of an order inside OrderManagement.
+// OrderRequest (the exercise API) is int, double, uint64_t, char, uint64_t with padding holes, 40 bytes.
+// Internally every request is converted once, in onData(), to a 32 byte PackedOrder, two of them per cache line:
+// - the price is a fixed point number of ticks of the symbol (int32_t), PriceScale knows the number of
+//   decimals of every symbol (PriceDecimals and SymbolPriceDecimals config parameters),
+// - the quantity is 32 bits, the side and the request type are one byte enums,
+// - the receive time and the client of the request travel with it, so the ingress ring, the orders queue and
+//   the batches of the transmitter move nothing else.
+// A request whose price isn't a whole number of ticks, doesn't fit in 32 bits of ticks, whose quantity doesn't
+// fit in 32 bits or whose side is neither 'B' nor 'S' is rejected with RejectCode::InvalidOrder.
+// Orders are converted back to OrderRequest only when they are sent to the exchange. Decimal prices survive
+// the round trip exactly: ticks / 10^decimals is the closest double to the decimal price, the one it came from.
+
+#ifndef PACKED_ORDER_H
+#define PACKED_ORDER_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Utils.h"
+
+namespace ordermanagement {
+
+struct Config;
+
+enum class Side : uint8_t {
+    Buy = 0,
+    Sell = 1
+};
+
+struct alignas(32) PackedOrder {
+    uint64_t orderId;
+    uint64_t orderManagerReceiveTimeNs;
+    int32_t priceTicks;
+    uint32_t qty;
+    int32_t symbolId;
+    ClientId clientId;
+    Side side;
+    // type of the request in the ingress ring, a queued order is New (Replace for the amend of an order that is
+    // already at the exchange) until it gets cancelled
+    RequestType type;
+};
+
+static_assert(sizeof(PackedOrder) == 32, "PackedOrder must stay half a cache line");
+
+// Number of decimals of the prices of every symbol
+class PriceScale {
+public:
+    explicit PriceScale(const Config& config);
+
+    // Returns false if the price is not a whole number of ticks of the symbol or out of the int32_t range
+    bool toTicks(int32_t symbolId, double price, int32_t& ticks) const;
+    double toPrice(int32_t symbolId, int32_t ticks) const;
+
+private:
+    double scaleOf(int32_t symbolId) const;
+
+private:
+    double m_defaultScale;
+    // symbols with their own number of decimals, sorted by symbolId
+    std::vector<std::pair<int32_t, double>> m_symbolScales;
+};
+
+// API -> internal. Cancel requests only need the order and symbol ids, their other fields aren't looked at.
+// Returns false if the request can't be represented (RejectCode::InvalidOrder).
+bool packOrder(const OrderRequest& request, RequestType type, ClientId clientId, uint64_t receiveTimeNs,
+               const PriceScale& priceScale, PackedOrder& order);
+// internal -> API, right before the order is sent to the exchange
+OrderRequest unpackOrder(const PackedOrder& order, const PriceScale& priceScale);
+
+} // ordermanagement namespace
+
+#endif
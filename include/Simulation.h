@@ -0,0 +1,52 @@
+// Discrete event simulation driver.
+// Runs OrderManagement, ExchangeResponseSimulator and MockOrdersGenerator instances created in simulation
+// mode on a VirtualClock, in the calling thread: at every step it runs whatever is due at the current
+// virtual time (session timers, generator requests, exchange responses, transmitter), asks each of them
+// when it needs to run next and moves the clock straight to the earliest of those times. Sleeps and
+// throttle waits therefore cost nothing, a whole trading day of throttled flow replays in seconds,
+// and as nothing runs concurrently, runs with the same config and seed are identical.
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <vector>
+
+#include "Clock.h"
+#include "OrderManagement.h"
+#include "ExchangeSimulator.h"
+#include "MockOrdersGenerator.h"
+
+namespace ordermanagement {
+
+class Simulation {
+public:
+    // manager has to be constructed with the clock and started with startSimulation(),
+    // the exchange simulator has to be created in simulation mode with the same clock
+    Simulation(VirtualClock& clock, OrderManagement& manager, ExchangeResponseSimulator& exchange);
+
+    // The generator has to be created in simulation mode, it sends its first request at startTimeNs
+    void addOrdersGenerator(MockOrdersGenerator& generator, uint64_t startTimeNs);
+
+    // Processes everything that happens up to endTimeNs and leaves the clock at endTimeNs,
+    // returns the number of virtual time points that had something to do
+    uint64_t runUntil(uint64_t endTimeNs);
+
+private:
+    struct ScheduledGenerator {
+        MockOrdersGenerator* generator;
+        uint64_t nextRequestTimeNs;
+    };
+
+    // Runs everything due at the current time, returns the next time something is due
+    uint64_t step();
+
+private:
+    VirtualClock& m_clock;
+    OrderManagement& m_manager;
+    ExchangeResponseSimulator& m_exchange;
+    std::vector<ScheduledGenerator> m_generators;
+};
+
+} // ordermanagement namespace
+
+#endif
@@ -0,0 +1,32 @@
+// Addresses of the stream sockets between the exchange gateway and the exchange (see SocketExchangeGateway.h):
+// tcp:<IPv4 address>:<port> (e.g. tcp:127.0.0.1:9000) or unix:<path> (e.g. unix:/tmp/exchange.sock).
+// Sockets are created non blocking, TCP ones with TCP_NODELAY, as every write is a whole batch of messages.
+
+#ifndef SOCKET_ADDRESS_H
+#define SOCKET_ADDRESS_H
+
+#include <cstdint>
+#include <string>
+
+namespace ordermanagement {
+
+struct SocketAddress {
+    bool unixDomain = false;
+    std::string host;
+    uint16_t port = 0;
+    std::string path;
+};
+
+// Throws std::runtime_error if the address is not tcp:host:port or unix:path
+SocketAddress parseSocketAddress(const std::string& address);
+// Starts connecting a non blocking socket, returns -1 (errno is set) if it failed straight away.
+// inProgress is set if the connection completes later, the socket becomes writable then.
+int connectSocket(const SocketAddress& address, bool& inProgress);
+// Non blocking listening socket, throws std::runtime_error if it can't be created
+int listenSocket(const SocketAddress& address);
+// Accepts a connection as a non blocking socket, -1 if there is none
+int acceptSocket(int listenFd);
+
+} // ordermanagement namespace
+
+#endif
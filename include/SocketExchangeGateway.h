@@ -0,0 +1,141 @@
+// IExchangeSimulator that talks to a real exchange process over a stream socket (TCP loopback or Unix domain,
+// ExchangeAddress config parameter) with the binary wire codec (WireCodec.h), e.g. to the stand-in exchange
+// (tools/StandInExchange.cpp), so that the real I/O path can be measured: syscalls per order, write coalescing
+// and response parsing.
+// send()/sendBatch() encode the orders straight into preallocated send buffers under a mutex and wake the
+// gateway thread up (through an eventfd, only if it hasn't been woken up already). The gateway thread runs an
+// epoll event loop over the non blocking socket: it takes all the buffers queued since its last write and writes
+// them with one sendmsg call (writev with MSG_NOSIGNAL), so orders of several transmitters and several batches
+// are coalesced into one syscall. What the socket doesn't take is written when it becomes writable again.
+// Responses are read into a fixed read buffer, split into messages in place (forEachMessage) and dispatched to
+// OrderManagement::onData(OrderResponse&&) without any allocation, a partial message at the end of the buffer
+// waits there for the rest.
+// Session handling: sendLogon() connects (if needed) and sends the Logon message ahead of any order, the exchange
+// acknowledges it with a Logon message. sendLogout() queues a Logout behind the orders sent before it. If the
+// connection fails or drops while the session is wanted (between logon and logout), the gateway reconnects every
+// GatewayReconnectIntervalMs and logs on again. Orders that were sent but not answered when the connection
+// dropped are answered with a Reject by the gateway, so that they don't stay in flight forever, and orders sent
+// while there is no connection are rejected straight away. Orders sent while the connection is being
+// established are queued and go out right after the Logon.
+
+#ifndef SOCKET_EXCHANGE_GATEWAY_H
+#define SOCKET_EXCHANGE_GATEWAY_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ExchangeSimulator.h"
+#include "FlatHashMap.h"
+#include "SocketAddress.h"
+#include "WireCodec.h"
+
+namespace ordermanagement {
+
+struct GatewayStats {
+    uint64_t ordersSent = 0;
+    uint64_t writeCalls = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t responsesReceived = 0;
+    uint64_t readCalls = 0;
+    uint64_t connects = 0;
+    // orders answered by the gateway itself because there was no connection
+    uint64_t localRejects = 0;
+};
+
+class SocketExchangeGateway : public IExchangeSimulator {
+public:
+    // ExchangeAddress/Gateway* parameters come from the config of the manager
+    explicit SocketExchangeGateway(OrderManagement* manager);
+    ~SocketExchangeGateway();
+
+    // Any thread
+    void send(const OrderRequest& request) override;
+    void sendBatch(std::span<const OrderRequest> requests) override;
+    // Sent as a CancelReplaceMessage
+    void sendReplace(const OrderRequest& request) override;
+    void sendLogon(const Logon& logon) override;
+    void sendLogout(const Logout& logout) override;
+
+    // true once the exchange has acknowledged the logon of the current connection
+    bool loggedOn() const { return m_loggedOn.load(std::memory_order_acquire); }
+    GatewayStats getStats() const;
+
+private:
+    enum class ConnectionState {
+        Disconnected,
+        Connecting,
+        Connected
+    };
+
+    // Caller holds m_sendMutex, buffer with room for one more message of messageSize bytes
+    wire::SendBuffer& tailBuffer(size_t messageSize);
+    // Caller holds m_sendMutex, returns true if the gateway thread has to be woken up
+    bool markWakePending();
+    void wakeUp();
+    void rejectLocally(std::span<const OrderRequest> requests);
+
+    // Gateway thread
+    void run();
+    void connect();
+    void onConnected();
+    void disconnect(const char* reason);
+    void flush();
+    void readResponses();
+    void updateEpollEvents();
+
+private:
+    OrderManagement* m_manager;
+    SocketAddress m_address;
+    uint64_t m_reconnectIntervalNs;
+    size_t m_sendBufferSize;
+
+    int m_epollFd = -1;
+    int m_wakeFd = -1;
+    int m_socketFd = -1;
+
+    std::mutex m_sendMutex;
+    // guarded by m_sendMutex
+    ConnectionState m_state = ConnectionState::Disconnected;
+    bool m_wakePending = false;
+    bool m_sessionWanted = false;
+    Logon m_logon;
+    std::vector<std::unique_ptr<wire::SendBuffer>> m_queuedBuffers;
+    std::vector<std::unique_ptr<wire::SendBuffer>> m_freeBuffers;
+    // orders sent on the current connection that haven't been answered yet
+    FlatHashMap<bool> m_unanswered;
+
+    // gateway thread only
+    // Logon of a new connection, written ahead of the queued buffers
+    wire::SendBuffer m_controlBuffer;
+    size_t m_controlOffset = 0;
+    std::vector<std::unique_ptr<wire::SendBuffer>> m_writeBuffers;
+    // bytes of m_writeBuffers.front() that have already been written
+    size_t m_writeOffset = 0;
+    bool m_connecting = false;
+    bool m_waitingForWritable = false;
+    // 0 if no reconnect is scheduled
+    uint64_t m_nextConnectTimeNs = 0;
+    std::unique_ptr<uint8_t[]> m_readBuffer;
+    size_t m_readBufferSize;
+    size_t m_readBytes = 0;
+    std::vector<OrderResponse> m_responses;
+    std::vector<uint64_t> m_rejectedOrders;
+
+    std::atomic<uint64_t> m_ordersSent = 0;
+    std::atomic<uint64_t> m_writeCalls = 0;
+    std::atomic<uint64_t> m_bytesWritten = 0;
+    std::atomic<uint64_t> m_responsesReceived = 0;
+    std::atomic<uint64_t> m_readCalls = 0;
+    std::atomic<uint64_t> m_connects = 0;
+    std::atomic<uint64_t> m_localRejects = 0;
+    std::atomic_bool m_loggedOn = false;
+    std::atomic_bool m_terminate = false;
+    std::unique_ptr<std::thread> m_thread;
+};
+
+} // ordermanagement namespace
+
+#endif
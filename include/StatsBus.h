@@ -0,0 +1,99 @@
+// Publish/subscribe bus for order completion stats.
+// OrderManagement publishes the response and stats of every completed order to the bus, which copies
+// them into a bounded lock free queue per subscriber (SubscriberQueue.h), so a file writer, a live histogram,
+// a risk monitor and a metrics exporter can all consume the same events without a slow consumer holding up the
+// others or the response path. StatsOverflowPolicy decides what happens to a record that doesn't fit into the
+// queue of a subscriber: Reject drops it for that subscriber only (and counts it), Block waits for room and Spill
+// keeps it in an unbounded side queue.
+// A subscriber either gives the bus an IOrderStatsCollectorCallBack, which is then called on a delivery
+// thread of its own (woken up and flushed every StatsFlushIntervalMs, or for every record and batch if it is 0), or
+// polls its queue in batches with poll().
+// Subscribers can be added and removed at any time while orders are published: subscriber pointers
+// are kept in a fixed array of atomic slots, and unsubscribe() clears the slot and then waits until
+// every publisher that could still see the subscriber is done (publishers register in one of two
+// counters selected by an epoch, unsubscribe() flips the epoch and waits for the old counter to drain)
+// before the subscriber is destroyed.
+
+#ifndef STATS_BUS_H
+#define STATS_BUS_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "OrderStatsCollector.h"
+#include "SubscriberQueue.h"
+#include "Config.h"
+
+namespace ordermanagement {
+
+using SubscriberId = uint32_t;
+
+struct SubscriberStats {
+    uint64_t published = 0;    // records offered to the subscriber
+    uint64_t delivered = 0;    // records passed to the callback or returned by poll()
+    uint64_t dropped = 0;      // records dropped because the subscriber queue was full (Reject policy)
+    uint64_t lag = 0;          // records waiting in the subscriber queue
+};
+
+class StatsBus {
+public:
+    static constexpr size_t MAX_SUBSCRIBERS = 16;
+    static constexpr SubscriberId INVALID_SUBSCRIBER = UINT32_MAX;
+
+    // Uses StatsRingSize (default subscriber queue size), StatsFlushIntervalMs and StatsOverflowPolicy config
+    // parameters
+    explicit StatsBus(const Config& config);
+    // Unsubscribes everyone, delivering what is still queued to the callback subscribers
+    ~StatsBus();
+
+    // The callback is called on a delivery thread owned by the subscriber.
+    // queueSize 0 means StatsRingSize. Returns INVALID_SUBSCRIBER if MAX_SUBSCRIBERS are already subscribed.
+    SubscriberId subscribe(std::unique_ptr<IOrderStatsCollectorCallBack> callback, size_t queueSize = 0);
+    // The subscriber reads its records with poll()
+    SubscriberId subscribePolling(size_t queueSize = 0);
+    // Stops the delivery thread (after delivering everything that is queued) and removes the subscriber,
+    // returns false for an unknown subscriber. Must not be called concurrently with poll() of the same subscriber.
+    bool unsubscribe(SubscriberId id);
+
+    // Any thread, never blocks unless StatsOverflowPolicy is Block
+    void publish(const OrderResponse& response, const OrderStats& stats);
+
+    // Polling subscribers only, one polling thread per subscriber. Appends up to maxRecords records.
+    size_t poll(SubscriberId id, std::vector<StatsRecord>& records, size_t maxRecords = SIZE_MAX);
+
+    SubscriberStats getSubscriberStats(SubscriberId id) const;
+
+private:
+    static constexpr size_t DELIVERY_BATCH_SIZE = 256;
+
+    struct Subscriber {
+        Subscriber(std::unique_ptr<IOrderStatsCollectorCallBack> callback, size_t queueSize,
+                   OverflowPolicy overflowPolicy);
+        std::unique_ptr<IOrderStatsCollectorCallBack> callback;
+        SubscriberQueue<StatsRecord> records;
+    };
+
+    SubscriberId addSubscriber(std::unique_ptr<IOrderStatsCollectorCallBack> callback, size_t queueSize);
+    // Returns once no publisher can reach a subscriber removed from its slot before the call
+    void waitForPublishers();
+
+private:
+    const size_t m_defaultQueueSize;
+    const uint64_t m_flushIntervalNs;
+    const OverflowPolicy m_overflowPolicy;
+
+    std::array<std::atomic<Subscriber*>, MAX_SUBSCRIBERS> m_subscribers{};
+    std::atomic<uint64_t> m_publisherEpoch = 0;
+    std::array<std::atomic<uint64_t>, 2> m_activePublishers{};
+    // serializes subscribe/unsubscribe, the owning pointers are only touched under it
+    mutable std::mutex m_subscribersMutex;
+    std::array<std::unique_ptr<Subscriber>, MAX_SUBSCRIBERS> m_ownedSubscribers;
+};
+
+} // ordermanagement namespace
+
+#endif
@@ -0,0 +1,125 @@
+// High throughput exchange simulator for stress testing the throttle and the in flight order handling.
+// Unlike ExchangeResponseSimulator (one response thread, one mutex protected queue) it spreads the orders
+// over ExchangeResponseThreads worker threads, each with its own lock free MPSC ring, and every worker
+// answers its orders when they are due without any lock, so it sustains millions of responses per second.
+// The exchange side rate limit is applied when an order is received, the rest of its response is decided
+// by its worker:
+// - the latency is drawn from a LatencyModel: Fixed, LogNormal (ExchangeLatencyNs is the median,
+//   ExchangeLatencySigma the shape) or Histogram, which replays the round trip latencies recorded
+//   in a binary stats file (ExchangeLatencyFile, see BinaryStatsFile.h),
+// - an order above the exchange side limit of ExchangeRateLimit orders per ExchangeRateWindowMs (a lock free
+//   SlidingWindowCredits, see ThrottleCoordinator.h) is rejected, the others are rejected with
+//   ExchangeRejectRatio probability and accepted otherwise.
+// Workers keep their pending responses in a heap ordered by due time, as the latencies vary, and wait
+// with the manager's wait strategy until the next one is due or new orders arrive.
+// send()/sendBatch() can be called by several transmitter threads at once (see ShardCount). Every worker has
+// its own seeded generator, so the sequence of latencies and responses of a worker is reproducible
+// for the same sequence of orders.
+
+#ifndef STRESS_EXCHANGE_SIMULATOR_H
+#define STRESS_EXCHANGE_SIMULATOR_H
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ExchangeSimulator.h"
+#include "LatencyHistogram.h"
+#include "MpscRingBuffer.h"
+#include "ThrottleCoordinator.h"
+#include "WaitStrategy.h"
+#include "Config.h"
+
+namespace ordermanagement {
+
+class LatencyModel {
+public:
+    static LatencyModel fixed(uint64_t latencyNs);
+    static LatencyModel logNormal(uint64_t medianNs, double sigma);
+    // Replays the distribution of the histogram, values are drawn uniformly within their bucket
+    static LatencyModel fromHistogram(const LatencyHistogram& histogram);
+    // Round trip latencies (request sent to response received) of a binary stats file,
+    // throws std::runtime_error if the file can't be read or has no records
+    static LatencyModel fromStatsFile(const std::string& filename);
+    // Model described by the ExchangeLatencyModel/ExchangeLatencyNs/ExchangeLatencySigma/ExchangeLatencyFile
+    // config parameters
+    static LatencyModel fromConfig(const Config& config);
+
+    uint64_t sample(std::mt19937_64& generator);
+
+private:
+    explicit LatencyModel(LatencyModelType type) : m_type(type) {}
+
+private:
+    LatencyModelType m_type;
+    uint64_t m_fixedNs = 0;
+    std::lognormal_distribution<double> m_logNormal;
+    // Histogram model, non empty buckets and their cumulative counts
+    std::vector<size_t> m_buckets;
+    std::vector<uint64_t> m_cumulativeCounts;
+};
+
+class StressExchangeSimulator : public IExchangeSimulator {
+public:
+    // Uses the Exchange* config parameters of the manager
+    explicit StressExchangeSimulator(OrderManagement* manager, uint32_t seed = 1);
+    // rateLimit 0 means no exchange side limit
+    StressExchangeSimulator(OrderManagement* manager, LatencyModel latencyModel, double rejectRatio,
+                            uint32_t rateLimit, uint64_t rateWindowNs, uint32_t responseThreads, uint32_t seed);
+    // Pending responses are not sent
+    ~StressExchangeSimulator();
+
+    void sendLogon(const Logon& logon) override;
+    void sendLogout(const Logout& logout) override;
+    void send(const OrderRequest& request) override;
+    void sendBatch(std::span<const OrderRequest> requests) override;
+
+    bool loggedIn() const { return m_loggedIn; }
+    uint64_t getReceivedCount() const { return m_received.load(std::memory_order_relaxed); }
+    uint64_t getRespondedCount() const;
+    // Orders rejected because they were above the exchange side rate limit
+    uint64_t getRateLimitRejectCount() const { return m_rateLimitRejects.load(std::memory_order_relaxed); }
+
+private:
+    struct PendingResponse {
+        uint64_t orderId;
+        // receive time until the worker draws the latency
+        uint64_t dueTimeNs;
+        ResponseType responseType;
+    };
+
+    struct Worker {
+        Worker(size_t ringSize, const Config& config, const LatencyModel& latencyModel, double rejectRatio,
+               uint64_t seed);
+        MpscRingBuffer<PendingResponse> requests;
+        WaitStrategy waitStrategy;
+        // only used by the worker thread, min heap by due time
+        std::vector<PendingResponse> pending;
+        LatencyModel latencyModel;
+        std::mt19937_64 generator;
+        std::bernoulli_distribution reject;
+        std::atomic<uint64_t> responded = 0;
+        std::unique_ptr<std::thread> thread;
+    };
+
+    void addRequest(const OrderRequest& request, uint64_t currentTime);
+    void respond(Worker* worker);
+
+private:
+    OrderManagement* m_manager;
+    // null without an exchange side limit
+    std::unique_ptr<SlidingWindowCredits> m_rateLimit;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic_bool m_loggedIn = false;
+    std::atomic_bool m_terminated = false;
+    std::atomic<uint64_t> m_received = 0;
+    std::atomic<uint64_t> m_rateLimitRejects = 0;
+};
+
+} // ordermanagement namespace
+
+#endif
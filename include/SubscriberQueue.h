@@ -0,0 +1,232 @@
+// Bounded queue of one subscriber, with its counters and its optional delivery thread. StatsBus subscribers and
+// OrderEventDispatcher clients are both built on it.
+// Publishers push into a lock free MPSC ring (MpscRingBuffer), so a push never takes a lock or allocates while the
+// consumer keeps up. The OverflowPolicy decides what happens when the ring is full: Reject drops the item (and
+// counts it), Block waits until the consumer has made room and Spill appends it to an unbounded mutex protected
+// side queue. Once something has been spilled, later items are spilled too until the consumer takes the spill
+// queue, which it only does once the ring is empty, so items are consumed in the order they were pushed.
+// The consumer is either the delivery thread started with startDelivery(), which passes the items to a function
+// in batches and calls a flush function periodically, or a single polling thread calling consume().
+
+#ifndef SUBSCRIBER_QUEUE_H
+#define SUBSCRIBER_QUEUE_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "Config.h"
+#include "MpscRingBuffer.h"
+#include "WaitStrategy.h"
+
+namespace ordermanagement {
+
+template <typename T>
+class SubscriberQueue {
+public:
+    // The delivery thread (if any) waits for items with a WaitStrategy of waitStrategyType
+    SubscriberQueue(size_t capacity, OverflowPolicy overflowPolicy, WaitStrategyType waitStrategyType,
+                    uint32_t spinIterations, uint32_t yieldIterations)
+        : m_overflowPolicy(overflowPolicy)
+        , m_ring(capacity)
+        , m_waitStrategy(waitStrategyType, spinIterations, yieldIterations)
+    {
+    }
+    // Delivers what is still queued if there is a delivery thread
+    ~SubscriberQueue() { stopDelivery(); }
+    SubscriberQueue(const SubscriberQueue&) = delete;
+    SubscriberQueue& operator=(const SubscriberQueue&) = delete;
+
+    // Any thread. With notify the delivery thread is woken up right away, otherwise only once the ring is full
+    // (or at its next flush). Returns false if the item has been dropped.
+    bool push(const T& item, bool notify)
+    {
+        m_published.fetch_add(1, std::memory_order_relaxed);
+        if (!m_spillActive.load(std::memory_order_acquire) && m_ring.tryPush(item)) {
+            if (notify) {
+                m_waitStrategy.notify();
+            }
+            return true;
+        }
+        // the ring is full, make sure the consumer is awake
+        m_waitStrategy.notify();
+        switch (m_overflowPolicy) {
+            case OverflowPolicy::Reject:
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            case OverflowPolicy::Block:
+                while (!m_ring.tryPush(item)) {
+                    m_waitStrategy.notify();
+                    std::this_thread::yield();
+                }
+                break;
+            case OverflowPolicy::Spill: {
+                    std::lock_guard<std::mutex> lock(m_spillMutex);
+                    m_spill.push_back(item);
+                    m_spillActive.store(true, std::memory_order_release);
+                }
+                break;
+        }
+        return true;
+    }
+
+    // Polling consumer only. Passes up to maxItems items to function(T&) in push order, returns the count.
+    template <typename Function>
+    size_t consume(Function&& function, size_t maxItems = SIZE_MAX)
+    {
+        const size_t consumed = pop(function, maxItems);
+        m_delivered.fetch_add(consumed, std::memory_order_relaxed);
+        return consumed;
+    }
+
+    // Starts the delivery thread. It passes the items to deliver() in batches of up to batchSize and, if flush is
+    // set, calls it every flushIntervalNs when something has been delivered since the last flush (after every
+    // delivered batch if flushIntervalNs is 0), and once more when it stops.
+    void startDelivery(std::function<void(std::span<T>)> deliver, std::function<void()> flush,
+                       uint64_t flushIntervalNs, size_t batchSize)
+    {
+        m_deliver = std::move(deliver);
+        m_flush = std::move(flush);
+        m_flushIntervalNs = flushIntervalNs;
+        m_batchSize = batchSize;
+        m_deliveryThread = std::make_unique<std::thread>(&SubscriberQueue::deliverItems, this);
+    }
+    // Delivers everything that is queued and stops the delivery thread
+    void stopDelivery()
+    {
+        if (m_deliveryThread) {
+            m_terminate = true;
+            m_waitStrategy.interrupt();
+            m_deliveryThread->join();
+            m_deliveryThread.reset();
+        }
+    }
+    bool hasDeliveryThread() const { return m_deliveryThread != nullptr; }
+
+    // items pushed, passed to the delivery function or consumed, and dropped (Reject policy)
+    uint64_t published() const { return m_published.load(std::memory_order_relaxed); }
+    uint64_t delivered() const { return m_delivered.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    template <typename Function>
+    size_t pop(Function& function, size_t maxItems)
+    {
+        size_t popped = 0;
+        T item;
+        while (popped < maxItems) {
+            // a spill queue that has been taken is older than anything in the ring
+            if (m_spillPosition < m_spillDrain.size()) {
+                function(m_spillDrain[m_spillPosition++]);
+            } else if (m_ring.tryPop(item)) {
+                function(item);
+            } else if (!takeSpill()) {
+                break;
+            } else {
+                continue;
+            }
+            ++popped;
+        }
+        return popped;
+    }
+
+    bool takeSpill()
+    {
+        if (!m_spillActive.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_spillMutex);
+        // A publisher could have claimed a ring slot, not published it yet and then spilled its next item.
+        // Take the spill queue only when the ring is completely empty, otherwise the spilled item would
+        // overtake the one still sitting in the ring.
+        if (!m_ring.empty()) {
+            return false;
+        }
+        m_spillDrain.clear();
+        m_spillPosition = 0;
+        m_spillDrain.swap(m_spill);
+        m_spillActive.store(false, std::memory_order_release);
+        return !m_spillDrain.empty();
+    }
+
+    size_t deliverBatch(std::vector<T>& batch)
+    {
+        batch.clear();
+        auto append = [&batch](T& item) { batch.push_back(std::move(item)); };
+        pop(append, m_batchSize);
+        if (!batch.empty()) {
+            m_deliver(std::span<T>(batch));
+            m_delivered.fetch_add(batch.size(), std::memory_order_relaxed);
+        }
+        return batch.size();
+    }
+
+    void deliverItems()
+    {
+        // allocated once, delivering doesn't allocate
+        std::vector<T> batch;
+        batch.reserve(m_batchSize);
+        uint64_t nextFlushTime = m_flush && m_flushIntervalNs ? getCurrentTimeNs() + m_flushIntervalNs
+                                                              : WaitStrategy::NO_DEADLINE;
+        bool unflushed = false;
+        while (!m_terminate) {
+            const uint64_t waitEpoch = m_waitStrategy.prepareWait();
+            const size_t delivered = deliverBatch(batch);
+            unflushed |= delivered > 0;
+            if (m_flush && m_flushIntervalNs == 0) {
+                if (unflushed) {
+                    m_flush();
+                    unflushed = false;
+                }
+            } else if (m_flush) {
+                const uint64_t currentTime = getCurrentTimeNs();
+                if (currentTime >= nextFlushTime) {
+                    if (unflushed) {
+                        m_flush();
+                        unflushed = false;
+                    }
+                    nextFlushTime = currentTime + m_flushIntervalNs;
+                }
+            }
+            if (delivered < m_batchSize) {
+                m_waitStrategy.waitForWork(waitEpoch, nextFlushTime);
+            }
+        }
+        while (deliverBatch(batch) > 0) {
+        }
+        if (m_flush) {
+            m_flush();
+        }
+    }
+
+private:
+    const OverflowPolicy m_overflowPolicy;
+    MpscRingBuffer<T> m_ring;
+    WaitStrategy m_waitStrategy;
+
+    std::mutex m_spillMutex;
+    std::vector<T> m_spill;
+    std::atomic_bool m_spillActive = false;
+    // consumer only, the spill queue taken last and the next item of it to consume
+    std::vector<T> m_spillDrain;
+    size_t m_spillPosition = 0;
+
+    std::atomic<uint64_t> m_published = 0;
+    std::atomic<uint64_t> m_delivered = 0;
+    std::atomic<uint64_t> m_dropped = 0;
+
+    std::function<void(std::span<T>)> m_deliver;
+    std::function<void()> m_flush;
+    uint64_t m_flushIntervalNs = 0;
+    size_t m_batchSize = 1;
+    std::atomic_bool m_terminate = false;
+    std::unique_ptr<std::thread> m_deliveryThread;
+};
+
+} // ordermanagement namespace
+
+#endif
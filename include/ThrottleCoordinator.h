@@ -0,0 +1,101 @@
+// Venue wide throttle shared by the transmitter threads of all the shards of OrderManagement (see ShardCount).
+// A transmitter takes send credits before it pops orders from its queue, one credit per order, and the
+// Rate/MonitorWindowSec limit (and RatePerSecond on top of it) holds across the shards exactly as it does
+// for a single transmitter. Credits are granted with compare and swap, so a transmitter never takes a lock
+// or waits for another one:
+// SlidingWindowCredits - credits are numbered, credit n is granted only once credit n - rate was granted
+//                        a whole window ago. Grant times of the last `rate` credits are kept in a ring of
+//                        sequenced slots: a grant claims its range of credit numbers with one CAS and then
+//                        stamps their slots with the time read after the CAS, so no window ever holds more
+//                        than `rate` grants, whatever the interleaving of the transmitters.
+// GcraCredits          - Generic Cell Rate Algorithm (token bucket equivalent) on one atomic theoretical arrival
+//                        time, allows bursts of up to `burst` credits and then one per period/rate. A grant of
+//                        k credits moves it k emission intervals forward with one CAS.
+// With RatePerSecond credits are taken from both limits in turn. A credit that one limit grants and the other
+// one refuses in a race between transmitters is lost, so under contention the shards can send slightly less,
+// but never more, than the limits.
+
+#ifndef THROTTLE_COORDINATOR_H
+#define THROTTLE_COORDINATOR_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Utils.h"
+#include "Clock.h"
+
+namespace ordermanagement {
+
+struct Config;
+
+class ISendCredits {
+public:
+    virtual ~ISendCredits() = default;
+    // Earliest time (in ns) one more credit can be granted, nowNs if it can be granted right away
+    virtual uint64_t nextPermittedTimeNs(uint64_t nowNs) const = 0;
+    // Number of credits (up to maxCredits) that could be granted at nowNs
+    virtual uint32_t availableCredits(uint64_t nowNs, uint32_t maxCredits) const = 0;
+    // Grants up to maxCredits credits permitted at nowNs, returns the number of credits granted
+    virtual uint32_t acquire(uint64_t nowNs, uint32_t maxCredits) = 0;
+};
+
+class SlidingWindowCredits : public ISendCredits {
+public:
+    // clock (getCurrentTimeNs() if null) stamps the grants
+    SlidingWindowCredits(uint32_t rate, uint64_t windowNs, const IClock* clock);
+    uint64_t nextPermittedTimeNs(uint64_t nowNs) const override;
+    uint32_t availableCredits(uint64_t nowNs, uint32_t maxCredits) const override;
+    uint32_t acquire(uint64_t nowNs, uint32_t maxCredits) override;
+
+private:
+    struct Slot {
+        // credit number that can be granted from this slot next, it is credit + rate once credit has been stamped
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> grantTimeNs;
+    };
+
+    uint32_t countPermitted(uint64_t credit, uint64_t nowNs, uint32_t maxCredits) const;
+
+private:
+    const IClock* m_clock;
+    uint64_t m_windowNs;
+    uint64_t m_rate;
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_nextCredit = 0;
+};
+
+class GcraCredits : public ISendCredits {
+public:
+    GcraCredits(uint32_t rate, uint64_t periodNs, uint32_t burst);
+    uint64_t nextPermittedTimeNs(uint64_t nowNs) const override;
+    uint32_t availableCredits(uint64_t nowNs, uint32_t maxCredits) const override;
+    uint32_t acquire(uint64_t nowNs, uint32_t maxCredits) override;
+
+private:
+    uint32_t budget(uint64_t theoreticalArrivalTimeNs, uint64_t nowNs) const;
+
+private:
+    uint64_t m_emissionIntervalNs;
+    uint64_t m_toleranceNs;
+    uint32_t m_burst;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_theoreticalArrivalTimeNs = 0;
+};
+
+class ThrottleCoordinator {
+public:
+    // Limits described by ThrottleMode/Rate/MonitorWindowSec/ThrottleBurst/RatePerSecond config parameters
+    ThrottleCoordinator(const Config& config, const IClock* clock);
+
+    // Any thread
+    uint64_t nextPermittedTimeNs(uint64_t nowNs) const;
+    // Any thread, grants up to maxCredits credits that all the limits permit at nowNs
+    uint32_t acquire(uint64_t nowNs, uint32_t maxCredits);
+
+private:
+    std::vector<std::unique_ptr<ISendCredits>> m_limits;
+};
+
+} // ordermanagement namespace
+
+#endif
@@ -0,0 +1,76 @@
+// Hierarchical timer wheel used to fire scheduled actions (exchange logon/logout etc.) at their deadlines.
+// Time is split into ticks of `tickNs` (the timer precision), the wheel has LEVELS levels of
+// SLOTS slots each, level k slots cover SLOTS^k ticks. A timer is put into the level that
+// matches its distance from the current tick and is cascaded down to the lower levels as the
+// wheel turns, so scheduling, cancelling and firing a timer are O(1). Timers farther away than
+// the whole wheel span are parked in an overflow list and re-inserted when the top level wraps.
+// When the lower levels are empty the wheel jumps straight to the next cascade boundary, so
+// advancing over hours of idle time costs a handful of steps.
+// A timer scheduled for deadline D fires on the first tick boundary at or after D, so it is
+// never early and at most one tick late. nextDeadlineNs() tells the driving thread how long
+// it can sleep, the driving thread is expected to call advance() at (or after) that time.
+// It is not thread safe, callers are responsible for the synchronisation.
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <array>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "Utils.h"
+
+namespace ordermanagement {
+
+class TimerWheel {
+public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    TimerWheel(uint64_t tickNs, uint64_t startTimeNs);
+
+    TimerId schedule(uint64_t deadlineNs, Callback callback);
+    bool cancel(TimerId timerId);
+
+    // Moves callbacks of all the timers that are due at nowNs into `due`, in deadline order.
+    // Callbacks are returned instead of being called, so that they can be executed without
+    // holding the lock that protects the wheel (and can schedule new timers).
+    void advance(uint64_t nowNs, std::vector<Callback>& due);
+
+    // Time at which the earliest pending timer fires, NO_TIMERS if there is none
+    uint64_t nextDeadlineNs() const;
+    size_t size() const { return m_timers.size(); }
+
+    static constexpr uint64_t NO_TIMERS = ~0ull;
+
+private:
+    static constexpr uint32_t LEVELS = 4;
+    static constexpr uint32_t SLOT_BITS = 8;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+
+    struct Timer {
+        uint64_t deadlineNs;
+        uint64_t deadlineTick;
+        Callback callback;
+    };
+
+    void insert(TimerId timerId, uint64_t deadlineTick);
+    void cascade(uint32_t level);
+    void fireSlot(std::vector<TimerId>& slot, std::vector<TimerId>& fired);
+
+private:
+    const uint64_t m_tickNs;
+    uint64_t m_currentTick;
+    TimerId m_nextTimerId = 1;
+    std::unordered_map<TimerId, Timer> m_timers;
+    std::array<std::array<std::vector<TimerId>, SLOTS>, LEVELS> m_wheel;
+    // number of timer ids per level, cancelled timers are removed lazily
+    std::array<size_t, LEVELS> m_levelSizes{};
+    std::vector<TimerId> m_overflow;
+};
+
+} // ordermanagement namespace
+
+#endif
@@ -4,11 +4,14 @@
 #define UTILS_H
 
 #include <string>
+#include <cstdint>
+#include <cstddef>
 
 namespace ordermanagement {
 
 constexpr uint64_t NS_IN_DAY = 1000000000ull * 24 * 3600;
 constexpr uint64_t NS_IN_SECOND = 1000000000ull;
+constexpr size_t CACHE_LINE_SIZE = 64;
 
 struct Logon {
     std::string username; std::string password;
@@ -18,11 +21,14 @@ struct Logout {
     std::string username; 
 };
 
-enum class RequestType {
+enum class RequestType : uint8_t {
     Unknown = 0, 
     New = 1, 
     Modify = 2, 
-    Cancel = 3
+    Cancel = 3,
+    // internal, a modify of an order already at the exchange waiting to be sent as a cancel-replace,
+    // onData() rejects it
+    Replace = 4
 };
 
 struct OrderRequest {
@@ -33,6 +39,12 @@ struct OrderRequest {
     uint64_t orderId;
 };
 
+// One request of a basket submitted with OrderManagement::onDataBatch()
+struct BatchRequest {
+    OrderRequest request;
+    RequestType requestType;
+};
+
 enum class ResponseType {
     Unknown = 0,
     Accept = 1,
@@ -44,11 +56,9 @@ struct OrderResponse {
     ResponseType responseType; 
 };
 
-struct OrderInfo {
-    OrderRequest request;
-    bool canceledFlag;
-    uint64_t orderManagerReceiveTimeNs;
-};
+// Client that submitted an order and gets its order events (see OrderEvents.h)
+using ClientId = uint16_t;
+constexpr ClientId NO_CLIENT = 0;
 
 struct OrderStats {
     uint64_t orderManagerReceiveTimeNs;
@@ -58,8 +68,21 @@ struct OrderStats {
 
 std::ostream& operator<<(std::ostream& ofs, const OrderStats& stats);
 std::ostream& operator<<(std::ostream& ofs, const OrderResponse& response);
+// Wall clock time in ns since the epoch, TSC based where possible (see Clock.h)
 std::uint64_t getCurrentTimeNs();
 
+// Hash of an order id for the open addressing tables (murmur3 finalizer), order ids are often sequential so they
+// need proper mixing
+inline size_t hashOrderId(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return static_cast<size_t>(key);
+}
+
 } // ordermanagement namespace
 
 #endif
\ No newline at end of file
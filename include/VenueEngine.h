@@ -0,0 +1,89 @@
+// Runs several venues (exchanges) in one process.
+// The config file lists the venues (Venues=NYSE,LSE) and has a [Name] section for each of them with the
+// parameters that differ from the common ones at the top of the file: trading hours, throttle, credentials,
+// queue sizes... Every venue is an OrderManagement instance with its own queues, throttle, in flight table and
+// exchange gateway (set with getVenue(id).setExchangeSimulator()), but instead of starting threads of its own
+// it is driven by the engine (see OrderManagement::startDriven()):
+// - one session thread runs the session timers of all the venues and recalibrates the clock,
+// - TransmitterThreads threads run the transmitters. The shards of all the venues are dealt out to them
+//   round robin, every thread steps its shards in turn and waits with its own WaitStrategy, which the producers
+//   of these shards notify, until new orders arrive or the earliest throttle deadline of its shards.
+// The stats bus, the order event dispatcher (configured by the top of the file) and the clock are shared by
+// all the venues, so adding a venue costs its queues and a slot on a transmitter thread, not a process.
+// Orders are routed by VenueId, the position of the venue in Venues.
+
+#ifndef VENUE_ENGINE_H
+#define VENUE_ENGINE_H
+
+#include <atomic>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "OrderManagement.h"
+
+namespace ordermanagement {
+
+using VenueId = uint16_t;
+
+class VenueEngine {
+public:
+    // statsCollector (if not null) is subscribed to the shared stats bus, clock is shared by all the venues
+    VenueEngine(const std::string& configFileName, std::unique_ptr<IOrderStatsCollectorCallBack> statsCollector,
+                const IClock* clock = nullptr);
+    // Stops the threads, the venues then reject what is still in their queues
+    ~VenueEngine();
+
+    // Every venue needs its exchange gateway before start()
+    void start();
+    void shutDown();
+
+    size_t getVenueCount() const { return m_venues.size(); }
+    // Throws std::runtime_error if there is no venue with that name
+    VenueId getVenueId(const std::string& name) const;
+    // The config of a venue can be changed before start(), like OrderManagement::getConfig()
+    OrderManagement& getVenue(VenueId venue) { return *m_venues.at(venue); }
+    StatsBus& getStatsBus() { return m_statsBus; }
+    OrderEventDispatcher& getOrderEvents() { return m_orderEvents; }
+
+    // Any thread. Requests for an unknown venue are rejected with RejectCode::UnknownVenue.
+    void onData(VenueId venue, OrderRequest && request, RequestType requestType, ClientId clientId = NO_CLIENT);
+    // Basket of requests for one venue, see OrderManagement::onDataBatch()
+    void onDataBatch(VenueId venue, std::span<const BatchRequest> requests, std::span<RejectCode> results,
+                     ClientId clientId = NO_CLIENT);
+
+private:
+    struct TransmitterThread {
+        explicit TransmitterThread(const Config& config);
+        WaitStrategy waitStrategy;
+        // venue and shard index of the shards the thread drives
+        std::vector<std::pair<OrderManagement*, size_t>> shards;
+        std::unique_ptr<std::thread> thread;
+    };
+
+    uint64_t now() const { return m_clock ? m_clock->nowNs() : getCurrentTimeNs(); }
+    void runSessionTimers();
+    void transmit(TransmitterThread* transmitter);
+
+private:
+    // parameters at the top of the file
+    Config m_config;
+    const IClock* m_clock;
+    std::atomic_bool m_terminate = false;
+
+    WaitStrategy m_sessionWaitStrategy;
+    std::unique_ptr<std::thread> m_sessionThread;
+    std::vector<std::unique_ptr<TransmitterThread>> m_transmitters;
+
+    OrderEventDispatcher m_orderEvents;
+    StatsBus m_statsBus;
+    // declared last, the venues are destroyed before the services they use
+    std::vector<std::unique_ptr<OrderManagement>> m_venues;
+};
+
+} // ordermanagement namespace
+
+#endif
@@ -0,0 +1,87 @@
+// Wait strategies used by the threads that have nothing to do for a while:
+// the transmitter thread (empty queue or throttle limit reached), the session thread
+// (waiting for exchange open/close time) and the exchange simulator response thread.
+// BusySpin - never gives up the core, lowest wake up latency, meant for isolated cores.
+// Yield    - spins with std::this_thread::yield, lets other threads of the same core run.
+// Park     - blocks on a condition variable, ~0% CPU, the waiter is woken up by notify()
+//            as soon as new work is published, or when its deadline expires.
+// Backoff  - spins first, then yields and finally parks. When waiting for a deadline it parks
+//            only until shortly before the deadline and spins for the rest, to not oversleep.
+// Producers call notify() after publishing work. notify() is a single atomic increment
+// unless a waiter is actually parked, so it is cheap enough for the hot path.
+// Consumers call prepareWait() before checking for work and pass the returned epoch to waitForWork(),
+// so a notify() that happens between the check and the wait is never lost.
+
+#ifndef WAIT_STRATEGY_H
+#define WAIT_STRATEGY_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <limits>
+
+#include "Utils.h"
+
+namespace ordermanagement {
+
+enum class WaitStrategyType {
+    BusySpin = 0,
+    Yield = 1,
+    Park = 2,
+    Backoff = 3
+};
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+class WaitStrategy {
+public:
+    static constexpr uint64_t NO_DEADLINE = std::numeric_limits<uint64_t>::max();
+
+    WaitStrategy(WaitStrategyType type, uint32_t spinIterations, uint32_t yieldIterations);
+
+    uint64_t prepareWait() const { return m_workEpoch.load(std::memory_order_seq_cst); }
+    // Waits until notify()/interrupt() is called after prepareWait() returned epoch,
+    // or until deadlineNs (wall clock, see getCurrentTimeNs), whichever happens first
+    void waitForWork(uint64_t epoch, uint64_t deadlineNs = NO_DEADLINE);
+    // Waits until deadlineNs, ignores notify(), only interrupt() can wake it up earlier
+    void waitUntil(uint64_t deadlineNs) { waitUntil(deadlineNs, prepareWaitUntil()); }
+    // Same as above, but also returns straight away if interrupt() has been called
+    // after prepareWaitUntil() returned interruptEpoch
+    uint64_t prepareWaitUntil() const { return m_interruptEpoch.load(std::memory_order_seq_cst); }
+    void waitUntil(uint64_t deadlineNs, uint64_t interruptEpoch);
+
+    // Signals that new work has been published
+    void notify();
+    // Wakes up all the waiters regardless of what they are waiting for (state changes, termination)
+    void interrupt();
+
+    WaitStrategyType getType() const { return m_type; }
+
+private:
+    static constexpr uint64_t SPIN_THRESHOLD_NS = 100000ull; // 100 micros
+    void park(const std::atomic<uint64_t>& epochCounter, uint64_t epoch, uint64_t deadlineNs);
+    bool spinOrYield(const std::atomic<uint64_t>& epochCounter, uint64_t epoch,
+                     uint64_t deadlineNs, uint32_t iterations, bool yield);
+
+private:
+    const WaitStrategyType m_type;
+    const uint32_t m_spinIterations;
+    const uint32_t m_yieldIterations;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_workEpoch = 0;
+    std::atomic<uint64_t> m_interruptEpoch = 0;
+    std::atomic<uint32_t> m_parkedWaiters = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+};
+
+} // ordermanagement namespace
+
+#endif
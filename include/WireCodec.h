@@ -0,0 +1,285 @@
+// Binary wire format of the messages exchanged with an exchange gateway, in the spirit of SBE
+// (Simple Binary Encoding): every message is an 8 byte header (blockLength, templateId, schemaId, version)
+// followed by a fixed layout block of little endian fields.
+// The layout of a message is described by a Schema, a list of Field types, and the offset of every field is
+// computed at compile time from the sizes of the fields before it, so an Encoder/Decoder access is a constant
+// offset load/store (a memcpy that compiles to a single move) with no parsing at all. Blocks are padded to
+// 8 bytes, so that messages written back to back into a buffer stay aligned.
+// Encoder writes a message straight into the memory it is given, normally the next free bytes of a SendBuffer,
+// a preallocated buffer that is filled with messages (a whole batch of orders), written to the socket and
+// reused. Decoder is a view over a received message that reads its fields in place, strings are returned as
+// string_views into the message.
+// Messages:
+//   NewOrderMessage      (1) - OrderRequest, the price is a fixed point number with 9 decimals (PRICE_EXPONENT),
+//                              prices with up to 9 decimals below 2^53 / 10^9 (~9e6) come back exactly
+//   OrderResponseMessage (2) - OrderResponse
+//   LogonMessage         (3) - Logon, username and password up to 16 characters
+//   LogoutMessage        (4) - Logout
+//   CancelReplaceMessage (5) - OrderRequest that replaces the price, quantity and side of an order already at the
+//                              exchange (same orderId), same layout as NewOrderMessage
+// encode()/decode() functions convert the API structs, forEachMessage() splits a stream of bytes into messages.
+
+#ifndef WIRE_CODEC_H
+#define WIRE_CODEC_H
+
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "Utils.h"
+
+namespace ordermanagement {
+namespace wire {
+
+constexpr uint16_t SCHEMA_ID = 1;
+constexpr uint16_t SCHEMA_VERSION = 0;
+constexpr size_t HEADER_SIZE = 8;
+// prices are sent as mantissa * 10^PRICE_EXPONENT
+constexpr int PRICE_EXPONENT = -9;
+
+template <typename T>
+constexpr T byteSwap(T value)
+{
+    using U = std::make_unsigned_t<T>;
+    U bytes = static_cast<U>(value);
+    U swapped = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        swapped = static_cast<U>((swapped << 8) | (bytes & 0xff));
+        bytes = static_cast<U>(bytes >> 8);
+    }
+    return static_cast<T>(swapped);
+}
+
+// How a field type is stored, integers are little endian
+template <typename T>
+struct WireType {
+    static_assert(std::is_integral_v<T>, "only integer fields and fixed size strings are supported");
+    using Value = T;
+    static constexpr size_t SIZE = sizeof(T);
+
+    static void store(uint8_t* destination, T value)
+    {
+        if constexpr (std::endian::native == std::endian::big) {
+            value = byteSwap(value);
+        }
+        std::memcpy(destination, &value, sizeof(T));
+    }
+    static T load(const uint8_t* source)
+    {
+        T value;
+        std::memcpy(&value, source, sizeof(T));
+        if constexpr (std::endian::native == std::endian::big) {
+            value = byteSwap(value);
+        }
+        return value;
+    }
+};
+
+// Fixed size string, padded with zeros
+template <size_t N>
+struct Chars {};
+
+template <size_t N>
+struct WireType<Chars<N>> {
+    using Value = std::string_view;
+    static constexpr size_t SIZE = N;
+
+    // value must fit, see fits()
+    static void store(uint8_t* destination, std::string_view value)
+    {
+        std::memcpy(destination, value.data(), value.size());
+        std::memset(destination + value.size(), 0, N - value.size());
+    }
+    static std::string_view load(const uint8_t* source)
+    {
+        const char* chars = reinterpret_cast<const char*>(source);
+        const void* end = std::memchr(chars, 0, N);
+        return std::string_view(chars, end ? static_cast<const char*>(end) - chars : N);
+    }
+    static bool fits(std::string_view value) { return value.size() <= N; }
+};
+
+template <typename T>
+struct Field {
+    using Wire = WireType<T>;
+    using Value = typename Wire::Value;
+};
+
+template <uint16_t TemplateId, typename... Fields>
+struct Schema {
+    static constexpr uint16_t TEMPLATE_ID = TemplateId;
+    static constexpr size_t BLOCK_LENGTH = ((Fields::Wire::SIZE + ... + 0) + 7) / 8 * 8;
+    static constexpr size_t MESSAGE_SIZE = HEADER_SIZE + BLOCK_LENGTH;
+
+    template <typename F>
+    static constexpr size_t offsetOf()
+    {
+        static_assert((std::is_same_v<F, Fields> || ...), "the field is not part of the message");
+        size_t offset = 0;
+        bool found = false;
+        ((found = found || std::is_same_v<F, Fields>, offset += found ? 0 : Fields::Wire::SIZE), ...);
+        return offset;
+    }
+};
+
+struct MessageHeader {
+    uint16_t blockLength;
+    uint16_t templateId;
+    uint16_t schemaId;
+    uint16_t version;
+};
+
+// Writes a message of schema S at the start of buffer, which must have S::MESSAGE_SIZE bytes
+template <typename S>
+class Encoder {
+public:
+    explicit Encoder(uint8_t* buffer)
+        : m_block(buffer + HEADER_SIZE)
+    {
+        WireType<uint16_t>::store(buffer, static_cast<uint16_t>(S::BLOCK_LENGTH));
+        WireType<uint16_t>::store(buffer + 2, S::TEMPLATE_ID);
+        WireType<uint16_t>::store(buffer + 4, SCHEMA_ID);
+        WireType<uint16_t>::store(buffer + 6, SCHEMA_VERSION);
+        // padding goes out as zeros
+        std::memset(m_block, 0, S::BLOCK_LENGTH);
+    }
+
+    template <typename F>
+    Encoder& set(typename F::Value value)
+    {
+        F::Wire::store(m_block + S::template offsetOf<F>(), value);
+        return *this;
+    }
+
+private:
+    uint8_t* m_block;
+};
+
+// Reads the fields of a message of schema S in place, the message must outlive the decoder
+template <typename S>
+class Decoder {
+public:
+    explicit Decoder(const uint8_t* message)
+        : m_block(message + HEADER_SIZE)
+    {
+    }
+
+    template <typename F>
+    typename F::Value get() const
+    {
+        return F::Wire::load(m_block + S::template offsetOf<F>());
+    }
+
+private:
+    const uint8_t* m_block;
+};
+
+// Fields
+struct OrderId : Field<uint64_t> {};
+struct PriceMantissa : Field<int64_t> {};
+struct Quantity : Field<uint64_t> {};
+struct SymbolId : Field<int32_t> {};
+struct OrderSide : Field<char> {};
+struct ResponseKind : Field<uint8_t> {};
+struct Username : Field<Chars<16>> {};
+struct Password : Field<Chars<16>> {};
+
+// Messages, 8 byte fields first so that they are aligned
+using NewOrderMessage = Schema<1, OrderId, PriceMantissa, Quantity, SymbolId, OrderSide>;
+using OrderResponseMessage = Schema<2, OrderId, ResponseKind>;
+using LogonMessage = Schema<3, Username, Password>;
+using LogoutMessage = Schema<4, Username>;
+using CancelReplaceMessage = Schema<5, OrderId, PriceMantissa, Quantity, SymbolId, OrderSide>;
+
+static_assert(NewOrderMessage::MESSAGE_SIZE == 40 && NewOrderMessage::offsetOf<OrderSide>() == 28);
+static_assert(OrderResponseMessage::MESSAGE_SIZE == 24 && LogonMessage::MESSAGE_SIZE == 40);
+
+// Preallocated buffer messages are encoded into back to back until it is sent, then it is cleared and reused
+class SendBuffer {
+public:
+    explicit SendBuffer(size_t capacity)
+        : m_data(std::make_unique<uint8_t[]>(capacity))
+        , m_capacity(capacity)
+    {
+    }
+
+    // Space for the next message of schema S, nullptr if the buffer is full
+    template <typename S>
+    uint8_t* reserve()
+    {
+        if (m_size + S::MESSAGE_SIZE > m_capacity) {
+            return nullptr;
+        }
+        uint8_t* message = m_data.get() + m_size;
+        m_size += S::MESSAGE_SIZE;
+        return message;
+    }
+
+    const uint8_t* data() const { return m_data.get(); }
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+    void clear() { m_size = 0; }
+
+private:
+    std::unique_ptr<uint8_t[]> m_data;
+    size_t m_capacity;
+    size_t m_size = 0;
+};
+
+// Return false if the buffer is full (or the strings of Logon/Logout are too long), the buffer is unchanged then
+bool encode(const OrderRequest& request, SendBuffer& buffer);
+bool encode(const OrderResponse& response, SendBuffer& buffer);
+bool encode(const Logon& logon, SendBuffer& buffer);
+bool encode(const Logout& logout, SendBuffer& buffer);
+// request as a CancelReplaceMessage
+bool encodeReplace(const OrderRequest& request, SendBuffer& buffer);
+
+// Returns false if bytes don't start with a whole header
+bool readHeader(std::span<const uint8_t> bytes, MessageHeader& header);
+
+// message must be a whole message of the matching schema (see forEachMessage), decodeOrderRequest() decodes
+// NewOrderMessage and CancelReplaceMessage
+OrderRequest decodeOrderRequest(const uint8_t* message);
+OrderResponse decodeOrderResponse(const uint8_t* message);
+Logon decodeLogon(const uint8_t* message);
+Logout decodeLogout(const uint8_t* message);
+
+// Calls handler(header, message) for every whole message at the start of bytes and returns the number of bytes
+// consumed, an incomplete message at the end is left for the next call. Messages of other schemas and messages
+// whose block is shorter than the one of their template are skipped.
+template <typename Handler>
+size_t forEachMessage(std::span<const uint8_t> bytes, Handler&& handler)
+{
+    size_t consumed = 0;
+    MessageHeader header;
+    while (readHeader(bytes.subspan(consumed), header)
+           && consumed + HEADER_SIZE + header.blockLength <= bytes.size()) {
+        const uint8_t* message = bytes.data() + consumed;
+        consumed += HEADER_SIZE + header.blockLength;
+        if (header.schemaId != SCHEMA_ID) {
+            continue;
+        }
+        const bool complete = ((header.templateId == NewOrderMessage::TEMPLATE_ID
+                                || header.templateId == CancelReplaceMessage::TEMPLATE_ID)
+                               && header.blockLength >= NewOrderMessage::BLOCK_LENGTH)
+            || (header.templateId == OrderResponseMessage::TEMPLATE_ID
+                && header.blockLength >= OrderResponseMessage::BLOCK_LENGTH)
+            || (header.templateId == LogonMessage::TEMPLATE_ID && header.blockLength >= LogonMessage::BLOCK_LENGTH)
+            || (header.templateId == LogoutMessage::TEMPLATE_ID && header.blockLength >= LogoutMessage::BLOCK_LENGTH);
+        if (complete) {
+            handler(header, message);
+        }
+    }
+    return consumed;
+}
+
+} // wire namespace
+} // ordermanagement namespace
+
+#endif
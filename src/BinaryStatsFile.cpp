@@ -0,0 +1,121 @@
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "BinaryStatsFile.h"
+
+namespace ordermanagement {
+
+namespace {
+size_t fileSizeFor(uint64_t capacity)
+{
+    return sizeof(BinaryStatsFileHeader) + capacity * sizeof(BinaryStatsRecord);
+}
+} // unnamed namespace
+
+BinaryStatsFileWriterCallback::BinaryStatsFileWriterCallback(const std::string& filename, uint64_t initialCapacity)
+{
+    m_fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0) {
+        throw std::runtime_error("Can't open stats file " + filename);
+    }
+    map(std::max<uint64_t>(initialCapacity, 1));
+    auto* header = static_cast<BinaryStatsFileHeader*>(m_mapping);
+    std::memcpy(header->magic, BINARY_STATS_MAGIC, sizeof(header->magic));
+    header->version = BINARY_STATS_VERSION;
+    header->recordSize = sizeof(BinaryStatsRecord);
+    header->recordCount = 0;
+    header->createTimeNs = getCurrentTimeNs();
+}
+
+BinaryStatsFileWriterCallback::~BinaryStatsFileWriterCallback()
+{
+    ::msync(m_mapping, m_mappingSize, MS_SYNC);
+    ::munmap(m_mapping, m_mappingSize);
+    // cut off the preallocated space that hasn't been used
+    if (::ftruncate(m_fd, fileSizeFor(m_recordCount)) != 0) {
+        // nothing to do, readers only look at recordCount records anyway
+    }
+    ::close(m_fd);
+}
+
+void BinaryStatsFileWriterCallback::map(uint64_t capacity)
+{
+    const size_t newSize = fileSizeFor(capacity);
+    if (::ftruncate(m_fd, newSize) != 0) {
+        throw std::runtime_error("Can't extend stats file");
+    }
+    void* mapping = m_mapping == nullptr
+        ? ::mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0)
+        : ::mremap(m_mapping, m_mappingSize, newSize, MREMAP_MAYMOVE);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Can't map stats file");
+    }
+    m_mapping = mapping;
+    m_mappingSize = newSize;
+    m_capacity = capacity;
+}
+
+void BinaryStatsFileWriterCallback::processOrderStatisticsInfo(OrderResponse && response,
+                                                               const OrderStats& orderInfo)
+{
+    if (m_recordCount == m_capacity) {
+        map(m_capacity * 2);
+    }
+    auto* header = static_cast<BinaryStatsFileHeader*>(m_mapping);
+    auto* records = reinterpret_cast<BinaryStatsRecord*>(header + 1);
+    records[m_recordCount] = BinaryStatsRecord{response.orderId,
+                                               orderInfo.orderManagerReceiveTimeNs,
+                                               orderInfo.requestSendTimeNs,
+                                               orderInfo.responseReceivalTimeNs,
+                                               static_cast<uint8_t>(response.responseType), {}};
+    ++m_recordCount;
+    std::atomic_ref<uint64_t>(header->recordCount).store(m_recordCount, std::memory_order_release);
+}
+
+void BinaryStatsFileWriterCallback::flush()
+{
+    ::msync(m_mapping, m_mappingSize, MS_ASYNC);
+}
+
+MappedStatsFile::MappedStatsFile(const std::string& filename)
+{
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open stats file " + filename);
+    }
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(BinaryStatsFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Stats file " + filename + " is too short");
+    }
+    m_mappingSize = fileStat.st_size;
+    m_mapping = ::mmap(nullptr, m_mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_mapping == MAP_FAILED) {
+        throw std::runtime_error("Can't map stats file " + filename);
+    }
+    const auto& fileHeader = header();
+    if (std::memcmp(fileHeader.magic, BINARY_STATS_MAGIC, sizeof(fileHeader.magic)) != 0
+        || fileHeader.version != BINARY_STATS_VERSION
+        || fileHeader.recordSize != sizeof(BinaryStatsRecord)) {
+        ::munmap(m_mapping, m_mappingSize);
+        throw std::runtime_error(filename + " is not a supported stats file");
+    }
+    const uint64_t recordCount = std::min<uint64_t>(
+        std::atomic_ref<const uint64_t>(fileHeader.recordCount).load(std::memory_order_acquire),
+        (m_mappingSize - sizeof(BinaryStatsFileHeader)) / sizeof(BinaryStatsRecord));
+    m_records = std::span<const BinaryStatsRecord>(
+        reinterpret_cast<const BinaryStatsRecord*>(&fileHeader + 1), recordCount);
+}
+
+MappedStatsFile::~MappedStatsFile()
+{
+    ::munmap(m_mapping, m_mappingSize);
+}
+
+} // ordermanagement namespace
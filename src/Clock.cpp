@@ -0,0 +1,228 @@
+#include <atomic>
+#include <mutex>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define ORDER_MANAGEMENT_HAS_TSC 1
+#endif
+
+#include "Clock.h"
+#include "Utils.h"
+
+namespace ordermanagement {
+
+namespace {
+
+constexpr uint64_t CALIBRATION_TIME_NS = 5000000;
+constexpr uint32_t MULTIPLIER_SHIFT = 32;
+// TSC frequencies outside of this range mean that the TSC can't be trusted
+constexpr double MIN_TICKS_PER_NS = 0.1;
+constexpr double MAX_TICKS_PER_NS = 10.0;
+
+uint64_t readClock(clockid_t clockId)
+{
+    timespec time;
+    clock_gettime(clockId, &time);
+    return static_cast<uint64_t>(time.tv_sec) * NS_IN_SECOND + time.tv_nsec;
+}
+
+#ifdef ORDER_MANAGEMENT_HAS_TSC
+bool hasInvariantTsc()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) {
+        return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+}
+
+uint64_t readTsc()
+{
+    return __rdtsc();
+}
+#else
+bool hasInvariantTsc()
+{
+    return false;
+}
+
+uint64_t readTsc()
+{
+    return 0;
+}
+#endif
+
+// rdtsc can be trapped or slowed down by a hypervisor, then the conversion on top of it makes
+// the TSC path slower than the vDSO clock_gettime. Native rdtsc is several times faster.
+bool isTscFasterThanClockGettime()
+{
+    constexpr int READS = 1000;
+    uint64_t sink = 0;
+    const uint64_t start = readClock(CLOCK_MONOTONIC);
+    for (int read = 0; read < READS; ++read) {
+        sink += readTsc();
+    }
+    const uint64_t tscDone = readClock(CLOCK_MONOTONIC);
+    for (int read = 0; read < READS; ++read) {
+        sink += readClock(CLOCK_REALTIME);
+    }
+    const uint64_t clockDone = readClock(CLOCK_MONOTONIC);
+    return sink != 0 && 2 * (tscDone - start) < clockDone - tscDone;
+}
+
+struct ClockSample {
+    uint64_t tsc;
+    uint64_t realTimeNs;
+    uint64_t monotonicNs;
+};
+
+// The TSC is read on both sides of the clock_gettime calls, the tightest of a few attempts is used
+ClockSample takeSample()
+{
+    ClockSample best{};
+    uint64_t bestSpread = UINT64_MAX;
+    for (int attempt = 0; attempt < 5; ++attempt) {
+        const uint64_t before = readTsc();
+        const uint64_t monotonicNs = readClock(CLOCK_MONOTONIC);
+        const uint64_t realTimeNs = readClock(CLOCK_REALTIME);
+        const uint64_t after = readTsc();
+        if (after - before < bestSpread) {
+            bestSpread = after - before;
+            best = ClockSample{before + (after - before) / 2, realTimeNs, monotonicNs};
+        }
+    }
+    return best;
+}
+
+class TscClock {
+public:
+    TscClock()
+        : m_useTsc(hasInvariantTsc() && isTscFasterThanClockGettime())
+    {
+        if (!m_useTsc) {
+            return;
+        }
+        m_reference = takeSample();
+        while (readClock(CLOCK_MONOTONIC) - m_reference.monotonicNs < CALIBRATION_TIME_NS) {
+        }
+        calibrate();
+    }
+
+    bool usesTsc() const { return m_useTsc.load(std::memory_order_relaxed); }
+
+    uint64_t nowNs() const
+    {
+        if (!usesTsc()) {
+            return readClock(CLOCK_REALTIME);
+        }
+        const uint64_t tsc = readTsc();
+        for (;;) {
+            const uint32_t sequence = m_sequence.load(std::memory_order_acquire);
+            const uint64_t tscBase = m_tscBase.load(std::memory_order_relaxed);
+            const uint64_t nsBase = m_nsBase.load(std::memory_order_relaxed);
+            const uint64_t multiplier = m_multiplier.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((sequence & 1) == 0 && m_sequence.load(std::memory_order_relaxed) == sequence) {
+                // the TSC can be read slightly before the base of a concurrent calibration
+                const int64_t ticks = static_cast<int64_t>(tsc - tscBase);
+                const auto ns = static_cast<__int128>(ticks) * multiplier >> MULTIPLIER_SHIFT;
+                return nsBase + static_cast<int64_t>(ns);
+            }
+        }
+    }
+
+    uint64_t ticks() const
+    {
+        return usesTsc() ? readTsc() : readClock(CLOCK_MONOTONIC);
+    }
+
+    uint64_t ticksToNs(uint64_t ticks) const
+    {
+        if (!usesTsc()) {
+            return ticks;
+        }
+        return static_cast<unsigned __int128>(ticks) * m_multiplier.load(std::memory_order_relaxed)
+            >> MULTIPLIER_SHIFT;
+    }
+
+    void calibrate()
+    {
+        if (!usesTsc()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_calibrationMutex);
+        const ClockSample sample = takeSample();
+        // the frequency is measured over the whole time since the clock was created against
+        // the monotonic clock, which runs at the NTP disciplined rate but is never stepped, the wall clock only provides the anchor
+        const uint64_t elapsedTicks = sample.tsc - m_reference.tsc;
+        const uint64_t elapsedNs = sample.monotonicNs - m_reference.monotonicNs;
+        const double ticksPerNs = static_cast<double>(elapsedTicks) / elapsedNs;
+        if (elapsedTicks == 0 || ticksPerNs < MIN_TICKS_PER_NS || ticksPerNs > MAX_TICKS_PER_NS) {
+            // the TSC doesn't behave, nobody has seen the TSC based time yet if this is the first calibration
+            m_useTsc.store(m_multiplier.load(std::memory_order_relaxed) != 0, std::memory_order_relaxed);
+            return;
+        }
+        const uint64_t multiplier = static_cast<uint64_t>(
+            (static_cast<unsigned __int128>(elapsedNs) << MULTIPLIER_SHIFT) / elapsedTicks);
+
+        const uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_tscBase.store(sample.tsc, std::memory_order_relaxed);
+        m_nsBase.store(sample.realTimeNs, std::memory_order_relaxed);
+        m_multiplier.store(multiplier, std::memory_order_relaxed);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+private:
+    std::atomic_bool m_useTsc;
+    ClockSample m_reference{};
+    std::mutex m_calibrationMutex;
+    // seqlock protected conversion parameters, ns = nsBase + (tsc - tscBase) * multiplier >> MULTIPLIER_SHIFT
+    std::atomic<uint32_t> m_sequence = 0;
+    std::atomic<uint64_t> m_tscBase = 0;
+    std::atomic<uint64_t> m_nsBase = 0;
+    std::atomic<uint64_t> m_multiplier = 0;
+};
+
+TscClock& tscClock()
+{
+    static TscClock clock;
+    return clock;
+}
+
+} // unnamed namespace
+
+std::uint64_t getCurrentTimeNs()
+{
+    return tscClock().nowNs();
+}
+
+uint64_t getMonotonicTicks()
+{
+    return tscClock().ticks();
+}
+
+uint64_t ticksToNs(uint64_t ticks)
+{
+    return tscClock().ticksToNs(ticks);
+}
+
+void calibrateClock()
+{
+    tscClock().calibrate();
+}
+
+bool isTscClock()
+{
+    return tscClock().usesTsc();
+}
+
+uint64_t SystemClock::nowNs() const
+{
+    return getCurrentTimeNs();
+}
+
+} // ordermanagement namespace
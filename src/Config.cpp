@@ -1,6 +1,7 @@
 #include "Config.h"
 #include "iostream"
 #include <vector>
+#include <algorithm>
 #include <unordered_map>
 
 namespace ordermanagement {
@@ -37,30 +38,327 @@ uint64_t getTime(std::string time)
         (hours * 60 * 60 + mins * 60 + secs);
     return offset;
 }
+
+IngressMode getIngressMode(const std::string& mode)
+{
+    if (mode == "Locked") {
+        return IngressMode::Locked;
+    } else if (mode == "Ring") {
+        return IngressMode::Ring;
+    }
+    throw std::runtime_error("Invalid config, unknown IngressMode " + mode);
+}
+
+OverflowPolicy getOverflowPolicy(const std::string& policy)
+{
+    if (policy == "Reject") {
+        return OverflowPolicy::Reject;
+    } else if (policy == "Block") {
+        return OverflowPolicy::Block;
+    } else if (policy == "Spill") {
+        return OverflowPolicy::Spill;
+    }
+    throw std::runtime_error("Invalid config, unknown overflow policy " + policy);
+}
+
+ThrottleMode getThrottleMode(const std::string& mode)
+{
+    if (mode == "SlidingWindow") {
+        return ThrottleMode::SlidingWindow;
+    } else if (mode == "Gcra") {
+        return ThrottleMode::Gcra;
+    }
+    throw std::runtime_error("Invalid config, unknown ThrottleMode " + mode);
+}
+
+LatencyModelType getLatencyModelType(const std::string& type)
+{
+    if (type == "Fixed") {
+        return LatencyModelType::Fixed;
+    } else if (type == "LogNormal") {
+        return LatencyModelType::LogNormal;
+    } else if (type == "Histogram") {
+        return LatencyModelType::Histogram;
+    }
+    throw std::runtime_error("Invalid config, unknown ExchangeLatencyModel " + type);
+}
+
+WaitStrategyType getWaitStrategyType(const std::string& type)
+{
+    if (type == "BusySpin") {
+        return WaitStrategyType::BusySpin;
+    } else if (type == "Yield") {
+        return WaitStrategyType::Yield;
+    } else if (type == "Park") {
+        return WaitStrategyType::Park;
+    } else if (type == "Backoff") {
+        return WaitStrategyType::Backoff;
+    }
+    throw std::runtime_error("Invalid config, unknown WaitStrategy " + type);
+}
+
+JournalSyncPolicy getJournalSyncPolicy(const std::string& policy)
+{
+    if (policy == "None") {
+        return JournalSyncPolicy::None;
+    } else if (policy == "Periodic") {
+        return JournalSyncPolicy::Periodic;
+    } else if (policy == "EveryRecord") {
+        return JournalSyncPolicy::EveryRecord;
+    }
+    throw std::runtime_error("Invalid config, unknown JournalSyncPolicy " + policy);
+}
+
+bool getBool(const std::string& value)
+{
+    if (value == "true") {
+        return true;
+    } else if (value == "false") {
+        return false;
+    }
+    throw std::runtime_error("Invalid config, expected true or false but got " + value);
+}
+
+// Sessions=<open>-<close>,<open>-<close>,...
+std::vector<TradingSession> getSessions(const std::string& sessionsParam)
+{
+    std::vector<TradingSession> sessions;
+    std::istringstream iss{sessionsParam};
+    std::string session;
+    while (std::getline(iss, session, ',')) {
+        auto pos = session.find('-');
+        if (pos == std::string::npos) {
+            throw std::runtime_error("Invalid config, session must be in <open>-<close> format");
+        }
+        sessions.push_back(TradingSession{getTime(session.substr(0, pos)), getTime(session.substr(pos + 1))});
+    }
+    if (sessions.empty()) {
+        throw std::runtime_error("Invalid config, Sessions is empty");
+    }
+    return sessions;
+}
+
+uint32_t getPriceDecimals(const std::string& decimals)
+{
+    // 10^9 ticks already don't fit in int32_t
+    const uint32_t priceDecimals = std::stoul(decimals);
+    if (priceDecimals > 9) {
+        throw std::runtime_error("Price decimals can't be more than 9");
+    }
+    return priceDecimals;
+}
+
+std::vector<std::string> getNames(const std::string& namesParam)
+{
+    std::vector<std::string> names;
+    std::istringstream iss{namesParam};
+    std::string name;
+    while (std::getline(iss, name, ',')) {
+        if (!name.empty()) {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+// symbolId:decimals,symbolId:decimals...
+std::vector<std::pair<int32_t, uint32_t>> getSymbolPriceDecimals(const std::string& decimalsParam)
+{
+    std::vector<std::pair<int32_t, uint32_t>> symbolDecimals;
+    for (const auto& symbolParam : getNames(decimalsParam)) {
+        auto pos = symbolParam.find(':');
+        if (pos == std::string::npos) {
+            throw std::runtime_error("Invalid SymbolPriceDecimals " + symbolParam);
+        }
+        symbolDecimals.emplace_back(std::stoi(symbolParam.substr(0, pos)),
+                                    getPriceDecimals(symbolParam.substr(pos + 1)));
+    }
+    return symbolDecimals;
+}
 } // unnamend namespace
 
-Config::Config(const std::string& configFileName)
+Config::Config(const std::string& configFileName, const std::string& section)
 {
     std::ifstream ifs(configFileName);
     std::string line;
     std::unordered_map<std::string, std::string> params;
+    std::unordered_map<std::string, std::string> sectionParams;
+    std::string currentSection;
+    bool sectionFound = section.empty();
     while(std::getline(ifs, line)) {
-        if(!line.empty() && line[0] != '#') {
+        if(!line.empty() && line[0] == '[') {
+            auto pos = line.find(']');
+            if(pos == std::string::npos) {
+                throw std::runtime_error("Parser Error");
+            }
+            currentSection = line.substr(1, pos - 1);
+            sectionFound = sectionFound || currentSection == section;
+        } else if(!line.empty() && line[0] != '#') {
             auto pos = line.find('=');
             if(pos == std::string::npos) {
                 throw std::runtime_error("Parser Error");
             }
             std::string paramName = line.substr(0, pos);
             std::string paramVal = line.substr(pos + 1);
-            params.emplace(paramName, paramVal);
+            if (currentSection.empty()) {
+                params.emplace(paramName, paramVal);
+            } else if (currentSection == section) {
+                sectionParams[paramName] = paramVal;
+            }
         }
     }
-    openTimeOffsetFromDayStartNs = getTime(params["Open"]);
-    closeTimeOffsetFromDayStartNs = getTime(params["Close"]);
+    if (!sectionFound) {
+        throw std::runtime_error("Invalid config, no [" + section + "] section");
+    }
+    for (auto& [paramName, paramVal] : sectionParams) {
+        params[paramName] = paramVal;
+    }
+    if (params.count("Sessions")) {
+        sessions = getSessions(params["Sessions"]);
+        openTimeOffsetFromDayStartNs = sessions.front().openTimeOffsetFromDayStartNs;
+        closeTimeOffsetFromDayStartNs = sessions.front().closeTimeOffsetFromDayStartNs;
+    } else {
+        openTimeOffsetFromDayStartNs = getTime(params["Open"]);
+        closeTimeOffsetFromDayStartNs = getTime(params["Close"]);
+    }
     windowSizeSec = std::stoul(params["MonitorWindowSec"]);
     throttlingRate = std::stoul(params["Rate"]);
     username = params["Username"];
     password = params["Password"];
+
+    if (params.count("IngressMode")) {
+        ingressMode = getIngressMode(params["IngressMode"]);
+    }
+    if (params.count("IngressRingSize")) {
+        ingressRingSize = std::stoul(params["IngressRingSize"]);
+    }
+    if (params.count("IngressOverflowPolicy")) {
+        ingressOverflowPolicy = getOverflowPolicy(params["IngressOverflowPolicy"]);
+    }
+    if (params.count("OrderPoolSize")) {
+        orderPoolSize = std::stoul(params["OrderPoolSize"]);
+    }
+    if (params.count("ShardCount")) {
+        shardCount = std::max(1ul, std::stoul(params["ShardCount"]));
+    }
+    if (params.count("PriceDecimals")) {
+        priceDecimals = getPriceDecimals(params["PriceDecimals"]);
+    }
+    if (params.count("SymbolPriceDecimals")) {
+        symbolPriceDecimals = getSymbolPriceDecimals(params["SymbolPriceDecimals"]);
+    }
+    if (params.count("InFlightTableSize")) {
+        inFlightTableSize = std::stoul(params["InFlightTableSize"]);
+        if (inFlightTableSize == 0) {
+            // no order could ever be sent
+            throw std::runtime_error("Invalid config, InFlightTableSize must be at least 1");
+        }
+    }
+    if (params.count("ThrottleMode")) {
+        throttleMode = getThrottleMode(params["ThrottleMode"]);
+    }
+    if (params.count("ThrottleBurst")) {
+        throttleBurst = std::stoul(params["ThrottleBurst"]);
+    }
+    if (params.count("RatePerSecond")) {
+        ratePerSecond = std::stoul(params["RatePerSecond"]);
+    }
+    if (params.count("WaitStrategy")) {
+        waitStrategy = getWaitStrategyType(params["WaitStrategy"]);
+    }
+    if (params.count("WaitSpinIterations")) {
+        waitSpinIterations = std::stoul(params["WaitSpinIterations"]);
+    }
+    if (params.count("WaitYieldIterations")) {
+        waitYieldIterations = std::stoul(params["WaitYieldIterations"]);
+    }
+    if (params.count("TransmitBatching")) {
+        transmitBatching = getBool(params["TransmitBatching"]);
+    }
+    if (params.count("MaxTransmitBatchSize")) {
+        maxTransmitBatchSize = std::max(1ul, std::stoul(params["MaxTransmitBatchSize"]));
+    }
+    if (params.count("StatsRingSize")) {
+        statsRingSize = std::stoul(params["StatsRingSize"]);
+    }
+    if (params.count("StatsFlushIntervalMs")) {
+        statsFlushIntervalMs = std::stoull(params["StatsFlushIntervalMs"]);
+    }
+    if (params.count("StatsOverflowPolicy")) {
+        statsOverflowPolicy = getOverflowPolicy(params["StatsOverflowPolicy"]);
+    }
+    if (params.count("OrderEventQueueSize")) {
+        orderEventQueueSize = std::stoul(params["OrderEventQueueSize"]);
+    }
+    if (params.count("OrderEventOverflowPolicy")) {
+        orderEventOverflowPolicy = getOverflowPolicy(params["OrderEventOverflowPolicy"]);
+    }
+    if (params.count("ExchangeLatencyModel")) {
+        exchangeLatencyModel = getLatencyModelType(params["ExchangeLatencyModel"]);
+    }
+    if (params.count("ExchangeLatencyNs")) {
+        exchangeLatencyNs = std::stoull(params["ExchangeLatencyNs"]);
+    }
+    if (params.count("ExchangeLatencySigma")) {
+        exchangeLatencySigma = std::stod(params["ExchangeLatencySigma"]);
+    }
+    if (params.count("ExchangeLatencyFile")) {
+        exchangeLatencyFile = params["ExchangeLatencyFile"];
+    }
+    if (params.count("ExchangeRejectRatio")) {
+        exchangeRejectRatio = std::stod(params["ExchangeRejectRatio"]);
+    }
+    if (params.count("ExchangeRateLimit")) {
+        exchangeRateLimit = std::stoul(params["ExchangeRateLimit"]);
+    }
+    if (params.count("ExchangeRateWindowMs")) {
+        exchangeRateWindowMs = std::max(1ull, std::stoull(params["ExchangeRateWindowMs"]));
+    }
+    if (params.count("ExchangeResponseThreads")) {
+        exchangeResponseThreads = std::max(1ul, std::stoul(params["ExchangeResponseThreads"]));
+    }
+    if (params.count("ExchangeAddress")) {
+        exchangeAddress = params["ExchangeAddress"];
+    }
+    if (params.count("GatewayReconnectIntervalMs")) {
+        gatewayReconnectIntervalMs = std::max(1ull, std::stoull(params["GatewayReconnectIntervalMs"]));
+    }
+    if (params.count("GatewaySendBufferSize")) {
+        gatewaySendBufferSize = std::stoul(params["GatewaySendBufferSize"]);
+    }
+    if (params.count("GatewayReadBufferSize")) {
+        gatewayReadBufferSize = std::stoul(params["GatewayReadBufferSize"]);
+    }
+    if (params.count("Venues")) {
+        venues = getNames(params["Venues"]);
+    }
+    if (params.count("TransmitterThreads")) {
+        transmitterThreads = std::max(1ul, std::stoul(params["TransmitterThreads"]));
+    }
+    if (params.count("ClockCalibrationIntervalMs")) {
+        clockCalibrationIntervalMs = std::stoull(params["ClockCalibrationIntervalMs"]);
+    }
+    if (params.count("TimerPrecisionNs")) {
+        timerPrecisionNs = std::stoull(params["TimerPrecisionNs"]);
+    }
+    if (params.count("JournalFile")) {
+        journalFile = params["JournalFile"];
+    }
+    if (params.count("JournalCapacity")) {
+        journalCapacity = std::max(1ull, std::stoull(params["JournalCapacity"]));
+    }
+    if (params.count("JournalSyncPolicy")) {
+        journalSyncPolicy = getJournalSyncPolicy(params["JournalSyncPolicy"]);
+    }
+    if (params.count("JournalSyncIntervalMs")) {
+        journalSyncIntervalMs = std::max(1ull, std::stoull(params["JournalSyncIntervalMs"]));
+    }
+    if (params.count("JournalSnapshotIntervalMs")) {
+        journalSnapshotIntervalMs = std::stoull(params["JournalSnapshotIntervalMs"]);
+    }
+    if (params.count("JournalReconcileTimeoutMs")) {
+        journalReconcileTimeoutMs = std::stoull(params["JournalReconcileTimeoutMs"]);
+    }
 }
 
 void Config::dumpConfig() const
@@ -70,7 +368,58 @@ void Config::dumpConfig() const
               << "windowSizeSec=" << windowSizeSec << "\n"
               << "throttlingRate=" << throttlingRate << "\n"
               << "username=" << username << "\n"
-              << "password=" << password << "\n";
+              << "password=" << password << "\n"
+              << "ingressMode=" << static_cast<int>(ingressMode) << "\n"
+              << "ingressRingSize=" << ingressRingSize << "\n"
+              << "ingressOverflowPolicy=" << static_cast<int>(ingressOverflowPolicy) << "\n"
+              << "orderPoolSize=" << orderPoolSize << "\n"
+              << "shardCount=" << shardCount << "\n"
+              << "priceDecimals=" << priceDecimals << "\n"
+              << "inFlightTableSize=" << inFlightTableSize << "\n"
+              << "throttleMode=" << static_cast<int>(throttleMode) << "\n"
+              << "throttleBurst=" << throttleBurst << "\n"
+              << "ratePerSecond=" << ratePerSecond << "\n"
+              << "waitStrategy=" << static_cast<int>(waitStrategy) << "\n"
+              << "waitSpinIterations=" << waitSpinIterations << "\n"
+              << "waitYieldIterations=" << waitYieldIterations << "\n"
+              << "timerPrecisionNs=" << timerPrecisionNs << "\n"
+              << "transmitBatching=" << transmitBatching << "\n"
+              << "maxTransmitBatchSize=" << maxTransmitBatchSize << "\n"
+              << "statsRingSize=" << statsRingSize << "\n"
+              << "statsFlushIntervalMs=" << statsFlushIntervalMs << "\n"
+              << "statsOverflowPolicy=" << static_cast<int>(statsOverflowPolicy) << "\n"
+              << "orderEventQueueSize=" << orderEventQueueSize << "\n"
+              << "orderEventOverflowPolicy=" << static_cast<int>(orderEventOverflowPolicy) << "\n"
+              << "exchangeLatencyModel=" << static_cast<int>(exchangeLatencyModel) << "\n"
+              << "exchangeLatencyNs=" << exchangeLatencyNs << "\n"
+              << "exchangeLatencySigma=" << exchangeLatencySigma << "\n"
+              << "exchangeLatencyFile=" << exchangeLatencyFile << "\n"
+              << "exchangeRejectRatio=" << exchangeRejectRatio << "\n"
+              << "exchangeRateLimit=" << exchangeRateLimit << "\n"
+              << "exchangeRateWindowMs=" << exchangeRateWindowMs << "\n"
+              << "exchangeResponseThreads=" << exchangeResponseThreads << "\n"
+              << "exchangeAddress=" << exchangeAddress << "\n"
+              << "gatewayReconnectIntervalMs=" << gatewayReconnectIntervalMs << "\n"
+              << "gatewaySendBufferSize=" << gatewaySendBufferSize << "\n"
+              << "gatewayReadBufferSize=" << gatewayReadBufferSize << "\n"
+              << "transmitterThreads=" << transmitterThreads << "\n"
+              << "clockCalibrationIntervalMs=" << clockCalibrationIntervalMs << "\n"
+              << "journalFile=" << journalFile << "\n"
+              << "journalCapacity=" << journalCapacity << "\n"
+              << "journalSyncPolicy=" << static_cast<int>(journalSyncPolicy) << "\n"
+              << "journalSyncIntervalMs=" << journalSyncIntervalMs << "\n"
+              << "journalSnapshotIntervalMs=" << journalSnapshotIntervalMs << "\n"
+              << "journalReconcileTimeoutMs=" << journalReconcileTimeoutMs << "\n";
+    for (const auto& [symbolId, decimals] : symbolPriceDecimals) {
+        std::cout << "symbolPriceDecimals=" << symbolId << ":" << decimals << "\n";
+    }
+    for (const auto& venue : venues) {
+        std::cout << "venue=" << venue << "\n";
+    }
+    for (const auto& session : sessions) {
+        std::cout << "session=" << session.openTimeOffsetFromDayStartNs
+                  << "-" << session.closeTimeOffsetFromDayStartNs << "\n";
+    }
 }
 
 } // ordermangement namespace
\ No newline at end of file
@@ -1,5 +1,5 @@
 #include "ExchangeSimulator.h"
-#include <iostream>
+#include "Logger.h"
 #include <algorithm>
 #include <chrono>
 
@@ -7,17 +7,35 @@ namespace ordermanagement {
 
 ExchangeResponseSimulator::ExchangeResponseSimulator(OrderManagement* manager) 
     : m_manager(manager)
+    , m_waitStrategy(manager->getConfig().waitStrategy,
+                     manager->getConfig().waitSpinIterations,
+                     manager->getConfig().waitYieldIterations)
     , m_rd()
     , m_gen(m_rd())
-    , m_distr(0, static_cast<int>(ResponseType::Reject) + 1)
+    , m_distr(static_cast<int>(ResponseType::Accept), static_cast<int>(ResponseType::Reject))
 {
     m_respondThread = std::make_unique<std::thread>(&ExchangeResponseSimulator::respond, this);
 }
 
+ExchangeResponseSimulator::ExchangeResponseSimulator(OrderManagement* manager, const IClock* simulationClock,
+                                                     uint64_t responseLatencyNs, uint32_t seed)
+    : m_manager(manager)
+    , m_simulationClock(simulationClock)
+    , m_responseLatencyNs(responseLatencyNs)
+    , m_waitStrategy(WaitStrategyType::BusySpin, 0, 0)
+    , m_rd()
+    , m_gen(seed)
+    , m_distr(static_cast<int>(ResponseType::Accept), static_cast<int>(ResponseType::Reject))
+{
+}
+
 ExchangeResponseSimulator::~ExchangeResponseSimulator()
 {
-    m_terminated = true;
-    m_respondThread->join();
+    if (m_respondThread) {
+        m_terminated = true;
+        m_waitStrategy.interrupt();
+        m_respondThread->join();
+    }
 }
 
 void ExchangeResponseSimulator::sendLogon(const Logon& logon) {
@@ -28,25 +46,66 @@ void ExchangeResponseSimulator::sendLogout(const Logout& logon) {
     m_loggedIn = false;
 }
 
+void ExchangeResponseSimulator::addRequest(const OrderRequest& request) {
+    if (m_simulationClock) {
+        m_requests.push(PendingResponse{request.orderId, m_simulationClock->nowNs() + m_responseLatencyNs});
+        return;
+    }
+    m_requests.push(PendingResponse{request.orderId, 0});
+    OM_LOG_INFO("Exchange got {}", request.orderId);
+}
+
 void ExchangeResponseSimulator::send(const OrderRequest& request) {
-    std::unique_lock<std::mutex> locker(m_requestsLock);
-    m_requests.push(request.orderId);
-    std::cout << "Exchange got " << request.orderId << std::endl;
+    {
+        std::unique_lock<std::mutex> locker(m_requestsLock);
+        addRequest(request);
+    }
+    m_waitStrategy.notify();
+}
+
+void ExchangeResponseSimulator::sendBatch(std::span<const OrderRequest> requests) {
+    {
+        std::unique_lock<std::mutex> locker(m_requestsLock);
+        for (const auto& request : requests) {
+            addRequest(request);
+        }
+    }
+    m_waitStrategy.notify();
+}
+
+void ExchangeResponseSimulator::respondTo(uint64_t orderId) {
+    ResponseType responseType = static_cast<ResponseType>(m_distr(m_gen));
+    OrderResponse response{orderId, responseType};
+    m_manager->onData(std::move(response));
+}
+
+uint64_t ExchangeResponseSimulator::respondDue() {
+    const uint64_t currentTime = m_simulationClock->nowNs();
+    while (!m_requests.empty() && m_requests.front().dueTimeNs <= currentTime) {
+        const uint64_t orderId = m_requests.front().orderId;
+        m_requests.pop();
+        respondTo(orderId);
+    }
+    return m_requests.empty() ? WaitStrategy::NO_DEADLINE : m_requests.front().dueTimeNs;
 }
 
 void ExchangeResponseSimulator::respond() {
+    std::queue<PendingResponse> requests;
     while(!m_terminated) {
+        const uint64_t waitEpoch = m_waitStrategy.prepareWait();
         {
+            // takes everything that has been sent so far, the responses are sent without holding the lock
             std::unique_lock<std::mutex> locker(m_requestsLock);
-            if (!m_requests.empty()) {
-                uint64_t orderId = m_requests.front();
-                m_requests.pop();
-                ResponseType responseType = static_cast<ResponseType>(m_distr(m_gen));
-                OrderResponse response{orderId, responseType};
-                m_manager->onData(std::move(response));
-            }
+            requests.swap(m_requests);
+        }
+        if (requests.empty()) {
+            m_waitStrategy.waitForWork(waitEpoch);
+            continue;
+        }
+        while (!requests.empty()) {
+            respondTo(requests.front().orderId);
+            requests.pop();
         }
-        std::this_thread::sleep_for(std::chrono::microseconds(1));
     }
 }
 
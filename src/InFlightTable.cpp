@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "InFlightTable.h"
+#include "WaitStrategy.h"
+
+namespace ordermanagement {
+
+InFlightTable::InFlightTable(uint32_t maxOrdersInFlight)
+    : m_maxOrdersInFlight(maxOrdersInFlight)
+{
+    if (maxOrdersInFlight == 0) {
+        throw std::runtime_error("In flight table size can't be 0");
+    }
+    size_t capacity = 16;
+    while (capacity < static_cast<size_t>(maxOrdersInFlight) * 2) {
+        capacity <<= 1;
+    }
+    m_mask = capacity - 1;
+    m_entries = std::make_unique<Entry[]>(capacity);
+}
+
+uint32_t InFlightTable::reserve(uint32_t count)
+{
+    // the slots are taken before the probe, so concurrent writers can't get past maxOrdersInFlight together
+    size_t size = m_size.load(std::memory_order_relaxed);
+    uint32_t reserved;
+    do {
+        if (size >= m_maxOrdersInFlight) {
+            return 0;
+        }
+        reserved = static_cast<uint32_t>(std::min<size_t>(count, m_maxOrdersInFlight - size));
+    } while (!m_size.compare_exchange_weak(size, size + reserved, std::memory_order_relaxed));
+    return reserved;
+}
+
+void InFlightTable::insertReserved(uint64_t orderId, const OrderStats& stats, ClientId clientId, bool replace)
+{
+    // At most maxOrdersInFlight entries are taken (a completed entry is Free before its slot is given back) out
+    // of at least twice as many, so the probe always ends at an Empty or Free entry
+    const size_t home = hashOrderId(orderId) & m_mask;
+    for (size_t probe = 0; ; ++probe) {
+        Entry& entry = m_entries[(home + probe) & m_mask];
+        uint32_t state = entry.state.load(std::memory_order_acquire);
+        if ((state != Empty && state != Free)
+            || !entry.state.compare_exchange_strong(state, Reserved, std::memory_order_acquire)) {
+            continue;
+        }
+        // nobody reads the stats of an entry that is not InFlight, so they can be written as is
+        entry.orderId.store(orderId, std::memory_order_relaxed);
+        entry.orderManagerReceiveTimeNs = stats.orderManagerReceiveTimeNs;
+        entry.requestSendTimeNs = stats.requestSendTimeNs;
+        entry.clientId = clientId;
+        entry.replace = replace;
+        size_t maxProbe = m_maxProbe.load(std::memory_order_relaxed);
+        while (probe > maxProbe
+               && !m_maxProbe.compare_exchange_weak(maxProbe, probe, std::memory_order_release,
+                                                    std::memory_order_relaxed)) {
+        }
+        entry.state.store(InFlight, std::memory_order_release);
+        return;
+    }
+}
+
+InFlightTable::Entry* InFlightTable::claim(uint64_t orderId, uint32_t& previousState)
+{
+    const size_t home = hashOrderId(orderId) & m_mask;
+    const size_t maxProbe = m_maxProbe.load(std::memory_order_acquire);
+    for (size_t probe = 0; probe <= maxProbe; ) {
+        Entry& entry = m_entries[(home + probe) & m_mask];
+        uint32_t state = entry.state.load(std::memory_order_acquire);
+        if (state == Empty) {
+            return nullptr;
+        }
+        // a Reserved entry can't hold the order yet, it is only answered after its insert() has returned
+        if (state == Free || state == Reserved || entry.orderId.load(std::memory_order_acquire) != orderId) {
+            ++probe;
+            continue;
+        }
+        if (state == Completing) {
+            // another thread is completing (or marking) this entry, wait to see whether it was our order
+            cpuRelax();
+            continue;
+        }
+        if (!entry.state.compare_exchange_strong(state, Completing, std::memory_order_acq_rel)) {
+            continue;
+        }
+        // the entry could have been completed and reused for another order between
+        // the orderId check and the CAS, in that case give it back
+        if (entry.orderId.load(std::memory_order_relaxed) != orderId) {
+            entry.state.store(state, std::memory_order_release);
+            ++probe;
+            continue;
+        }
+        previousState = state;
+        return &entry;
+    }
+    return nullptr;
+}
+
+bool InFlightTable::complete(uint64_t orderId, OrderStats& stats, ClientId& clientId, bool& amended,
+                             bool& replace)
+{
+    uint32_t previousState;
+    Entry* entry = claim(orderId, previousState);
+    if (!entry) {
+        return false;
+    }
+    stats = OrderStats{entry->orderManagerReceiveTimeNs, entry->requestSendTimeNs, 0};
+    clientId = entry->clientId;
+    amended = previousState == Amended;
+    replace = entry->replace;
+    entry->state.store(Free, std::memory_order_release);
+    m_size.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool InFlightTable::markAmended(uint64_t orderId)
+{
+    uint32_t previousState;
+    Entry* entry = claim(orderId, previousState);
+    if (!entry) {
+        return false;
+    }
+    entry->state.store(Amended, std::memory_order_release);
+    return true;
+}
+
+} // ordermanagement namespace
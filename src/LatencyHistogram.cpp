@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cmath>
+
+#include "LatencyHistogram.h"
+
+namespace ordermanagement {
+
+uint64_t LatencyHistogram::bucketLowestValue(size_t index)
+{
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const uint64_t shift = index / SUB_BUCKETS - 1;
+    return (index - SUB_BUCKETS * shift) << shift;
+}
+
+uint64_t LatencyHistogram::bucketWidth(size_t index)
+{
+    if (index < SUB_BUCKETS) {
+        return 1;
+    }
+    return 1ull << (index / SUB_BUCKETS - 1);
+}
+
+LatencyHistogram::LatencyHistogram()
+    : m_counts(BUCKET_COUNT, 0)
+{
+}
+
+void LatencyHistogram::record(uint64_t value, uint64_t count)
+{
+    addToBucket(bucketIndex(value), count);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+        m_counts[index] += other.m_counts[index];
+    }
+    m_totalCount += other.m_totalCount;
+}
+
+void LatencyHistogram::reset()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_totalCount = 0;
+}
+
+uint64_t LatencyHistogram::valueAtPercentile(double percentile) const
+{
+    if (m_totalCount == 0) {
+        return 0;
+    }
+    const double clampedPercentile = std::clamp(percentile, 0.0, 100.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(
+        std::ceil(clampedPercentile / 100.0 * m_totalCount)));
+    uint64_t seen = 0;
+    for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+        seen += m_counts[index];
+        if (seen >= rank) {
+            return bucketLowestValue(index) + bucketWidth(index) / 2;
+        }
+    }
+    return maxValue();
+}
+
+uint64_t LatencyHistogram::maxValue() const
+{
+    for (size_t index = BUCKET_COUNT; index-- > 0; ) {
+        if (m_counts[index] != 0) {
+            return bucketLowestValue(index) + bucketWidth(index) - 1;
+        }
+    }
+    return 0;
+}
+
+double LatencyHistogram::mean() const
+{
+    if (m_totalCount == 0) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+        if (m_counts[index] != 0) {
+            sum += static_cast<double>(m_counts[index])
+                * (bucketLowestValue(index) + bucketWidth(index) / 2);
+        }
+    }
+    return sum / m_totalCount;
+}
+
+} // ordermanagement namespace
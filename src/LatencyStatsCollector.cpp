@@ -0,0 +1,161 @@
+#include <iomanip>
+
+#include "LatencyStatsCollector.h"
+
+namespace ordermanagement {
+
+namespace {
+std::atomic<uint64_t> nextCollectorId = 1;
+
+struct RecorderCache {
+    uint64_t collectorId = 0;
+    void* recorder = nullptr;
+};
+thread_local RecorderCache recorderCache;
+
+size_t responseTypeIndex(ResponseType type)
+{
+    const auto index = static_cast<size_t>(type);
+    return index < LatencySnapshot::RESPONSE_TYPES ? index : static_cast<size_t>(ResponseType::Unknown);
+}
+
+uint64_t elapsed(uint64_t from, uint64_t to)
+{
+    return to > from ? to - from : 0;
+}
+
+constexpr const char* RESPONSE_TYPE_NAMES[LatencySnapshot::RESPONSE_TYPES] = {"Unknown", "Accept", "Reject"};
+} // unnamed namespace
+
+LatencyStatsCollectorCallback::LatencyStatsCollectorCallback()
+    : m_id(nextCollectorId.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+LatencyStatsCollectorCallback::Recorder& LatencyStatsCollectorCallback::localRecorder()
+{
+    if (recorderCache.collectorId == m_id) {
+        return *static_cast<Recorder*>(recorderCache.recorder);
+    }
+    // first order recorded by this thread, or the thread alternates between several collectors
+    std::lock_guard<std::mutex> lock(m_recordersMutex);
+    const auto threadId = std::this_thread::get_id();
+    Recorder* recorder = nullptr;
+    for (auto& existing : m_recorders) {
+        if (existing->owner == threadId) {
+            recorder = existing.get();
+        }
+    }
+    if (recorder == nullptr) {
+        m_recorders.push_back(std::make_unique<Recorder>(threadId));
+        recorder = m_recorders.back().get();
+    }
+    recorderCache = RecorderCache{m_id, recorder};
+    return *recorder;
+}
+
+void LatencyStatsCollectorCallback::recycle(SecondSlot& slot, uint64_t second)
+{
+    slot.second.store(SecondSlot::RECYCLING, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t index = 0; index < HISTOGRAMS * LatencyHistogram::BUCKET_COUNT; ++index) {
+        slot.buckets.counts[index].store(0, std::memory_order_relaxed);
+    }
+    slot.second.store(second, std::memory_order_release);
+}
+
+void LatencyStatsCollectorCallback::processOrderStatisticsInfo(OrderResponse && response,
+                                                               const OrderStats& orderInfo)
+{
+    Recorder& recorder = localRecorder();
+    const size_t type = responseTypeIndex(response.responseType);
+    const size_t queueWaitIndex = type * LatencyHistogram::BUCKET_COUNT + LatencyHistogram::bucketIndex(
+        elapsed(orderInfo.orderManagerReceiveTimeNs, orderInfo.requestSendTimeNs));
+    const size_t roundTripIndex = (LatencySnapshot::RESPONSE_TYPES + type) * LatencyHistogram::BUCKET_COUNT
+        + LatencyHistogram::bucketIndex(elapsed(orderInfo.requestSendTimeNs, orderInfo.responseReceivalTimeNs));
+
+    recorder.session.increment(queueWaitIndex);
+    recorder.session.increment(roundTripIndex);
+    const uint64_t second = orderInfo.responseReceivalTimeNs / NS_IN_SECOND;
+    SecondSlot& slot = recorder.seconds[second % SECOND_SLOTS];
+    if (slot.second.load(std::memory_order_relaxed) != second) {
+        recycle(slot, second);
+    }
+    slot.buckets.increment(queueWaitIndex);
+    slot.buckets.increment(roundTripIndex);
+}
+
+template <typename Count>
+void LatencyStatsCollectorCallback::addTo(LatencySnapshot& snapshot, const Count* counts)
+{
+    for (size_t histogram = 0; histogram < HISTOGRAMS; ++histogram) {
+        auto& target = histogram < LatencySnapshot::RESPONSE_TYPES
+            ? snapshot.queueWait[histogram]
+            : snapshot.roundTrip[histogram - LatencySnapshot::RESPONSE_TYPES];
+        const Count* histogramCounts = counts + histogram * LatencyHistogram::BUCKET_COUNT;
+        for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+            if (histogramCounts[bucket] != 0) {
+                target.addToBucket(bucket, histogramCounts[bucket]);
+            }
+        }
+    }
+}
+
+LatencySnapshot LatencyStatsCollectorCallback::snapshot(StatsWindow window, uint64_t currentTimeNs) const
+{
+    constexpr size_t SIZE = HISTOGRAMS * LatencyHistogram::BUCKET_COUNT;
+    LatencySnapshot result;
+    const uint64_t currentSecond = currentTimeNs / NS_IN_SECOND;
+    const uint64_t windowSeconds = window == StatsWindow::LastSecond ? 1 : WINDOW_SECONDS;
+    std::vector<uint64_t> sessionCounts(window == StatsWindow::Session ? SIZE : 0);
+    std::vector<uint32_t> secondCounts(window == StatsWindow::Session ? 0 : SIZE);
+
+    std::lock_guard<std::mutex> lock(m_recordersMutex);
+    for (const auto& recorder : m_recorders) {
+        if (window == StatsWindow::Session) {
+            for (size_t index = 0; index < SIZE; ++index) {
+                sessionCounts[index] = recorder->session.counts[index].load(std::memory_order_relaxed);
+            }
+            addTo(result, sessionCounts.data());
+            continue;
+        }
+        for (const auto& slot : recorder->seconds) {
+            const uint64_t second = slot.second.load(std::memory_order_acquire);
+            if (second == SecondSlot::RECYCLING || second >= currentSecond || second + windowSeconds < currentSecond) {
+                continue;
+            }
+            for (size_t index = 0; index < SIZE; ++index) {
+                secondCounts[index] = slot.buckets.counts[index].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // the slot has been recycled for a newer second while it was copied
+            if (slot.second.load(std::memory_order_relaxed) != second) {
+                continue;
+            }
+            addTo(result, secondCounts.data());
+        }
+    }
+    return result;
+}
+
+void LatencyStatsCollectorCallback::printSummary(std::ostream& out, StatsWindow window) const
+{
+    const LatencySnapshot latencySnapshot = snapshot(window);
+    auto printHistogram = [&out](const char* name, const char* responseType, const LatencyHistogram& histogram) {
+        if (histogram.totalCount() == 0) {
+            return;
+        }
+        out << std::setw(10) << name << " " << std::setw(8) << responseType
+            << " count=" << histogram.totalCount()
+            << " p50=" << histogram.valueAtPercentile(50.0)
+            << " p99=" << histogram.valueAtPercentile(99.0)
+            << " p99.9=" << histogram.valueAtPercentile(99.9)
+            << " max=" << histogram.maxValue() << " (ns)" << std::endl;
+    };
+    for (size_t type = 0; type < LatencySnapshot::RESPONSE_TYPES; ++type) {
+        printHistogram("QueueWait", RESPONSE_TYPE_NAMES[type], latencySnapshot.queueWait[type]);
+        printHistogram("RoundTrip", RESPONSE_TYPE_NAMES[type], latencySnapshot.roundTrip[type]);
+    }
+}
+
+} // ordermanagement namespace
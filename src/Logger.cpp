@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+
+#include "Logger.h"
+
+namespace ordermanagement {
+
+namespace {
+constexpr const char* LEVEL_NAMES[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+void appendTime(std::string& output, uint64_t timestampNs)
+{
+    const uint64_t timeOfDayNs = timestampNs % NS_IN_DAY;
+    const uint64_t seconds = timeOfDayNs / NS_IN_SECOND;
+    char buffer[32];
+    const int length = std::snprintf(buffer, sizeof(buffer), "%02u:%02u:%02u.%06u ",
+                                     static_cast<unsigned>(seconds / 3600), static_cast<unsigned>(seconds / 60 % 60),
+                                     static_cast<unsigned>(seconds % 60),
+                                     static_cast<unsigned>(timeOfDayNs % NS_IN_SECOND / 1000));
+    output.append(buffer, length);
+}
+
+// Appends the next argument of the record payload, returns the offset of the one after it
+size_t appendArg(std::string& output, const LogRecord& record, size_t offset)
+{
+    const auto type = static_cast<LogArgType>(record.payload[offset++]);
+    if (type == LogArgType::String) {
+        const size_t length = record.payload[offset++];
+        output.append(reinterpret_cast<const char*>(record.payload + offset), length);
+        return offset + length;
+    }
+    uint64_t value;
+    std::memcpy(&value, record.payload + offset, sizeof(value));
+    switch (type) {
+        case LogArgType::Int:
+            output += std::to_string(static_cast<int64_t>(value));
+            break;
+        case LogArgType::UInt:
+            output += std::to_string(value);
+            break;
+        case LogArgType::Double: {
+                double doubleValue;
+                std::memcpy(&doubleValue, &value, sizeof(doubleValue));
+                char buffer[32];
+                output.append(buffer, std::snprintf(buffer, sizeof(buffer), "%g", doubleValue));
+            }
+            break;
+        default:
+            output += static_cast<char>(value);
+            break;
+    }
+    return offset + sizeof(value);
+}
+
+// Flush requests wait on it, they are rare so a plain condition variable is good enough
+std::mutex flushMutex;
+std::condition_variable flushCondition;
+} // unnamed namespace
+
+Logger::Logger()
+    // the formatter is not latency critical, it should not spin
+    : m_waitStrategy(WaitStrategyType::Park, 0, 0)
+{
+    m_formatterThread = std::make_unique<std::thread>(&Logger::formatRecords, this);
+}
+
+Logger::~Logger()
+{
+    m_terminate = true;
+    m_waitStrategy.interrupt();
+    m_formatterThread->join();
+}
+
+Logger& Logger::instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+uint32_t Logger::registerFormat(LogLevel level, const char* format)
+{
+    Logger& logger = instance();
+    std::lock_guard<std::mutex> lock(logger.m_formatsMutex);
+    logger.m_formats.push_back(LogFormat{level, format});
+    return static_cast<uint32_t>(logger.m_formats.size() - 1);
+}
+
+Logger::ThreadLog& Logger::threadLog()
+{
+    struct ThreadLogHolder {
+        ~ThreadLogHolder()
+        {
+            if (log) {
+                log->retired.store(true, std::memory_order_release);
+            }
+        }
+        std::shared_ptr<ThreadLog> log;
+    };
+    thread_local ThreadLogHolder holder;
+    if (!holder.log) {
+        holder.log = std::make_shared<ThreadLog>();
+        Logger& logger = instance();
+        std::lock_guard<std::mutex> lock(logger.m_threadLogsMutex);
+        logger.m_threadLogs.push_back(holder.log);
+    }
+    return *holder.log;
+}
+
+LogRecord* Logger::claim(ThreadLog& log)
+{
+    const uint64_t head = log.head.load(std::memory_order_relaxed);
+    if (head - log.cachedTail == THREAD_RING_SIZE) {
+        log.cachedTail = log.tail.load(std::memory_order_acquire);
+        if (head - log.cachedTail == THREAD_RING_SIZE) {
+            return nullptr;
+        }
+    }
+    return &log.records[head & (THREAD_RING_SIZE - 1)];
+}
+
+void Logger::encodeString(LogRecord& record, std::string_view arg)
+{
+    if (record.size + size_t{2} > LogRecord::PAYLOAD_SIZE) {
+        return;
+    }
+    // long strings are truncated to what fits into the record (and the one byte length)
+    const size_t length = std::min({arg.size(), LogRecord::PAYLOAD_SIZE - record.size - 2, size_t{255}});
+    record.payload[record.size] = static_cast<uint8_t>(LogArgType::String);
+    record.payload[record.size + 1] = static_cast<uint8_t>(length);
+    std::memcpy(record.payload + record.size + 2, arg.data(), length);
+    record.size += 2 + length;
+    ++record.argCount;
+}
+
+void Logger::flush()
+{
+    Logger& logger = instance();
+    if (logger.m_terminate) {
+        return;
+    }
+    const uint64_t request = logger.m_flushRequests.fetch_add(1, std::memory_order_acq_rel) + 1;
+    logger.m_waitStrategy.interrupt();
+    std::unique_lock<std::mutex> lock(flushMutex);
+    flushCondition.wait(lock, [&logger, request]() {
+        return logger.m_flushedRequests.load(std::memory_order_acquire) >= request;
+    });
+}
+
+void Logger::formatRecords()
+{
+    while (!m_terminate) {
+        const uint64_t interruptEpoch = m_waitStrategy.prepareWaitUntil();
+        // everything logged before the flush requests has been published by now
+        const uint64_t flushRequests = m_flushRequests.load(std::memory_order_acquire);
+        drain();
+        if (flushRequests > m_flushedRequests.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard<std::mutex> lock(flushMutex);
+                m_flushedRequests.store(flushRequests, std::memory_order_release);
+            }
+            flushCondition.notify_all();
+        }
+        // loggers don't notify, the formatter wakes up every DRAIN_INTERVAL_NS and drains whatever
+        // has been accumulated, flush() and termination interrupt the wait
+        m_waitStrategy.waitUntil(getCurrentTimeNs() + DRAIN_INTERVAL_NS, interruptEpoch);
+    }
+    drain();
+    {
+        std::lock_guard<std::mutex> lock(flushMutex);
+        m_flushedRequests.store(m_flushRequests.load(std::memory_order_acquire), std::memory_order_release);
+    }
+    flushCondition.notify_all();
+}
+
+void Logger::drain()
+{
+    std::vector<std::shared_ptr<ThreadLog>> threadLogs;
+    {
+        std::lock_guard<std::mutex> lock(m_threadLogsMutex);
+        threadLogs = m_threadLogs;
+    }
+    std::string infoOutput;
+    std::string errorOutput;
+    std::vector<ThreadLog*> drainedRetiredLogs;
+    for (const auto& log : threadLogs) {
+        // checked before draining, so that a record published just before the retirement isn't lost
+        const bool retired = log->retired.load(std::memory_order_acquire);
+        const uint64_t head = log->head.load(std::memory_order_acquire);
+        uint64_t tail = log->tail.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail) {
+            formatRecord(log->records[tail & (THREAD_RING_SIZE - 1)], infoOutput, errorOutput);
+        }
+        log->tail.store(tail, std::memory_order_release);
+        const uint64_t dropped = log->dropped.load(std::memory_order_relaxed);
+        if (dropped != log->reportedDropped) {
+            errorOutput += "Logger dropped " + std::to_string(dropped - log->reportedDropped)
+                         + " records, the log ring was full\n";
+            log->reportedDropped = dropped;
+        }
+        if (retired) {
+            drainedRetiredLogs.push_back(log.get());
+        }
+    }
+    if (!drainedRetiredLogs.empty()) {
+        std::lock_guard<std::mutex> lock(m_threadLogsMutex);
+        std::erase_if(m_threadLogs, [&drainedRetiredLogs](const auto& log) {
+            return std::find(drainedRetiredLogs.begin(), drainedRetiredLogs.end(), log.get())
+                != drainedRetiredLogs.end();
+        });
+    }
+    if (!infoOutput.empty()) {
+        std::cout << infoOutput;
+        std::cout.flush();
+    }
+    if (!errorOutput.empty()) {
+        std::cerr << errorOutput;
+    }
+}
+
+void Logger::formatRecord(const LogRecord& record, std::string& infoOutput, std::string& errorOutput)
+{
+    if (record.formatId >= m_knownFormats.size()) {
+        std::lock_guard<std::mutex> lock(m_formatsMutex);
+        m_knownFormats.assign(m_formats.begin(), m_formats.end());
+    }
+    const LogFormat& format = m_knownFormats[record.formatId];
+    std::string& output = format.level >= LogLevel::Warning ? errorOutput : infoOutput;
+    appendTime(output, record.timestampNs);
+    output += LEVEL_NAMES[static_cast<size_t>(format.level)];
+    output += ' ';
+    size_t offset = 0;
+    uint8_t arg = 0;
+    const std::string_view text = format.format;
+    for (size_t position = 0; position < text.size(); ++position) {
+        if (text[position] == '{' && position + 1 < text.size() && text[position + 1] == '}') {
+            if (arg < record.argCount) {
+                offset = appendArg(output, record, offset);
+                ++arg;
+            }
+            ++position;
+        } else {
+            output += text[position];
+        }
+    }
+    output += '\n';
+}
+
+} // ordermanagement namespace
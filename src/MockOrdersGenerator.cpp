@@ -1,7 +1,7 @@
 #include "MockOrdersGenerator.h"
 #include "OrderManagement.h"
+#include "Logger.h"
 #include <random>
-#include <iostream>
 
 namespace ordermanagement {
 
@@ -14,36 +14,86 @@ MockOrdersGenerator::MockOrdersGenerator(OrderManagement* orderManager, uint8_t
     m_generatorThread = std::make_unique<std::thread>(&MockOrdersGenerator::generateOrders, this);
 }
 
+MockOrdersGenerator::MockOrdersGenerator(OrderManagement* orderManager, uint8_t prefix, bool simulation) 
+    : m_orderManager(orderManager)
+    , m_clientPrefix(prefix)
+    , m_terminate(false) 
+    , m_orderSeqNum(0)
+    , m_verbose(!simulation)
+{
+    if (!simulation) {
+        m_generatorThread = std::make_unique<std::thread>(&MockOrdersGenerator::generateOrders, this);
+    }
+}
+
+MockOrdersGenerator::MockOrdersGenerator(OrderManagement* orderManager, uint8_t prefix,
+                                         uint64_t requestPauseNs, bool verbose, ClientId clientId) 
+    : m_orderManager(orderManager)
+    , m_clientPrefix(prefix)
+    , m_terminate(false) 
+    , m_orderSeqNum(0)
+    , m_requestPauseNs(requestPauseNs)
+    , m_verbose(verbose)
+    , m_clientId(clientId)
+{
+    m_generatorThread = std::make_unique<std::thread>(&MockOrdersGenerator::generateOrders, this);
+}
+
 MockOrdersGenerator::~MockOrdersGenerator()
 {
     m_terminate = true;
-    m_generatorThread->join();
+    if (m_generatorThread) {
+        m_generatorThread->join();
+    }
 }
 
 void MockOrdersGenerator::generateOrders()
 {
+    // the schedule is absolute, time spent in onData() is not added to the pause
+    uint64_t nextRequestTime = getCurrentTimeNs();
     while(!m_terminate) {
-        OrderRequest nextRequest;
-        auto nextId = getNextSeqNumber();
-        if (nextId % 10 == 1) {
-            // Every 10th order will be canceled
-            nextRequest.orderId = nextId - 1;
-            std::cout << "sending cancel for " << nextRequest.orderId << std::endl;
-            m_orderManager->onData(std::move(nextRequest), RequestType::Cancel);
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        nextRequestTime += sendNextRequest();
+        const uint64_t currentTime = getCurrentTimeNs();
+        if (nextRequestTime > currentTime) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(nextRequestTime - currentTime));
         }
-        if (nextId % 10 == 6) {
+    }
+}
+
+uint64_t MockOrdersGenerator::sendNextRequest()
+{
+    // prices and quantities have to be representable internally (see PackedOrder.h)
+    OrderRequest nextRequest{0, 100.25, 100, 'B', 0};
+    if (!m_newOrderPending) {
+        m_pendingOrderId = getNextSeqNumber();
+        if (m_pendingOrderId % 10 == 1) {
             // Every 10th order will be canceled
-            nextRequest.orderId = nextId - 1;
-            std::cout << "sending modify for " << nextRequest.orderId << std::endl;
-            m_orderManager->onData(std::move(nextRequest), RequestType::Modify);
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            nextRequest.orderId = m_pendingOrderId - 1;
+            if (m_verbose) {
+                OM_LOG_INFO("sending cancel for {}", nextRequest.orderId);
+            }
+            m_orderManager->onData(std::move(nextRequest), RequestType::Cancel, m_clientId);
+            m_newOrderPending = true;
+            return m_requestPauseNs;
+        }
+        if (m_pendingOrderId % 10 == 6) {
+            // Every 10th order will be modified
+            nextRequest.orderId = m_pendingOrderId - 1;
+            if (m_verbose) {
+                OM_LOG_INFO("sending modify for {}", nextRequest.orderId);
+            }
+            m_orderManager->onData(std::move(nextRequest), RequestType::Modify, m_clientId);
+            m_newOrderPending = true;
+            return m_requestPauseNs;
         }
-        nextRequest.orderId = nextId;
-        std::cout << "sending " << nextRequest.orderId << std::endl;
-        m_orderManager->onData(std::move(nextRequest), RequestType::New);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
+    nextRequest.orderId = m_pendingOrderId;
+    if (m_verbose) {
+        OM_LOG_INFO("sending {}", nextRequest.orderId);
+    }
+    m_orderManager->onData(std::move(nextRequest), RequestType::New, m_clientId);
+    m_newOrderPending = false;
+    return m_requestPauseNs;
 }
 
 uint64_t MockOrdersGenerator::getNextSeqNumber()
@@ -0,0 +1,122 @@
+#include "OrderEvents.h"
+
+namespace ordermanagement {
+
+const char* rejectCodeText(RejectCode code)
+{
+    switch (code) {
+        case RejectCode::None: return "Not rejected";
+        case RejectCode::ExchangeClosed: return "Exchange is closed";
+        case RejectCode::UnknownRequestType: return "Unknown request type";
+        case RejectCode::IngressQueueFull: return "Ingress queue is full";
+        case RejectCode::ClosedWhileQueued: return "Exchange got closed while order was in the queue";
+        case RejectCode::Terminated: return "Terminate has been called";
+        case RejectCode::TooLateToModify: return "Can't modify order, it is neither queued nor in flight";
+        case RejectCode::TooLateToCancel: return "Can't cancel order, it has already been submitted to the exchange";
+        case RejectCode::ExchangeReject: return "Rejected by the exchange";
+        case RejectCode::UnknownExchangeResponse: return "Unknown response from the exchange";
+        case RejectCode::UnknownVenue: return "Unknown venue";
+        case RejectCode::InvalidOrder: return "Invalid price, quantity or side";
+        case RejectCode::SymbolChanged: return "Can't modify the symbol of an order";
+        case RejectCode::Unreconciled: return "Order was in flight at the restart and the exchange didn't answer it";
+        case RejectCode::JournalFull: return "Order journal is full until it is rolled";
+    }
+    return "Unknown reject code";
+}
+
+OrderEventDispatcher::Client::Client(std::unique_ptr<IOrderEventListener> listener, size_t queueSize,
+                                     const Config& config)
+    : listener(std::move(listener))
+    // clients react to their events, the delivery thread idles like the transmitter does
+    , events(queueSize, config.orderEventOverflowPolicy, config.waitStrategy, config.waitSpinIterations,
+             config.waitYieldIterations)
+{
+}
+
+OrderEventDispatcher::OrderEventDispatcher(const Config& config)
+    : m_config(config)
+{
+}
+
+OrderEventDispatcher::~OrderEventDispatcher()
+{
+    for (auto& client : m_ownedClients) {
+        if (client) {
+            client->events.stopDelivery();
+        }
+    }
+}
+
+ClientId OrderEventDispatcher::registerClient(std::unique_ptr<IOrderEventListener> listener, size_t queueSize)
+{
+    return addClient(std::move(listener), queueSize);
+}
+
+ClientId OrderEventDispatcher::registerPollingClient(size_t queueSize)
+{
+    return addClient(nullptr, queueSize);
+}
+
+ClientId OrderEventDispatcher::addClient(std::unique_ptr<IOrderEventListener> listener, size_t queueSize)
+{
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    for (size_t slot = 0; slot < MAX_CLIENTS; ++slot) {
+        if (m_ownedClients[slot]) {
+            continue;
+        }
+        auto client = std::make_unique<Client>(std::move(listener),
+                                               queueSize == 0 ? m_config.orderEventQueueSize : queueSize, m_config);
+        if (IOrderEventListener* eventListener = client->listener.get()) {
+            client->events.startDelivery(
+                [eventListener](std::span<OrderEvent> events) { eventListener->onOrderEvents(events); },
+                nullptr, 0, DELIVERY_BATCH_SIZE);
+        }
+        m_clients[slot].store(client.get(), std::memory_order_release);
+        m_ownedClients[slot] = std::move(client);
+        return static_cast<ClientId>(slot + 1);
+    }
+    return NO_CLIENT;
+}
+
+OrderEventDispatcher::Client* OrderEventDispatcher::findClient(ClientId clientId) const
+{
+    if (clientId == NO_CLIENT || clientId > MAX_CLIENTS) {
+        return nullptr;
+    }
+    return m_clients[clientId - 1].load(std::memory_order_acquire);
+}
+
+void OrderEventDispatcher::publishToClient(ClientId clientId, const OrderEvent& event)
+{
+    Client* client = findClient(clientId);
+    if (client == nullptr) {
+        return;
+    }
+    // listeners react to their events right away
+    client->events.push(event, client->listener != nullptr);
+}
+
+size_t OrderEventDispatcher::poll(ClientId clientId, std::span<OrderEvent> events)
+{
+    Client* client = findClient(clientId);
+    if (client == nullptr || client->listener) {
+        return 0;
+    }
+    size_t polled = 0;
+    return client->events.consume([&](OrderEvent& event) { events[polled++] = event; }, events.size());
+}
+
+ClientStats OrderEventDispatcher::getClientStats(ClientId clientId) const
+{
+    ClientStats stats;
+    const Client* client = findClient(clientId);
+    if (client == nullptr) {
+        return stats;
+    }
+    stats.delivered = client->events.delivered();
+    stats.dropped = client->events.dropped();
+    stats.published = client->events.published();
+    return stats;
+}
+
+} // ordermanagement namespace
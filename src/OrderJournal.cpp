@@ -0,0 +1,471 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "OrderJournal.h"
+#include "Logger.h"
+
+namespace ordermanagement {
+
+namespace {
+// m_nextRecord while the journal is being rolled, appends wait until it is below again
+constexpr uint64_t APPENDS_SUSPENDED = 1ull << 62;
+
+size_t fileSizeFor(uint64_t capacity)
+{
+    return sizeof(JournalFileHeader) + capacity * sizeof(JournalRecord);
+}
+
+bool readAll(int fd, void* data, size_t size)
+{
+    auto* bytes = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t result = ::read(fd, bytes, size);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        bytes += result;
+        size -= result;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const void* data, size_t size)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t result = ::write(fd, bytes, size);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        bytes += result;
+        size -= result;
+    }
+    return true;
+}
+
+// so that the rename of a snapshot survives a crash of the host
+void syncDirectoryOf(const std::string& filename)
+{
+    const std::string directory = std::filesystem::path(filename).parent_path().string();
+    const int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+} // unnamed namespace
+
+uint64_t OrderJournal::reservedRecords(const Config& config)
+{
+    return RECORDS_PER_LIVE_ORDER
+        * (static_cast<uint64_t>(config.orderPoolSize) * config.shardCount + config.inFlightTableSize);
+}
+
+OrderJournal::OrderJournal(const Config& config)
+    : m_filename(config.journalFile)
+    , m_syncPolicy(config.journalSyncPolicy)
+{
+    m_fd = ::open(m_filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+        throw std::runtime_error("Can't open journal file " + m_filename);
+    }
+    const auto fail = [this](const std::string& reason) {
+        ::close(m_fd);
+        throw std::runtime_error(reason);
+    };
+    struct stat fileStat;
+    if (::fstat(m_fd, &fileStat) != 0) {
+        fail("Can't open journal file " + m_filename);
+    }
+    const bool created = fileStat.st_size == 0;
+    if (created) {
+        m_capacity = config.journalCapacity;
+    } else {
+        JournalFileHeader fileHeader;
+        if (!readAll(m_fd, &fileHeader, sizeof(fileHeader))
+            || std::memcmp(fileHeader.magic, ORDER_JOURNAL_MAGIC, sizeof(fileHeader.magic)) != 0
+            || fileHeader.version != ORDER_JOURNAL_VERSION
+            || fileHeader.recordSize != sizeof(JournalRecord)
+            || static_cast<size_t>(fileStat.st_size) < fileSizeFor(fileHeader.capacity)) {
+            fail(m_filename + " is not a supported journal file");
+        }
+        // the capacity it has been created with, JournalCapacity only applies to new journals
+        m_capacity = fileHeader.capacity;
+    }
+    const uint64_t reserve = reservedRecords(config);
+    if (m_capacity < 2 * reserve) {
+        fail("Journal " + m_filename + " holds " + std::to_string(m_capacity) + " records, it needs at least "
+             + std::to_string(2 * reserve) + " for OrderPoolSize, ShardCount and InFlightTableSize");
+    }
+    m_admissionLimit = m_capacity - reserve;
+    m_mappingSize = fileSizeFor(m_capacity);
+    if (created && ::ftruncate(m_fd, m_mappingSize) != 0) {
+        fail("Can't preallocate journal file " + m_filename);
+    }
+    m_mapping = ::mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (m_mapping == MAP_FAILED) {
+        fail("Can't map journal file " + m_filename);
+    }
+    m_records = reinterpret_cast<JournalRecord*>(static_cast<JournalFileHeader*>(m_mapping) + 1);
+    if (created) {
+        initialize(getCurrentTimeNs());
+    } else {
+        // appends go after the records of the previous run until the journal gets reset
+        uint64_t recordCount = 0;
+        while (recordCount < m_capacity && m_records[recordCount].event != JournalEvent::None) {
+            ++recordCount;
+        }
+        m_nextRecord.store(recordCount, std::memory_order_relaxed);
+    }
+}
+
+OrderJournal::~OrderJournal()
+{
+    sync();
+    ::munmap(m_mapping, m_mappingSize);
+    ::close(m_fd);
+}
+
+void OrderJournal::initialize(uint64_t createTimeNs)
+{
+    auto* fileHeader = static_cast<JournalFileHeader*>(m_mapping);
+    std::memset(fileHeader, 0, sizeof(JournalFileHeader));
+    std::memcpy(fileHeader->magic, ORDER_JOURNAL_MAGIC, sizeof(fileHeader->magic));
+    fileHeader->version = ORDER_JOURNAL_VERSION;
+    fileHeader->recordSize = sizeof(JournalRecord);
+    fileHeader->capacity = m_capacity;
+    fileHeader->createTimeNs = createTimeNs;
+    m_droppedRecords.store(0, std::memory_order_relaxed);
+    ::msync(m_mapping, sizeof(JournalFileHeader), MS_SYNC);
+    // resumes suspended appends
+    m_nextRecord.store(0, std::memory_order_release);
+}
+
+void OrderJournal::reset(uint64_t createTimeNs)
+{
+    // truncating and extending the file again turns the records into holes, the journal stays sparse
+    if (::ftruncate(m_fd, sizeof(JournalFileHeader)) != 0 || ::ftruncate(m_fd, m_mappingSize) != 0) {
+        throw std::runtime_error("Can't reset journal file " + m_filename);
+    }
+    initialize(createTimeNs);
+}
+
+void OrderJournal::append(const JournalRecord& record)
+{
+    // acquire, a slot reused after a roll is written after the replay has read it
+    uint64_t index = m_nextRecord.fetch_add(1, std::memory_order_acquire);
+    while (index >= APPENDS_SUSPENDED) {
+        // the journal is being rolled, the record goes into the next one
+        waitForResume();
+        index = m_nextRecord.fetch_add(1, std::memory_order_acquire);
+    }
+    if (index >= m_capacity) {
+        // only if the orders needed more records than their reserve
+        if (m_droppedRecords.fetch_add(1, std::memory_order_relaxed) == 0) {
+            OM_LOG_ERROR("Order journal {} is full ({} records) despite its reserve, orders changed from now on "
+                         "can't be recovered", m_filename, m_capacity);
+        }
+        return;
+    }
+    write(index, record);
+}
+
+bool OrderJournal::tryAppend(const JournalRecord& record)
+{
+    // a slot is only taken if the record fits, a slot that is never written would end the replay
+    uint64_t index = m_nextRecord.load(std::memory_order_acquire);
+    while (true) {
+        if (index >= APPENDS_SUSPENDED) {
+            waitForResume();
+            index = m_nextRecord.load(std::memory_order_acquire);
+            continue;
+        }
+        if (index >= m_admissionLimit) {
+            return false;
+        }
+        if (m_nextRecord.compare_exchange_weak(index, index + 1, std::memory_order_acquire)) {
+            break;
+        }
+    }
+    write(index, record);
+    return true;
+}
+
+void OrderJournal::write(uint64_t index, const JournalRecord& record)
+{
+    JournalRecord& slot = m_records[index];
+    std::memcpy(&slot, &record, offsetof(JournalRecord, event));
+    std::atomic_ref<JournalEvent>(slot.event).store(record.event, std::memory_order_release);
+    if (m_syncPolicy == JournalSyncPolicy::EveryRecord) {
+        static const size_t pageSize = ::sysconf(_SC_PAGESIZE);
+        const size_t offset = fileSizeFor(index);
+        const size_t pageOffset = offset - offset % pageSize;
+        ::msync(static_cast<uint8_t*>(m_mapping) + pageOffset, offset + sizeof(JournalRecord) - pageOffset,
+                MS_SYNC);
+    }
+}
+
+void OrderJournal::waitForResume() const
+{
+    while (m_nextRecord.load(std::memory_order_acquire) >= APPENDS_SUSPENDED) {
+        std::this_thread::yield();
+    }
+}
+
+bool OrderJournal::rollDue() const
+{
+    const uint64_t recordCount = m_nextRecord.load(std::memory_order_relaxed);
+    return recordCount < APPENDS_SUSPENDED && recordCount >= m_admissionLimit / 2;
+}
+
+void OrderJournal::suspendAppends()
+{
+    m_suspendedRecord = m_nextRecord.exchange(APPENDS_SUSPENDED, std::memory_order_acq_rel);
+    // the appends that took their slots before are complete once their event is stored
+    const uint64_t recordCount = std::min(m_suspendedRecord, m_capacity);
+    for (uint64_t index = 0; index < recordCount; ++index) {
+        while (std::atomic_ref<JournalEvent>(m_records[index].event).load(std::memory_order_acquire)
+               == JournalEvent::None) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void OrderJournal::resumeAppends()
+{
+    m_nextRecord.store(m_suspendedRecord, std::memory_order_release);
+}
+
+void OrderJournal::sync()
+{
+    const uint64_t recordCount = std::min(m_nextRecord.load(std::memory_order_relaxed), m_capacity);
+    ::msync(m_mapping, fileSizeFor(recordCount), MS_SYNC);
+}
+
+std::span<const JournalRecord> OrderJournal::completeRecords(uint64_t position) const
+{
+    const uint64_t end = std::min(m_nextRecord.load(std::memory_order_relaxed), m_capacity);
+    uint64_t complete = std::min(position, end);
+    while (complete < end
+           && std::atomic_ref<JournalEvent>(m_records[complete].event).load(std::memory_order_acquire)
+               != JournalEvent::None) {
+        ++complete;
+    }
+    return std::span<const JournalRecord>(m_records + std::min(position, end), m_records + complete);
+}
+
+JournalReplay::JournalReplay(size_t capacity)
+    : m_index(capacity)
+{
+    m_orders.reserve(capacity);
+}
+
+RecoveredOrder* JournalReplay::find(uint64_t orderId)
+{
+    const uint32_t* slot = m_index.find(orderId);
+    return slot ? &m_orders[*slot] : nullptr;
+}
+
+void JournalReplay::add(const RecoveredOrder& order)
+{
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_orders[slot] = order;
+    } else {
+        slot = static_cast<uint32_t>(m_orders.size());
+        m_orders.push_back(order);
+    }
+    m_index.emplace(order.order.orderId, slot);
+}
+
+void JournalReplay::remove(uint64_t orderId)
+{
+    if (const uint32_t* slot = m_index.find(orderId)) {
+        m_freeSlots.push_back(*slot);
+        m_index.erase(orderId);
+    }
+}
+
+void JournalReplay::apply(std::span<const JournalRecord> records)
+{
+    for (const auto& record : records) {
+        apply(record);
+    }
+}
+
+void JournalReplay::apply(const JournalRecord& record)
+{
+    // the transitions mirror the ones of OrderManagement, records of orders it doesn't know are ignored
+    RecoveredOrder* order = find(record.orderId);
+    switch (record.event) {
+        case JournalEvent::None:
+            break;
+        case JournalEvent::Received: {
+                RecoveredOrder received{};
+                received.order = PackedOrder{record.orderId, record.timeNs, record.priceTicks, record.qty,
+                                             record.symbolId, record.clientId, static_cast<Side>(record.value),
+                                             RequestType::New};
+                received.queuePosition = m_position;
+                received.state = RecoveredOrderState::Queued;
+                if (order) {
+                    *order = received;
+                } else {
+                    add(received);
+                }
+            }
+            break;
+        case JournalEvent::Modified:
+            if (order && order->state == RecoveredOrderState::Queued) {
+                // the order keeps its place in the queue, its receive time and its client
+                order->order.priceTicks = record.priceTicks;
+                order->order.qty = record.qty;
+                order->order.symbolId = record.symbolId;
+                order->order.side = static_cast<Side>(record.value);
+            } else if (order) {
+                order->amend = PackedOrder{record.orderId, record.timeNs, record.priceTicks, record.qty,
+                                           record.symbolId, record.clientId, static_cast<Side>(record.value),
+                                           RequestType::Modify};
+                order->hasAmend = true;
+            }
+            break;
+        case JournalEvent::Cancelled:
+            if (order && order->state == RecoveredOrderState::Queued) {
+                remove(record.orderId);
+            } else if (order) {
+                order->hasAmend = false;
+            }
+            break;
+        case JournalEvent::Sent:
+            if (order && order->state == RecoveredOrderState::Queued) {
+                order->state = RecoveredOrderState::InFlight;
+                order->sendTimeNs = record.timeNs;
+            }
+            break;
+        case JournalEvent::Responded:
+            if (order && order->state == RecoveredOrderState::InFlight) {
+                const auto responseType = static_cast<ResponseType>(record.value);
+                // a rejected Replace leaves the original order live at the exchange
+                const bool live = responseType == ResponseType::Accept
+                    || (order->order.type == RequestType::Replace && responseType == ResponseType::Reject);
+                if (order->hasAmend && live) {
+                    // the amend is queued as a Replace
+                    order->order = order->amend;
+                    order->order.type = RequestType::Replace;
+                    order->hasAmend = false;
+                    order->state = RecoveredOrderState::Queued;
+                    order->queuePosition = m_position;
+                } else {
+                    remove(record.orderId);
+                }
+            }
+            break;
+        case JournalEvent::Rejected:
+            remove(record.orderId);
+            break;
+    }
+    ++m_position;
+}
+
+std::vector<RecoveredOrder> JournalReplay::orders() const
+{
+    // sorted as 16 byte keys rather than as 96 byte orders, queued orders first
+    std::vector<std::pair<uint64_t, uint32_t>> keys;
+    keys.reserve(m_index.size());
+    m_index.forEach([&](uint64_t, uint32_t slot) {
+        const RecoveredOrder& order = m_orders[slot];
+        keys.emplace_back(order.state == RecoveredOrderState::Queued ? order.queuePosition : ~0ull, slot);
+    });
+    std::sort(keys.begin(), keys.end());
+    std::vector<RecoveredOrder> orders;
+    orders.reserve(keys.size());
+    for (const auto& [key, slot] : keys) {
+        orders.push_back(m_orders[slot]);
+    }
+    return orders;
+}
+
+bool JournalReplay::loadSnapshot(const std::string& filename, uint64_t journalCreateTimeNs)
+{
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    OrderSnapshotHeader header;
+    struct stat fileStat;
+    bool valid = ::fstat(fd, &fileStat) == 0
+        && readAll(fd, &header, sizeof(header))
+        && std::memcmp(header.magic, ORDER_SNAPSHOT_MAGIC, sizeof(header.magic)) == 0
+        && header.version == ORDER_JOURNAL_VERSION
+        && header.recordSize == sizeof(RecoveredOrder)
+        && header.journalCreateTimeNs == journalCreateTimeNs
+        && static_cast<uint64_t>(fileStat.st_size) == sizeof(header) + header.orderCount * sizeof(RecoveredOrder);
+    if (valid) {
+        // read straight into the slots, only the index has to be built
+        m_orders.resize(header.orderCount);
+        valid = readAll(fd, m_orders.data(), m_orders.size() * sizeof(RecoveredOrder));
+    }
+    ::close(fd);
+    if (!valid) {
+        m_orders.clear();
+        return false;
+    }
+    for (uint32_t slot = 0; slot < m_orders.size(); ++slot) {
+        m_index.emplace(m_orders[slot].order.orderId, slot);
+    }
+    m_position = header.journalPosition;
+    return true;
+}
+
+void JournalReplay::writeSnapshot(const std::string& filename, uint64_t journalCreateTimeNs, bool sync) const
+{
+    // in no particular order, orders() sorts them when they are recovered
+    std::vector<RecoveredOrder> liveOrders;
+    liveOrders.reserve(m_index.size());
+    m_index.forEach([&](uint64_t, uint32_t slot) {
+        liveOrders.push_back(m_orders[slot]);
+    });
+    OrderSnapshotHeader header{};
+    std::memcpy(header.magic, ORDER_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = ORDER_JOURNAL_VERSION;
+    header.recordSize = sizeof(RecoveredOrder);
+    header.journalCreateTimeNs = journalCreateTimeNs;
+    header.journalPosition = m_position;
+    header.orderCount = liveOrders.size();
+
+    // the previous snapshot stays valid until the new one is complete
+    const std::string temporaryFilename = filename + ".tmp";
+    const int fd = ::open(temporaryFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Can't write snapshot " + temporaryFilename);
+    }
+    const bool written = writeAll(fd, &header, sizeof(header))
+        && writeAll(fd, liveOrders.data(), liveOrders.size() * sizeof(RecoveredOrder))
+        && (!sync || ::fsync(fd) == 0);
+    ::close(fd);
+    if (!written || ::rename(temporaryFilename.c_str(), filename.c_str()) != 0) {
+        ::unlink(temporaryFilename.c_str());
+        throw std::runtime_error("Can't write snapshot " + filename);
+    }
+    if (sync) {
+        syncDirectoryOf(filename);
+    }
+}
+
+} // ordermanagement namespace
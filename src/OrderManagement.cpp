@@ -1,40 +1,169 @@
 #include <chrono>
-#include <iostream>
+#include <filesystem>
 #include <queue>
 #include <functional>
+#include <algorithm>
+#include <stdexcept>
 
 #include "OrderManagement.h"
 #include "ExchangeSimulator.h"
 #include "Config.h"
+#include "Clock.h"
+#include "Logger.h"
 
 namespace ordermanagement {
 
+namespace {
+// initial capacity, only orders modified while they are in flight have an amend, the map grows if needed
+constexpr size_t PENDING_AMENDS_CAPACITY = 1024;
+// how often the journal is checked for a roll when it isn't snapshotted
+constexpr uint64_t JOURNAL_ROLL_CHECK_INTERVAL_MS = 100;
+// how soon a transmitter tries again when the in flight table is full
+constexpr uint64_t IN_FLIGHT_RETRY_INTERVAL_NS = 50000;
+
+uint64_t journalSnapshotIntervalNs(const Config& config)
+{
+    return (config.journalSnapshotIntervalMs > 0 ? config.journalSnapshotIntervalMs : JOURNAL_ROLL_CHECK_INTERVAL_MS)
+        * 1000000ull;
+}
+} // unnamed namespace
+
 OrderManagement::OrderManagement(const std::string& configFileName,
-                  std::unique_ptr<IOrderStatsCollectorCallBack> statsCollector)
-    : m_config(configFileName)
-    , m_statsCollector(std::move(statsCollector))
+                  std::unique_ptr<IOrderStatsCollectorCallBack> statsCollector,
+                  const IClock* clock)
+    : OrderManagement(Config(configFileName), VenueServices{nullptr, nullptr, clock, nullptr, {}})
+{
+    if (statsCollector) {
+        m_statsBus->subscribe(std::move(statsCollector));
+    }
+}
+
+OrderManagement::OrderManagement(const Config& config, const VenueServices& services)
+    : m_config(config)
+    , m_clock(services.clock)
+    , m_inFlightOrders(m_config.inFlightTableSize)
+    , m_throttle(m_config, services.clock)
+    , m_priceScale(m_config)
+    , m_pendingAmends(PENDING_AMENDS_CAPACITY)
+    , m_sessionWaitStrategy(services.sessionWaitStrategy)
+    , m_timerWheel(m_config.timerPrecisionNs, now())
+    , m_orderEvents(services.orderEvents)
+    , m_statsBus(services.statsBus)
+{
+    if (!m_sessionWaitStrategy) {
+        m_ownSessionWaitStrategy = std::make_unique<WaitStrategy>(m_config.waitStrategy, m_config.waitSpinIterations,
+                                                                  m_config.waitYieldIterations);
+        m_sessionWaitStrategy = m_ownSessionWaitStrategy.get();
+    }
+    if (!m_orderEvents) {
+        m_ownOrderEvents = std::make_unique<OrderEventDispatcher>(m_config);
+        m_orderEvents = m_ownOrderEvents.get();
+    }
+    if (!m_statsBus) {
+        m_ownStatsBus = std::make_unique<StatsBus>(m_config);
+        m_statsBus = m_ownStatsBus.get();
+    }
+    for (uint32_t i = 0; i < m_config.shardCount; ++i) {
+        m_shards.push_back(std::make_unique<Shard>(
+            m_config, i < services.shardWaitStrategies.size() ? services.shardWaitStrategies[i] : nullptr));
+    }
+    if (!m_config.journalFile.empty()) {
+        m_journal = std::make_unique<OrderJournal>(m_config);
+        recoverFromJournal();
+    }
+}
+
+OrderManagement::Shard::Shard(const Config& config, WaitStrategy* driverWaitStrategy)
+    : ordersQueue(config.orderPoolSize)
+    , queuedOrdersMap(config.orderPoolSize)
+    , ingressRing(config.ingressRingSize)
+    , waitStrategy(driverWaitStrategy)
 {
+    if (!waitStrategy) {
+        ownWaitStrategy = std::make_unique<WaitStrategy>(config.waitStrategy, config.waitSpinIterations,
+                                                         config.waitYieldIterations);
+        waitStrategy = ownWaitStrategy.get();
+    }
+    batchOrders.reserve(config.maxTransmitBatchSize);
+    batchRequests.reserve(config.maxTransmitBatchSize);
 }
 
 void OrderManagement::start()
 {
-    m_checkExchangeState = std::make_unique<std::thread>(
-        &OrderManagement::checkExchangeState, this);
-    m_transmitRemoteRequests = std::make_unique<std::thread>(
-        &OrderManagement::transmitRemoteRequests, this);
+    scheduleSessions();
+    if (m_config.clockCalibrationIntervalMs > 0) {
+        scheduleClockCalibration(now() + m_config.clockCalibrationIntervalMs * 1000000ull);
+    }
+    scheduleJournalTasks();
+    m_sessionTimerThread = std::make_unique<std::thread>(
+        &OrderManagement::runSessionTimers, this);
+    for (auto& shard : m_shards) {
+        shard->transmitter = std::make_unique<std::thread>(
+            &OrderManagement::transmitRemoteRequests, this, shard.get());
+    }
+}
+
+void OrderManagement::startSimulation()
+{
+    m_simulation = true;
+    // the virtual clock doesn't need any calibration
+    scheduleSessions();
+}
+
+void OrderManagement::startDriven()
+{
+    // the engine calibrates the clock shared by all the venues
+    scheduleSessions();
+    scheduleJournalTasks();
+}
+
+void OrderManagement::scheduleSessions()
+{
+    const uint64_t currentTime = now();
+    const uint64_t todayStart = currentTime - currentTime % NS_IN_DAY;
+    std::vector<TradingSession> sessions = m_config.sessions;
+    if (sessions.empty()) {
+        sessions.push_back(TradingSession{m_config.openTimeOffsetFromDayStartNs,
+                                          m_config.closeTimeOffsetFromDayStartNs});
+    }
+    for (const auto& session : sessions) {
+        // start from yesterday, an overnight session that opened yesterday could still be open
+        scheduleSession(session, todayStart - NS_IN_DAY);
+    }
 }
 
 void OrderManagement::shutDown()
 {
     m_terminate = true;
+    for (auto& shard : m_shards) {
+        shard->waitStrategy->interrupt();
+    }
+    m_sessionWaitStrategy->interrupt();
+    // there are no threads in simulation mode
+    if (m_sessionTimerThread && m_sessionTimerThread->joinable()) {
+        m_sessionTimerThread->join();
+        for (auto& shard : m_shards) {
+            shard->transmitter->join();
+        }
+    }
 }
 
 OrderManagement::~OrderManagement()
 {
     shutDown();
-    m_checkExchangeState->join();
-    m_transmitRemoteRequests->join();
-    rejectOrdersInQueue("Terminate has been called");
+    size_t keptOrders = 0;
+    for (auto& shard : m_shards) {
+        drainIngressRing(*shard);
+        if (m_journal) {
+            keptOrders += shard->liveOrders;
+        } else {
+            rejectOrdersInQueue(*shard, RejectCode::Terminated);
+        }
+    }
+    if (m_journal) {
+        OM_LOG_INFO("{} queued and {} in flight orders are kept in journal {} for the next start", keptOrders,
+                    m_inFlightOrders.size(), m_journal->filename());
+    }
 }
 
 void OrderManagement::setExchangeSimulator(IExchangeSimulator* simulator)
@@ -42,51 +171,211 @@ void OrderManagement::setExchangeSimulator(IExchangeSimulator* simulator)
     m_simulator = simulator;
 }
 
-void OrderManagement::onData(OrderRequest && request, RequestType requestType)
+void OrderManagement::onData(OrderRequest && request, RequestType requestType, ClientId clientId)
 {
+    PackedOrder packedRequest;
     if (!m_exchangeOpen) {
-        rejectOrder(std::move(request), "Exchange is closed");
+        rejectOrder(request.orderId, clientId, RejectCode::ExchangeClosed);
+    } else if (requestType == RequestType::Unknown || requestType == RequestType::Replace) {
+        rejectOrder(request.orderId, clientId, RejectCode::UnknownRequestType);
+    } else if (!packOrder(request, requestType, clientId, now(), m_priceScale, packedRequest)) {
+        rejectOrder(request.orderId, clientId, RejectCode::InvalidOrder);
     } else {
-        switch (requestType) {
-            case RequestType::Unknown:
-                rejectOrder(std::move(request), "Unknown request type");
-                break;
-            case RequestType::New:
-                addRequestToQueue(std::move(request));
-                break;
-            case RequestType::Modify: {
-                    std::lock_guard<std::mutex> lock(m_ordersQueueMutex);
-                    auto orderIt = m_queuedOrdersMap.find(request.orderId);
-                    if(orderIt != m_queuedOrdersMap.end()) {
-                        orderIt->second->request = std::move(request);
-                    } else {
-                        std::cerr << "Can't modify order it has already been sent to the exchange\n";
-                    }
-                }
-                break;
-            case RequestType::Cancel: {
-                    std::lock_guard<std::mutex> lock(m_ordersQueueMutex);
-                    auto orderIt = m_queuedOrdersMap.find(request.orderId);
-                    if(orderIt != m_queuedOrdersMap.end()) {
-                        orderIt->second->canceledFlag = true;
-                    } else {
-                        std::cerr << "Can't cancel order as it has already been submitted to the exchange\n";
-                    }
+        enqueueRequest(shardOf(packedRequest.symbolId), packedRequest);
+    }
+}
+
+void OrderManagement::enqueueRequest(Shard& shard, const PackedOrder& request)
+{
+    if (m_config.ingressMode == IngressMode::Ring) {
+        if (addRequestToIngressRing(shard, request) != RejectCode::None && request.type == RequestType::Replace) {
+            // the Replace was journaled as queued with the response of its order
+            journalEvent(JournalEvent::Rejected, request.orderId);
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(shard.ordersQueueMutex);
+        applyRequest(shard, request);
+    }
+    shard.waitStrategy->notify();
+}
+
+void OrderManagement::onDataBatch(std::span<const BatchRequest> requests, std::span<RejectCode> results,
+                                  ClientId clientId)
+{
+    if (results.size() < requests.size()) {
+        throw std::runtime_error("onDataBatch needs a result for every request");
+    }
+    if (!m_exchangeOpen) {
+        for (size_t i = 0; i < requests.size(); ++i) {
+            results[i] = RejectCode::ExchangeClosed;
+            rejectOrder(requests[i].request.orderId, clientId, RejectCode::ExchangeClosed);
+        }
+        return;
+    }
+    // one receive time for the whole basket
+    const uint64_t receiveTime = now();
+    PackedOrder packedOrders[BATCH_CHUNK_SIZE];
+    uint32_t resultIndexes[BATCH_CHUNK_SIZE];
+    PackedOrder shardOrders[BATCH_CHUNK_SIZE];
+    uint32_t shardResultIndexes[BATCH_CHUNK_SIZE];
+    for (size_t begin = 0; begin < requests.size(); begin += BATCH_CHUNK_SIZE) {
+        const size_t end = std::min(requests.size(), begin + BATCH_CHUNK_SIZE);
+        size_t packed = 0;
+        for (size_t i = begin; i < end; ++i) {
+            const BatchRequest& request = requests[i];
+            if (request.requestType == RequestType::Unknown || request.requestType == RequestType::Replace) {
+                results[i] = RejectCode::UnknownRequestType;
+            } else if (!packOrder(request.request, request.requestType, clientId, receiveTime, m_priceScale,
+                                  packedOrders[packed])) {
+                results[i] = RejectCode::InvalidOrder;
+            } else {
+                results[i] = RejectCode::None;
+                resultIndexes[packed++] = static_cast<uint32_t>(i);
+                continue;
+            }
+            rejectOrder(request.request.orderId, clientId, results[i]);
+        }
+        if (m_shards.size() == 1) {
+            submitBatchToShard(*m_shards[0], std::span<const PackedOrder>(packedOrders, packed), resultIndexes,
+                               results);
+            continue;
+        }
+        // the requests of every shard keep their order, which is all that matters as an order never changes shard
+        for (auto& shard : m_shards) {
+            size_t shardCount = 0;
+            for (size_t i = 0; i < packed; ++i) {
+                if (&shardOf(packedOrders[i].symbolId) == shard.get()) {
+                    shardOrders[shardCount] = packedOrders[i];
+                    shardResultIndexes[shardCount++] = resultIndexes[i];
                 }
-                break;
+            }
+            if (shardCount != 0) {
+                submitBatchToShard(*shard, std::span<const PackedOrder>(shardOrders, shardCount), shardResultIndexes,
+                                   results);
+            }
         }
     }
 }
 
+void OrderManagement::submitBatchToShard(Shard& shard, std::span<const PackedOrder> orders,
+                                         const uint32_t* resultIndexes, std::span<RejectCode> results)
+{
+    if (orders.empty()) {
+        return;
+    }
+    if (m_config.ingressMode == IngressMode::Ring) {
+        // one reservation for all of them, unless the spill queue is in use or the ring has no room for them all,
+        // then they go one by one through the overflow policy
+        if (shard.ingressSpillActive.load(std::memory_order_acquire) || !shard.ingressRing.tryPushBatch(orders)) {
+            for (size_t i = 0; i < orders.size(); ++i) {
+                results[resultIndexes[i]] = addRequestToIngressRing(shard, orders[i]);
+            }
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(shard.ordersQueueMutex);
+        for (const auto& order : orders) {
+            applyRequest(shard, order);
+        }
+    }
+    shard.waitStrategy->notify();
+}
+
 void OrderManagement::onData(OrderResponse && response)
 {
-    uint64_t currentTime = getCurrentTimeNs();
-    std::lock_guard<std::mutex> lock(m_ordersStatsMutex);
-    auto orderStatIt = m_ordersStatsMap.find(response.orderId);
-    orderStatIt->second.responseReceivalTimeNs = currentTime;
-    auto orderId = response.orderId;
-    m_statsCollector->processOrderStatisticsInfo(std::move(response), orderStatIt->second);
-    m_ordersStatsMap.erase(orderId);
+    uint64_t currentTime = now();
+    OrderStats orderStats;
+    ClientId clientId;
+    bool amended;
+    bool replace;
+    if (!m_inFlightOrders.complete(response.orderId, orderStats, clientId, amended, replace)) {
+        OM_LOG_WARNING("Got response for unknown order {} or a duplicate response", response.orderId);
+        return;
+    }
+    if (!amended) {
+        // the response of an amended order is journaled with its amend
+        journalEvent(JournalEvent::Responded, response.orderId, static_cast<uint8_t>(response.responseType));
+    }
+    orderStats.responseReceivalTimeNs = currentTime;
+    if (clientId != NO_CLIENT) {
+        if (response.responseType == ResponseType::Accept) {
+            m_orderEvents->publish(clientId, OrderEvent{response.orderId, currentTime, OrderEventType::Accepted,
+                                                       RejectCode::None});
+        } else if (replace && response.responseType == ResponseType::Reject) {
+            // only the cancel-replace failed, the order is still live at the exchange with its previous values
+            m_orderEvents->publish(clientId, OrderEvent{response.orderId, currentTime,
+                                                       OrderEventType::AmendRejected, RejectCode::ExchangeReject});
+        } else {
+            m_orderEvents->publish(clientId, OrderEvent{response.orderId, currentTime, OrderEventType::Rejected,
+                                                       response.responseType == ResponseType::Reject
+                                                           ? RejectCode::ExchangeReject
+                                                           : RejectCode::UnknownExchangeResponse});
+        }
+    }
+    m_statsBus->publish(response, orderStats);
+    if (amended) {
+        releasePendingAmend(response.orderId, response.responseType, replace);
+    }
+}
+
+RejectCode OrderManagement::amendInFlightOrder(const PackedOrder& request)
+{
+    std::lock_guard<std::mutex> lock(m_amendsMutex);
+    if (PackedOrder* pendingAmend = m_pendingAmends.find(request.orderId)) {
+        if (!journalOrder(JournalEvent::Modified, request)) {
+            return RejectCode::JournalFull;
+        }
+        // latest wins
+        *pendingAmend = request;
+        return RejectCode::None;
+    }
+    // marked under the lock, so that the response can't look for the amend before it is there
+    if (!m_inFlightOrders.markAmended(request.orderId)) {
+        return RejectCode::TooLateToModify;
+    }
+    // journaled under the lock too, so that it can't come after the response in the journal. Without room for it
+    // the order stays marked Amended without an amend, like after a cancel of the amend.
+    if (!journalOrder(JournalEvent::Modified, request)) {
+        return RejectCode::JournalFull;
+    }
+    m_pendingAmends.emplace(request.orderId, request);
+    return RejectCode::None;
+}
+
+void OrderManagement::dropPendingAmend(uint64_t orderId)
+{
+    // the order stays marked Amended, its response finds no amend then
+    std::lock_guard<std::mutex> lock(m_amendsMutex);
+    if (m_pendingAmends.erase(orderId)) {
+        journalEvent(JournalEvent::Cancelled, orderId);
+    }
+}
+
+void OrderManagement::releasePendingAmend(uint64_t orderId, ResponseType responseType, bool replace)
+{
+    const bool live = responseType == ResponseType::Accept || (replace && responseType == ResponseType::Reject);
+    PackedOrder amend;
+    {
+        std::lock_guard<std::mutex> lock(m_amendsMutex);
+        journalEvent(JournalEvent::Responded, orderId, static_cast<uint8_t>(responseType));
+        PackedOrder* pendingAmend = m_pendingAmends.find(orderId);
+        if (!pendingAmend) {
+            // dropped by a cancel
+            return;
+        }
+        amend = *pendingAmend;
+        m_pendingAmends.erase(orderId);
+    }
+    if (!live) {
+        // the order is gone, its Rejected event has just been published
+        return;
+    }
+    if (!m_exchangeOpen) {
+        journalEvent(JournalEvent::Rejected, orderId);
+        rejectAmend(orderId, amend.clientId, RejectCode::ExchangeClosed);
+        return;
+    }
+    amend.type = RequestType::Replace;
+    enqueueRequest(shardOf(amend.symbolId), amend);
 }
 
 void OrderManagement::send(const OrderRequest& request)
@@ -94,6 +383,16 @@ void OrderManagement::send(const OrderRequest& request)
     m_simulator->send(request);
 }
 
+void OrderManagement::sendReplace(const OrderRequest& request)
+{
+    m_simulator->sendReplace(request);
+}
+
+void OrderManagement::sendBatch(std::span<const OrderRequest> requests)
+{
+    m_simulator->sendBatch(requests);
+}
+
 void OrderManagement::sendLogon()
 {
     m_simulator->sendLogon(Logon{m_config.username, m_config.password});
@@ -104,137 +403,618 @@ void OrderManagement::sendLogout()
     m_simulator->sendLogout(Logout{m_config.username});
 }
 
-void OrderManagement::checkExchangeState()
+void OrderManagement::scheduleAction(uint64_t deadlineNs, std::function<void()> action)
 {
-    while (!m_terminate) {
-        uint64_t currentTime = getCurrentTimeNs();
-        const auto currentTimeOffsetFromDateStart = currentTime % NS_IN_DAY;
-        if (currentTimeOffsetFromDateStart >= m_config.closeTimeOffsetFromDayStartNs) {
-            std::this_thread::sleep_for(std::chrono::nanoseconds(REGULAR_SLEEP_TIME_NS));
-        } else {
-            if (!m_exchangeOpen) {
-                waitOrAct([this]() { sendLogon(); }
-                    , currentTimeOffsetFromDateStart
-                    , m_config.openTimeOffsetFromDayStartNs);
-            } else {
-                constexpr uint64_t THRESHOLD_NS = 10;
-                // Mark the exchange as closed 10 nanoseconds before the close time
-                // to not send orders after close
-                waitOrAct([this](){ sendLogout(); }
-                    , currentTimeOffsetFromDateStart
-                    , m_config.closeTimeOffsetFromDayStartNs - THRESHOLD_NS);
-            }
-        }      
+    {
+        std::lock_guard<std::mutex> lock(m_timersMutex);
+        m_timerWheel.schedule(deadlineNs, std::move(action));
     }
+    // the timer thread might be sleeping until a later deadline
+    m_sessionWaitStrategy->interrupt();
 }
 
-void OrderManagement::waitOrAct(std::function<void()> act, 
-                                uint64_t currentTimeOffsetFromDateStart,
-                                uint64_t actionTimeOffsetFromDateStart)
+void OrderManagement::scheduleSession(const TradingSession& session, uint64_t dayStartNs)
 {
-    if(currentTimeOffsetFromDateStart < actionTimeOffsetFromDateStart 
-        && actionTimeOffsetFromDateStart - currentTimeOffsetFromDateStart > 3 * REGULAR_SLEEP_TIME_NS) {
-        std::this_thread::sleep_for(std::chrono::nanoseconds(REGULAR_SLEEP_TIME_NS));
-    } else { // we are close to the trading Open/Close time, perform busy check of the time to avoid unnessesery delays
-        auto currentTimeOffsetFromDateStart = getCurrentTimeNs() % NS_IN_DAY;
-        for(; currentTimeOffsetFromDateStart < actionTimeOffsetFromDateStart
-            ; currentTimeOffsetFromDateStart = getCurrentTimeNs() % NS_IN_DAY);
-        act();
-        m_exchangeOpen = !m_exchangeOpen; // Flip the state of the exchange open<->close
+    // Mark the exchange as closed 10 nanoseconds before the close time
+    // to not send orders after close
+    constexpr uint64_t THRESHOLD_NS = 10;
+    const uint64_t currentTime = now();
+    uint64_t openTime;
+    uint64_t closeTime;
+    // find the first occurrence of the session that hasn't been closed yet
+    while (true) {
+        openTime = dayStartNs + session.openTimeOffsetFromDayStartNs;
+        closeTime = dayStartNs + session.closeTimeOffsetFromDayStartNs - THRESHOLD_NS;
+        if (session.closeTimeOffsetFromDayStartNs <= session.openTimeOffsetFromDayStartNs) {
+            closeTime += NS_IN_DAY; // overnight session, closes on the next day
+        }
+        if (currentTime < closeTime) {
+            break;
+        }
+        dayStartNs += NS_IN_DAY;
     }
+    // if the session is already open the logon action is due straight away
+    scheduleAction(openTime, [this, session, dayStartNs, closeTime]() {
+        sendLogon();
+        setExchangeOpen(true);
+        scheduleReconciliation();
+        scheduleAction(closeTime, [this, session, dayStartNs]() {
+            sendLogout();
+            setExchangeOpen(false);
+            scheduleSession(session, dayStartNs + NS_IN_DAY);
+        });
+    });
 }
 
-void OrderManagement::rejectOrder(OrderRequest && request, const std::string rejectReason)
+void OrderManagement::scheduleClockCalibration(uint64_t deadlineNs)
 {
-    std::cerr << "Order " << request.orderId << " was rejected:" << rejectReason << std::endl;
+    scheduleAction(deadlineNs, [this]() {
+        calibrateClock();
+        scheduleClockCalibration(now() + m_config.clockCalibrationIntervalMs * 1000000ull);
+    });
 }
 
-void OrderManagement::addRequestToQueue(OrderRequest && request)
+void OrderManagement::scheduleJournalTasks()
 {
-    std::lock_guard<std::mutex> lock(m_ordersQueueMutex);
-    m_ordersQueue.push(OrderInfo{request, false, getCurrentTimeNs()});
-    m_queuedOrdersMap.emplace(request.orderId, &m_ordersQueue.back());
+    if (!m_journal) {
+        return;
+    }
+    if (m_config.journalSyncPolicy == JournalSyncPolicy::Periodic) {
+        scheduleJournalSync(now() + m_config.journalSyncIntervalMs * 1000000ull);
+    }
+    scheduleJournalSnapshot(now() + journalSnapshotIntervalNs(m_config));
 }
 
-void OrderManagement::transmitRemoteRequests()
+void OrderManagement::scheduleJournalSync(uint64_t deadlineNs)
 {
-    using namespace std::chrono_literals; 
-    std::queue<uint64_t> transmitTimes;
-    while(!m_terminate) {
-        uint64_t currentTime = getCurrentTimeNs();
-        if (!m_exchangeOpen) {
-            // reject all orders in the queue if exchange has been closed
-            // while orders were waiting in the queue
-            {
-                std::lock_guard<std::mutex> locker(m_ordersQueueMutex);
-                rejectOrdersInQueue("Exchange got closed while order was in the queue");
-            }
-            const auto currentTimeOffsetFromDateStart = currentTime % NS_IN_DAY;
-            if (currentTimeOffsetFromDateStart >= m_config.closeTimeOffsetFromDayStartNs
-                || (currentTimeOffsetFromDateStart < m_config.closeTimeOffsetFromDayStartNs
-                && m_config.closeTimeOffsetFromDayStartNs - currentTimeOffsetFromDateStart < REGULAR_SLEEP_TIME_NS * 3)) {
-                std::this_thread::sleep_for(std::chrono::nanoseconds(REGULAR_SLEEP_TIME_NS));
-            } else {
-                // if the time is close ot exchange open time sleep short period
-                std::this_thread::sleep_for(std::chrono::nanoseconds(SHORT_SLEEP_TIME_NS));
+    scheduleAction(deadlineNs, [this]() {
+        m_journal->sync();
+        scheduleJournalSync(now() + m_config.journalSyncIntervalMs * 1000000ull);
+    });
+}
+
+void OrderManagement::scheduleJournalSnapshot(uint64_t deadlineNs)
+{
+    scheduleAction(deadlineNs, [this]() {
+        const uint64_t position = m_journalReplay->position();
+        if (m_journal->rollDue()) {
+            // the records appended while the replay catches up are part of the snapshot of the new journal
+            m_journal->suspendAppends();
+            m_journalReplay->apply(m_journal->completeRecords(position));
+            const uint64_t rolledPosition = m_journalReplay->position();
+            try {
+                rollJournal(true);
+            } catch (const std::exception& exception) {
+                OM_LOG_ERROR("{}", exception.what());
+                // the current journal goes on
+                m_journalReplay->restart(rolledPosition);
+                m_journal->resumeAppends();
+            }
+        } else if (m_config.journalSnapshotIntervalMs > 0) {
+            m_journalReplay->apply(m_journal->completeRecords(position));
+            // no new snapshot if nothing has happened since the last one
+            if (m_journalReplay->position() != position) {
+                try {
+                    m_journalReplay->writeSnapshot(m_journal->snapshotFilename(), m_journal->createTimeNs(),
+                                                   m_journal->syncsToDisk());
+                } catch (const std::exception& exception) {
+                    OM_LOG_ERROR("{}", exception.what());
+                }
             }
-            continue;
         }
-        // The exchange is open
+        scheduleJournalSnapshot(now() + journalSnapshotIntervalNs(m_config));
+    });
+}
+
+void OrderManagement::scheduleReconciliation()
+{
+    if (m_recoveredInFlightOrders.empty()) {
+        return;
+    }
+    // only after the first logon, the exchange has had JournalReconcileTimeoutMs to answer the recovered orders then
+    scheduleAction(now() + m_config.journalReconcileTimeoutMs * 1000000ull,
+                   [this, orderIds = std::move(m_recoveredInFlightOrders)]() { rejectUnreconciledOrders(orderIds); });
+    m_recoveredInFlightOrders.clear();
+}
 
-        // remove all the items from the queue that are older then currentTime - window period 
-        while (!transmitTimes.empty() 
-            && transmitTimes.front() + m_config.windowSizeSec * NS_IN_SECOND < currentTime) {
-            transmitTimes.pop();
+void OrderManagement::rejectUnreconciledOrders(const std::vector<uint64_t>& orderIds)
+{
+    size_t rejected = 0;
+    for (uint64_t orderId : orderIds) {
+        OrderStats orderStats;
+        ClientId clientId;
+        bool amended;
+        bool replace;
+        if (!m_inFlightOrders.complete(orderId, orderStats, clientId, amended, replace)) {
+            // the exchange has answered it
+            continue;
+        }
+        if (amended) {
+            // whether the order is still live is unknown, its amend isn't sent
+            std::lock_guard<std::mutex> lock(m_amendsMutex);
+            m_pendingAmends.erase(orderId);
         }
-        // if there are less items in the transmitTimes queue then threshold
-        // then try send the order otherwise sleep short period and check again
-        if (transmitTimes.size() <= m_config.throttlingRate) {
-            // Transmit the order if the queue is not empty
-            bool transmitted = transmitOneOrder(currentTime);
-            if (transmitted) {
-                transmitTimes.push(currentTime);
+        journalEvent(JournalEvent::Rejected, orderId);
+        if (replace) {
+            // the original order may still be live at the exchange
+            rejectAmend(orderId, clientId, RejectCode::Unreconciled);
+        } else {
+            rejectOrder(orderId, clientId, RejectCode::Unreconciled);
+        }
+        ++rejected;
+    }
+    if (rejected > 0) {
+        OM_LOG_WARNING("{} of {} orders recovered in flight got no response within {} ms after the logon, "
+                       "rejected them as unreconciled", rejected, orderIds.size(), m_config.journalReconcileTimeoutMs);
+    }
+}
+
+void OrderManagement::recoverFromJournal()
+{
+    const uint64_t startTicks = getMonotonicTicks();
+    JournalRecoveryStats& stats = m_journalRecoveryStats;
+    m_journalReplay = std::make_unique<JournalReplay>(m_config.orderPoolSize * m_shards.size()
+                                                      + m_config.inFlightTableSize);
+    stats.snapshotLoaded = m_journalReplay->loadSnapshot(m_journal->snapshotFilename(), m_journal->createTimeNs());
+    // the process stopped while the journal was being rolled
+    const bool previousSnapshot = !stats.snapshotLoaded
+        && m_journalReplay->loadSnapshot(m_journal->previousSnapshotFilename(), m_journal->createTimeNs());
+    stats.snapshotLoaded |= previousSnapshot;
+    stats.snapshotOrders = m_journalReplay->size();
+    const auto records = m_journal->completeRecords(m_journalReplay->position());
+    m_journalReplay->apply(records);
+    stats.replayedRecords = records.size();
+
+    for (const auto& recovered : m_journalReplay->orders()) {
+        const PackedOrder& order = recovered.order;
+        if (recovered.state == RecoveredOrderState::Queued) {
+            Shard& shard = shardOf(order.symbolId);
+            shard.queuedOrdersMap.emplace(order.orderId, shard.ordersQueue.pushBack(order));
+            ++shard.liveOrders;
+            ++stats.queuedOrders;
+        } else if (m_inFlightOrders.insert(order.orderId,
+                                           OrderStats{order.orderManagerReceiveTimeNs, recovered.sendTimeNs, 0},
+                                           order.clientId, order.type == RequestType::Replace)) {
+            m_recoveredInFlightOrders.push_back(order.orderId);
+            ++stats.inFlightOrders;
+            if (recovered.hasAmend) {
+                m_inFlightOrders.markAmended(order.orderId);
+                m_pendingAmends.emplace(order.orderId, recovered.amend);
+                ++stats.pendingAmends;
             }
         } else {
-            std::this_thread::sleep_for(std::chrono::nanoseconds(SHORT_SLEEP_TIME_NS));
+            OM_LOG_WARNING("Order {} recovered from the journal doesn't fit into the in flight table",
+                           order.orderId);
+            m_journalReplay->remove(order.orderId);
+            ++stats.droppedOrders;
         }
     }
+
+    // the recovered orders become the snapshot of a new journal
+    rollJournal(stats.snapshotLoaded && !previousSnapshot);
+    stats.durationNs = ticksToNs(getMonotonicTicks() - startTicks);
+    OM_LOG_INFO("Recovered {} queued and {} in flight orders ({} with an amend) from journal {} in {} us: "
+                "snapshot of {} orders, {} records replayed", stats.queuedOrders, stats.inFlightOrders,
+                stats.pendingAmends, m_journal->filename(), stats.durationNs / 1000, stats.snapshotOrders,
+                stats.replayedRecords);
+}
+
+void OrderManagement::rollJournal(bool snapshotOfJournal)
+{
+    // If the process dies before the journal is reset, the new snapshot doesn't match the old journal, which is
+    // then replayed from the previous snapshot, or in full without one
+    if (snapshotOfJournal) {
+        std::error_code error;
+        std::filesystem::rename(m_journal->snapshotFilename(), m_journal->previousSnapshotFilename(), error);
+    }
+    const uint64_t journalCreateTime = getCurrentTimeNs();
+    m_journalReplay->restart();
+    m_journalReplay->writeSnapshot(m_journal->snapshotFilename(), journalCreateTime, m_journal->syncsToDisk());
+    m_journal->reset(journalCreateTime);
+}
+
+void OrderManagement::setExchangeOpen(bool exchangeOpen)
+{
+    m_exchangeOpen = exchangeOpen;
+    // wake up the transmitters, so that they start sending or reject their queues
+    for (auto& shard : m_shards) {
+        shard->waitStrategy->interrupt();
+    }
 }
 
-void OrderManagement::rejectOrdersInQueue(const std::string& rejectReason)
+uint64_t OrderManagement::runDueTimers()
 {
-    while(!m_ordersQueue.empty() ) {
-        auto nextOrder = m_ordersQueue.front();                
-        if (!nextOrder.canceledFlag) {
-            rejectOrder(std::move(nextOrder.request), 
-                        rejectReason);
+    for (;;) {
+        uint64_t nextDeadline;
+        {
+            std::lock_guard<std::mutex> lock(m_timersMutex);
+            m_timerWheel.advance(now(), m_dueActions);
+            nextDeadline = m_timerWheel.nextDeadlineNs();
+        }
+        if (m_dueActions.empty()) {
+            return nextDeadline == TimerWheel::NO_TIMERS ? WaitStrategy::NO_DEADLINE : nextDeadline;
         }
-        m_ordersQueue.pop();
+        // actions are executed without holding m_timersMutex as they can schedule new actions
+        for (auto& action : m_dueActions) {
+            action();
+        }
+        m_dueActions.clear();
+    }
+}
+
+void OrderManagement::runSessionTimers()
+{
+    while (!m_terminate) {
+        const uint64_t interruptEpoch = m_sessionWaitStrategy->prepareWaitUntil();
+        // sleeps until the next scheduled action, scheduleAction() interrupts the wait
+        m_sessionWaitStrategy->waitUntil(runDueTimers(), interruptEpoch);
+    }
+}
+
+void OrderManagement::rejectOrder(uint64_t orderId, ClientId clientId, RejectCode rejectCode)
+{
+    if (clientId == NO_CLIENT) {
+        // nobody listens to the events of this order
+        OM_LOG_WARNING("Order {} was rejected: {}", orderId, rejectCodeText(rejectCode));
+        return;
     }
+    m_orderEvents->publish(clientId, OrderEvent{orderId, now(), OrderEventType::Rejected, rejectCode});
 }
 
-bool OrderManagement::transmitOneOrder(uint64_t& sendTime) {
+void OrderManagement::rejectAmend(uint64_t orderId, ClientId clientId, RejectCode rejectCode)
+{
+    if (clientId == NO_CLIENT) {
+        OM_LOG_WARNING("Amend of order {} was rejected: {}", orderId, rejectCodeText(rejectCode));
+        return;
+    }
+    m_orderEvents->publish(clientId, OrderEvent{orderId, now(), OrderEventType::AmendRejected, rejectCode});
+}
+
+void OrderManagement::applyRequest(Shard& shard, const PackedOrder& request)
+{
+    switch (request.type) {
+        case RequestType::Unknown:
+            rejectOrder(request.orderId, request.clientId, RejectCode::UnknownRequestType);
+            break;
+        case RequestType::New:
+        case RequestType::Replace: {
+                // the client has had the Modified event of a Replace already, and it has been journaled with
+                // the response of its order
+                if (request.type == RequestType::New && !journalOrder(JournalEvent::Received, request)) {
+                    rejectOrder(request.orderId, request.clientId, RejectCode::JournalFull);
+                    break;
+                }
+                const auto slotIndex = shard.ordersQueue.pushBack(request);
+                shard.queuedOrdersMap.emplace(request.orderId, slotIndex);
+                ++shard.liveOrders;
+                if (request.type == RequestType::New) {
+                    publishOrderEvent(request.clientId, request.orderId, OrderEventType::Queued);
+                }
+            }
+            break;
+        case RequestType::Modify: {
+                auto slotIndex = shard.queuedOrdersMap.find(request.orderId);
+                if(slotIndex) {
+                    // the order keeps its place in the queue, its receive time and its client
+                    auto& order = shard.ordersQueue.at(*slotIndex);
+                    if (order.symbolId != request.symbolId) {
+                        // the order would sit in a shard its symbol doesn't map to
+                        rejectOrder(request.orderId, request.clientId, RejectCode::SymbolChanged);
+                        break;
+                    }
+                    if (!journalOrder(JournalEvent::Modified, request)) {
+                        rejectOrder(request.orderId, request.clientId, RejectCode::JournalFull);
+                        break;
+                    }
+                    order.priceTicks = request.priceTicks;
+                    order.qty = request.qty;
+                    order.side = request.side;
+                    publishOrderEvent(request.clientId, request.orderId, OrderEventType::Modified);
+                } else if (const RejectCode rejectCode = amendInFlightOrder(request); rejectCode == RejectCode::None) {
+                    publishOrderEvent(request.clientId, request.orderId, OrderEventType::Modified);
+                } else {
+                    rejectOrder(request.orderId, request.clientId, rejectCode);
+                }
+            }
+            break;
+        case RequestType::Cancel: {
+                auto slotIndex = shard.queuedOrdersMap.find(request.orderId);
+                if(slotIndex) {
+                    auto& order = shard.ordersQueue.at(*slotIndex);
+                    const bool replace = order.type == RequestType::Replace;
+                    if (order.type != RequestType::Cancel) {
+                        order.type = RequestType::Cancel;
+                        --shard.liveOrders;
+                        journalEvent(JournalEvent::Cancelled, request.orderId);
+                    }
+                    if (replace) {
+                        // only the amend is dropped, the order is at the exchange
+                        rejectOrder(request.orderId, request.clientId, RejectCode::TooLateToCancel);
+                    } else {
+                        publishOrderEvent(request.clientId, request.orderId, OrderEventType::Cancelled);
+                    }
+                } else {
+                    dropPendingAmend(request.orderId);
+                    rejectOrder(request.orderId, request.clientId, RejectCode::TooLateToCancel);
+                }
+            }
+            break;
+    }
+}
+
+RejectCode OrderManagement::addRequestToIngressRing(Shard& shard, const PackedOrder& request)
+{
+    // While the spill queue is non empty all producers keep spilling,
+    // so that requests of one producer are never reordered between the ring and the spill queue
+    if (!shard.ingressSpillActive.load(std::memory_order_acquire)
+        && shard.ingressRing.tryPush(request)) {
+        return RejectCode::None;
+    }
+    switch (m_config.ingressOverflowPolicy) {
+        case OverflowPolicy::Reject:
+            rejectOrder(request.orderId, request.clientId, RejectCode::IngressQueueFull);
+            return RejectCode::IngressQueueFull;
+        case OverflowPolicy::Block:
+            while (!shard.ingressRing.tryPush(request)) {
+                if (m_terminate) {
+                    rejectOrder(request.orderId, request.clientId, RejectCode::Terminated);
+                    return RejectCode::Terminated;
+                }
+                std::this_thread::yield();
+            }
+            break;
+        case OverflowPolicy::Spill: {
+                std::lock_guard<std::mutex> lock(shard.ingressSpillMutex);
+                shard.ingressSpill.push_back(request);
+                shard.ingressSpillActive.store(true, std::memory_order_release);
+            }
+            break;
+    }
+    return RejectCode::None;
+}
+
+void OrderManagement::drainIngressRing(Shard& shard)
+{
+    PackedOrder request;
+    while (shard.ingressRing.tryPop(request)) {
+        applyRequest(shard, request);
+    }
+    if (!shard.ingressSpillActive.load(std::memory_order_acquire)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(shard.ingressSpillMutex);
+        // A producer could have claimed a ring slot, not published it yet and then spilled
+        // its next request. Take the spill queue only when the ring is completely empty,
+        // otherwise the spilled request would overtake the one still sitting in the ring.
+        if (!shard.ingressRing.empty()) {
+            return;
+        }
+        shard.ingressSpillDrain.swap(shard.ingressSpill);
+        shard.ingressSpillActive.store(false, std::memory_order_release);
+    }
+    for (const auto& spilledRequest : shard.ingressSpillDrain) {
+        applyRequest(shard, spilledRequest);
+    }
+    shard.ingressSpillDrain.clear();
+}
+
+std::unique_lock<std::mutex> OrderManagement::lockOrdersQueue(Shard& shard)
+{
+    // In Ring ingress mode the transmitter thread is the only owner of the orders queue of its shard
+    if (m_config.ingressMode == IngressMode::Ring) {
+        return std::unique_lock<std::mutex>(shard.ordersQueueMutex, std::defer_lock);
+    }
+    return std::unique_lock<std::mutex>(shard.ordersQueueMutex);
+}
+
+uint64_t OrderManagement::pollTransmitter()
+{
+    const uint64_t stepTime = now();
+    uint64_t nextStepTime = WaitStrategy::NO_DEADLINE;
+    for (auto& shard : m_shards) {
+        nextStepTime = std::min(nextStepTime, transmitStep(*shard, stepTime));
+    }
+    return nextStepTime;
+}
+
+uint64_t OrderManagement::transmitStep(Shard& shard, const uint64_t stepTime)
+{
+    uint64_t currentTime = stepTime;
+    if (!m_exchangeOpen) {
+        // reject all orders in the queue if exchange has been closed
+        // while orders were waiting in the queue
+        auto locker = lockOrdersQueue(shard);
+        drainIngressRing(shard);
+        rejectOrdersInQueue(shard, RejectCode::ClosedWhileQueued);
+        // the session timer wakes the transmitter up when the exchange opens
+        return WaitStrategy::NO_DEADLINE;
+    }
+    // The exchange is open
+
+    // Ask the throttle when the next order is permitted,
+    // the transmitter waits exactly until then if the throttle limit has been reached
+    const uint64_t permittedTime = m_throttle.nextPermittedTimeNs(currentTime);
+    if (permittedTime > currentTime) {
+        return permittedTime;
+    }
+    if (m_inFlightOrders.full()) {
+        return inFlightRetryTime(currentTime);
+    }
+    // Transmit the order (or as many orders as the throttle permits right now in batching mode)
+    // if the queue is not empty, otherwise wait for new orders
+    shard.throttled = false;
+    shard.inFlightFull = false;
+    size_t transmitted = 0;
+    if (m_config.transmitBatching) {
+        transmitted = transmitOrdersBatch(shard, m_config.maxTransmitBatchSize, currentTime);
+    } else if (transmitOneOrder(shard, currentTime)) {
+        transmitted = 1;
+    }
+    if (transmitted == 0 && shard.inFlightFull) {
+        // other shards have filled the in flight table since it was checked
+        return inFlightRetryTime(now());
+    }
+    if (transmitted == 0 && shard.throttled) {
+        // other shards have taken the credits since they were checked
+        return m_throttle.nextPermittedTimeNs(now());
+    }
+    return transmitted == 0 ? WaitStrategy::NO_DEADLINE : stepTime;
+}
+
+uint64_t OrderManagement::inFlightRetryTime(uint64_t currentTime) const
+{
+    // Responses free the in flight slots without waking the transmitters up, so a thread retries a bit later and
+    // serves its other shards (and venues) meanwhile. Without threads the driver steps the transmitter again
+    // after the responses.
+    return m_simulation ? WaitStrategy::NO_DEADLINE : currentTime + IN_FLIGHT_RETRY_INTERVAL_NS;
+}
+
+void OrderManagement::transmitRemoteRequests(Shard* shard)
+{
+    while(!m_terminate) {
+        // taken before looking at the queue, so that work published after the check wakes us up
+        const uint64_t waitEpoch = shard->waitStrategy->prepareWait();
+        const uint64_t stepTime = now();
+        const uint64_t nextStepTime = transmitStep(*shard, stepTime);
+        if (nextStepTime == WaitStrategy::NO_DEADLINE) {
+            // nothing to send (or the exchange is closed), producers and the session timer wake us up
+            shard->waitStrategy->waitForWork(waitEpoch);
+        } else if (nextStepTime > stepTime) {
+            // throttled
+            shard->waitStrategy->waitUntil(nextStepTime);
+        }
+    }
+}
+
+void OrderManagement::rejectOrdersInQueue(Shard& shard, RejectCode rejectCode)
+{
+    while(!shard.ordersQueue.empty() ) {
+        const auto& nextOrder = shard.ordersQueue.front();
+        if (nextOrder.type != RequestType::Cancel) {
+            journalEvent(JournalEvent::Rejected, nextOrder.orderId);
+            rejectOrder(nextOrder.orderId, nextOrder.clientId, rejectCode);
+        }
+        // erased one by one rather than cleared, a closed venue is polled on every step and clearing the
+        // whole index each time would cost its capacity even when the queue is empty
+        shard.queuedOrdersMap.erase(nextOrder.orderId);
+        shard.ordersQueue.popFront();
+    }
+    shard.liveOrders = 0;
+}
+
+bool OrderManagement::transmitOneOrder(Shard& shard, uint64_t& sendTime) {
     bool shouldSend = false;
-    OrderInfo info;
+    PackedOrder order;
     {
-        std::lock_guard<std::mutex> locker(m_ordersQueueMutex);
-        if (!m_ordersQueue.empty()) {
-            info = std::move(m_ordersQueue.front());
-            if (!info.canceledFlag) {
+        auto locker = lockOrdersQueue(shard);
+        drainIngressRing(shard);
+        // The in flight slot and then the credit are taken before the pop, so that an order never leaves the
+        // queue without them, and no credit is taken for an order that can't be in flight
+        if (shard.liveOrders > 0) {
+            if (m_inFlightOrders.reserve(1) == 0) {
+                shard.inFlightFull = true;
+                return false;
+            }
+            if (m_throttle.acquire(sendTime, 1) == 0) {
+                m_inFlightOrders.unreserve(1);
+                shard.throttled = true;
+                return false;
+            }
+        }
+        // skip canceled orders, so that false is returned only when there is nothing to send
+        while (!shouldSend && !shard.ordersQueue.empty()) {
+            order = shard.ordersQueue.front();
+            if (order.type != RequestType::Cancel) {
                 shouldSend = true;
+                --shard.liveOrders;
             }
-            m_queuedOrdersMap.erase(info.request.orderId);
-            m_ordersQueue.pop();
+            shard.queuedOrdersMap.erase(order.orderId);
+            shard.ordersQueue.popFront();
         }
     }
     if (shouldSend) {
-        send(info.request);
-        std::lock_guard<std::mutex> locker2(m_ordersStatsMutex);
-        sendTime = getCurrentTimeNs();
-        m_ordersStatsMap.emplace(info.request.orderId, 
-                OrderStats{info.orderManagerReceiveTimeNs, sendTime, 0});
+        // the order has to be in flight before the send, as the response can arrive before send() returns
+        sendTime = now();
+        journalEvent(JournalEvent::Sent, order.orderId);
+        addInFlightOrder(order, sendTime);
+        // published before the send, so that it can't come after the event of the response
+        publishOrderEvent(order.clientId, order.orderId, OrderEventType::Sent);
+        if (order.type == RequestType::Replace) {
+            sendReplace(unpackOrder(order, m_priceScale));
+        } else {
+            send(unpackOrder(order, m_priceScale));
+        }
     }
     return shouldSend;
 }
 
-}  // ordermangement namespace
\ No newline at end of file
+void OrderManagement::addInFlightOrder(const PackedOrder& order, uint64_t sendTime)
+{
+    // the slot has been reserved before the order was popped
+    m_inFlightOrders.insertReserved(order.orderId, OrderStats{order.orderManagerReceiveTimeNs, sendTime, 0},
+                                    order.clientId, order.type == RequestType::Replace);
+}
+
+size_t OrderManagement::transmitOrdersBatch(Shard& shard, size_t maxOrders, uint64_t& sendTime)
+{
+    shard.batchOrders.clear();
+    {
+        // one queue lock for the whole batch
+        auto locker = lockOrdersQueue(shard);
+        drainIngressRing(shard);
+        if (shard.liveOrders == 0) {
+            // only cancelled orders (if any) are left, they are dropped below
+            maxOrders = 0;
+        } else {
+            // as many in flight slots and credits as there are orders to send, no credit is taken for nothing
+            const uint32_t slots = m_inFlightOrders.reserve(static_cast<uint32_t>(std::min(maxOrders,
+                                                                                           shard.liveOrders)));
+            maxOrders = slots == 0 ? 0 : m_throttle.acquire(sendTime, slots);
+            m_inFlightOrders.unreserve(slots - static_cast<uint32_t>(maxOrders));
+            shard.inFlightFull = slots == 0;
+            shard.throttled = slots > 0 && maxOrders == 0;
+        }
+        while (!shard.ordersQueue.empty()
+               && (shard.batchOrders.size() < maxOrders
+                   || shard.ordersQueue.front().type == RequestType::Cancel)) {
+            const auto& order = shard.ordersQueue.front();
+            if (order.type != RequestType::Cancel) {
+                shard.batchOrders.push_back(order);
+                --shard.liveOrders;
+            }
+            shard.queuedOrdersMap.erase(order.orderId);
+            shard.ordersQueue.popFront();
+        }
+    }
+    if (shard.batchOrders.empty()) {
+        return 0;
+    }
+    // orders have to be in flight before the send
+    sendTime = now();
+    shard.batchRequests.clear();
+    for (const auto& order : shard.batchOrders) {
+        journalEvent(JournalEvent::Sent, order.orderId);
+        addInFlightOrder(order, sendTime);
+        publishOrderEvent(order.clientId, order.orderId, OrderEventType::Sent);
+        shard.batchRequests.push_back(unpackOrder(order, m_priceScale));
+    }
+    // replaces go out one by one between the runs of new orders, in queue order
+    const std::span<const OrderRequest> requests(shard.batchRequests);
+    size_t runBegin = 0;
+    for (size_t i = 0; i < shard.batchOrders.size(); ++i) {
+        if (shard.batchOrders[i].type == RequestType::Replace) {
+            if (i > runBegin) {
+                sendBatch(requests.subspan(runBegin, i - runBegin));
+            }
+            sendReplace(requests[i]);
+            runBegin = i + 1;
+        }
+    }
+    if (runBegin < requests.size()) {
+        sendBatch(requests.subspan(runBegin));
+    }
+    return requests.size();
+}
+
+}  // ordermangement namespace
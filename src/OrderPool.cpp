@@ -0,0 +1,66 @@
+#include <stdexcept>
+
+#include "OrderPool.h"
+
+namespace ordermanagement {
+
+OrderPool::OrderPool(uint32_t slabSize)
+    : m_slabShift(0)
+{
+    // slab size is rounded up to the power of two so that index -> slot mapping is shift and mask
+    while ((1u << m_slabShift) < slabSize) {
+        ++m_slabShift;
+    }
+    m_slabMask = (1u << m_slabShift) - 1;
+    addSlab();
+}
+
+void OrderPool::addSlab()
+{
+    const uint32_t slabSize = m_slabMask + 1;
+    const uint64_t firstIndex = static_cast<uint64_t>(m_slabs.size()) << m_slabShift;
+    if (firstIndex + slabSize > INVALID_INDEX) {
+        throw std::runtime_error("Order pool can't grow anymore");
+    }
+    m_slabs.push_back(Slab{std::make_unique<PackedOrder[]>(slabSize), std::make_unique<uint32_t[]>(slabSize)});
+    // chain the new slots into the free list, lowest index first
+    for (uint32_t i = slabSize; i > 0; --i) {
+        const uint32_t index = static_cast<uint32_t>(firstIndex) + i - 1;
+        next(index) = m_freeHead;
+        m_freeHead = index;
+    }
+}
+
+uint32_t OrderPool::pushBack(const PackedOrder& order)
+{
+    if (m_freeHead == INVALID_INDEX) {
+        addSlab();
+    }
+    const uint32_t index = m_freeHead;
+    m_freeHead = next(index);
+
+    slot(index) = order;
+    next(index) = INVALID_INDEX;
+    if (m_tail == INVALID_INDEX) {
+        m_head = index;
+    } else {
+        next(m_tail) = index;
+    }
+    m_tail = index;
+    ++m_size;
+    return index;
+}
+
+void OrderPool::popFront()
+{
+    const uint32_t index = m_head;
+    m_head = next(index);
+    if (m_head == INVALID_INDEX) {
+        m_tail = INVALID_INDEX;
+    }
+    next(index) = m_freeHead;
+    m_freeHead = index;
+    --m_size;
+}
+
+} // ordermanagement namespace
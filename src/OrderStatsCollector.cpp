@@ -6,8 +6,11 @@
 namespace ordermanagement {
 
 OrderStatsFileWriterCallback::OrderStatsFileWriterCallback(const std::string& filename) 
-    : m_StatsFile(filename)
+    : m_fileBuffer(FILE_BUFFER_SIZE)
 {
+    // the buffer has to be set before the file is opened to take effect
+    m_StatsFile.rdbuf()->pubsetbuf(m_fileBuffer.data(), m_fileBuffer.size());
+    m_StatsFile.open(filename);
     m_StatsFile << "#OrderId,ResponseType,OrderWaitTimeInQueue,OrderRoundTripLatency\n";
 }
 
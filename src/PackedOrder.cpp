@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "PackedOrder.h"
+#include "Config.h"
+
+namespace ordermanagement {
+
+namespace {
+double decimalScale(uint32_t decimals)
+{
+    double scale = 1.0;
+    for (uint32_t i = 0; i < decimals; ++i) {
+        scale *= 10.0;
+    }
+    return scale;
+}
+} // unnamed namespace
+
+PriceScale::PriceScale(const Config& config)
+    : m_defaultScale(decimalScale(config.priceDecimals))
+{
+    for (const auto& [symbolId, decimals] : config.symbolPriceDecimals) {
+        m_symbolScales.emplace_back(symbolId, decimalScale(decimals));
+    }
+    std::sort(m_symbolScales.begin(), m_symbolScales.end());
+}
+
+double PriceScale::scaleOf(int32_t symbolId) const
+{
+    if (m_symbolScales.empty()) {
+        return m_defaultScale;
+    }
+    const auto it = std::lower_bound(m_symbolScales.begin(), m_symbolScales.end(), symbolId,
+                                     [](const auto& symbolScale, int32_t id) { return symbolScale.first < id; });
+    return it != m_symbolScales.end() && it->first == symbolId ? it->second : m_defaultScale;
+}
+
+bool PriceScale::toTicks(int32_t symbolId, double price, int32_t& ticks) const
+{
+    const double scale = scaleOf(symbolId);
+    const double scaledPrice = std::nearbyint(price * scale);
+    // also false for NaN
+    if (!(std::fabs(scaledPrice) <= std::numeric_limits<int32_t>::max())) {
+        return false;
+    }
+    ticks = static_cast<int32_t>(scaledPrice);
+    // exact for prices with at most `decimals` decimals, anything else would be silently rounded
+    return ticks / scale == price;
+}
+
+double PriceScale::toPrice(int32_t symbolId, int32_t ticks) const
+{
+    return ticks / scaleOf(symbolId);
+}
+
+bool packOrder(const OrderRequest& request, RequestType type, ClientId clientId, uint64_t receiveTimeNs,
+               const PriceScale& priceScale, PackedOrder& order)
+{
+    order.orderId = request.orderId;
+    order.orderManagerReceiveTimeNs = receiveTimeNs;
+    order.symbolId = request.symbolId;
+    order.clientId = clientId;
+    order.type = type;
+    if (type == RequestType::Cancel) {
+        order.priceTicks = 0;
+        order.qty = 0;
+        order.side = Side::Buy;
+        return true;
+    }
+    if (request.side != 'B' && request.side != 'S') {
+        return false;
+    }
+    order.side = request.side == 'B' ? Side::Buy : Side::Sell;
+    if (request.qty > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    order.qty = static_cast<uint32_t>(request.qty);
+    return priceScale.toTicks(request.symbolId, request.price, order.priceTicks);
+}
+
+OrderRequest unpackOrder(const PackedOrder& order, const PriceScale& priceScale)
+{
+    return OrderRequest{order.symbolId, priceScale.toPrice(order.symbolId, order.priceTicks), order.qty,
+                        order.side == Side::Buy ? 'B' : 'S', order.orderId};
+}
+
+} // ordermanagement namespace
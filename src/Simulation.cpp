@@ -0,0 +1,56 @@
+#include <algorithm>
+
+#include "Simulation.h"
+
+namespace ordermanagement {
+
+Simulation::Simulation(VirtualClock& clock, OrderManagement& manager, ExchangeResponseSimulator& exchange)
+    : m_clock(clock)
+    , m_manager(manager)
+    , m_exchange(exchange)
+{
+}
+
+void Simulation::addOrdersGenerator(MockOrdersGenerator& generator, uint64_t startTimeNs)
+{
+    m_generators.push_back(ScheduledGenerator{&generator, startTimeNs});
+}
+
+uint64_t Simulation::step()
+{
+    const uint64_t currentTime = m_clock.nowNs();
+    // timers first, so that a session opening at this time is open for the requests of this time
+    uint64_t nextEventTime = m_manager.runDueTimers();
+    for (auto& scheduled : m_generators) {
+        if (scheduled.nextRequestTimeNs <= currentTime) {
+            scheduled.nextRequestTimeNs = currentTime + scheduled.generator->sendNextRequest();
+        }
+        nextEventTime = std::min(nextEventTime, scheduled.nextRequestTimeNs);
+    }
+    // the transmitter returns the current time as long as it has sent something
+    uint64_t nextTransmitTime;
+    do {
+        nextTransmitTime = m_manager.pollTransmitter();
+    } while (nextTransmitTime <= currentTime);
+    // after the transmitter, so that the orders it has just sent are taken into account
+    nextEventTime = std::min(nextEventTime, m_exchange.respondDue());
+    return std::min(nextEventTime, nextTransmitTime);
+}
+
+uint64_t Simulation::runUntil(uint64_t endTimeNs)
+{
+    uint64_t steps = 0;
+    while (m_clock.nowNs() <= endTimeNs) {
+        const uint64_t nextEventTime = step();
+        ++steps;
+        if (nextEventTime > endTimeNs) {
+            break;
+        }
+        // zero latency responses and timers scheduled for now are handled by another step at the same time
+        m_clock.advanceTo(nextEventTime);
+    }
+    m_clock.advanceTo(endTimeNs);
+    return steps;
+}
+
+} // ordermanagement namespace
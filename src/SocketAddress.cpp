@@ -0,0 +1,122 @@
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "SocketAddress.h"
+
+namespace ordermanagement {
+
+namespace {
+// sockaddr of the address, returns its length
+socklen_t toSockaddr(const SocketAddress& address, sockaddr_storage& storage)
+{
+    std::memset(&storage, 0, sizeof(storage));
+    if (address.unixDomain) {
+        auto* unixAddress = reinterpret_cast<sockaddr_un*>(&storage);
+        unixAddress->sun_family = AF_UNIX;
+        std::strncpy(unixAddress->sun_path, address.path.c_str(), sizeof(unixAddress->sun_path) - 1);
+        return sizeof(sockaddr_un);
+    }
+    auto* inetAddress = reinterpret_cast<sockaddr_in*>(&storage);
+    inetAddress->sin_family = AF_INET;
+    inetAddress->sin_port = htons(address.port);
+    inet_pton(AF_INET, address.host.c_str(), &inetAddress->sin_addr);
+    return sizeof(sockaddr_in);
+}
+
+void setNoDelay(int fd)
+{
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+}
+} // unnamed namespace
+
+SocketAddress parseSocketAddress(const std::string& address)
+{
+    SocketAddress result;
+    if (address.rfind("unix:", 0) == 0 && address.size() > 5) {
+        result.unixDomain = true;
+        result.path = address.substr(5);
+        if (result.path.size() >= sizeof(sockaddr_un::sun_path)) {
+            throw std::runtime_error("Unix socket path is too long " + result.path);
+        }
+        return result;
+    }
+    const auto portPos = address.rfind(':');
+    if (address.rfind("tcp:", 0) != 0 || portPos <= 4) {
+        throw std::runtime_error("Invalid socket address " + address);
+    }
+    result.host = address.substr(4, portPos - 4);
+    in_addr unused;
+    if (inet_pton(AF_INET, result.host.c_str(), &unused) != 1) {
+        throw std::runtime_error("Invalid IPv4 address " + result.host);
+    }
+    result.port = static_cast<uint16_t>(std::stoul(address.substr(portPos + 1)));
+    return result;
+}
+
+int connectSocket(const SocketAddress& address, bool& inProgress)
+{
+    inProgress = false;
+    const int fd = socket(address.unixDomain ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (!address.unixDomain) {
+        setNoDelay(fd);
+    }
+    sockaddr_storage storage;
+    const socklen_t length = toSockaddr(address, storage);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&storage), length) == 0) {
+        return fd;
+    }
+    if (errno == EINPROGRESS) {
+        inProgress = true;
+        return fd;
+    }
+    const int error = errno;
+    close(fd);
+    errno = error;
+    return -1;
+}
+
+int listenSocket(const SocketAddress& address)
+{
+    const int fd = socket(address.unixDomain ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Can't create socket: ") + std::strerror(errno));
+    }
+    if (address.unixDomain) {
+        unlink(address.path.c_str());
+    } else {
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+    sockaddr_storage storage;
+    const socklen_t length = toSockaddr(address, storage);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&storage), length) != 0 || listen(fd, SOMAXCONN) != 0) {
+        const std::string error = std::strerror(errno);
+        close(fd);
+        throw std::runtime_error("Can't listen: " + error);
+    }
+    return fd;
+}
+
+int acceptSocket(int listenFd)
+{
+    const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd >= 0) {
+        // harmless on unix sockets
+        setNoDelay(fd);
+    }
+    return fd;
+}
+
+} // ordermanagement namespace
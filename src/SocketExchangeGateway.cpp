@@ -0,0 +1,462 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "SocketExchangeGateway.h"
+#include "Logger.h"
+
+namespace ordermanagement {
+
+namespace {
+constexpr int MAX_EPOLL_EVENTS = 16;
+// iovecs per write call, well below IOV_MAX
+constexpr size_t MAX_WRITE_BUFFERS = 64;
+} // unnamed namespace
+
+SocketExchangeGateway::SocketExchangeGateway(OrderManagement* manager)
+    : m_manager(manager)
+    , m_address(parseSocketAddress(manager->getConfig().exchangeAddress))
+    , m_reconnectIntervalNs(manager->getConfig().gatewayReconnectIntervalMs * 1000000ull)
+    , m_sendBufferSize(std::max<size_t>(manager->getConfig().gatewaySendBufferSize, wire::LogonMessage::MESSAGE_SIZE))
+    , m_unanswered(manager->getConfig().inFlightTableSize)
+    , m_controlBuffer(wire::LogonMessage::MESSAGE_SIZE)
+    , m_readBufferSize(std::max<size_t>(manager->getConfig().gatewayReadBufferSize, wire::LogonMessage::MESSAGE_SIZE))
+{
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epollFd < 0 || m_wakeFd < 0) {
+        throw std::runtime_error(std::string("Can't create the gateway event loop: ") + std::strerror(errno));
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = m_wakeFd;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+    m_readBuffer = std::make_unique<uint8_t[]>(m_readBufferSize);
+    // a full read buffer of responses never makes the vector grow
+    m_responses.reserve(m_readBufferSize / wire::OrderResponseMessage::MESSAGE_SIZE);
+    m_thread = std::make_unique<std::thread>(&SocketExchangeGateway::run, this);
+}
+
+SocketExchangeGateway::~SocketExchangeGateway()
+{
+    m_terminate = true;
+    wakeUp();
+    m_thread->join();
+    if (m_socketFd >= 0) {
+        close(m_socketFd);
+    }
+    close(m_wakeFd);
+    close(m_epollFd);
+}
+
+GatewayStats SocketExchangeGateway::getStats() const
+{
+    return GatewayStats{m_ordersSent.load(std::memory_order_relaxed), m_writeCalls.load(std::memory_order_relaxed),
+                        m_bytesWritten.load(std::memory_order_relaxed),
+                        m_responsesReceived.load(std::memory_order_relaxed),
+                        m_readCalls.load(std::memory_order_relaxed), m_connects.load(std::memory_order_relaxed),
+                        m_localRejects.load(std::memory_order_relaxed)};
+}
+
+wire::SendBuffer& SocketExchangeGateway::tailBuffer(size_t messageSize)
+{
+    if (m_queuedBuffers.empty()
+        || m_queuedBuffers.back()->size() + messageSize > m_queuedBuffers.back()->capacity()) {
+        if (m_freeBuffers.empty()) {
+            // only until there are enough buffers for the orders written per event loop iteration
+            m_queuedBuffers.push_back(std::make_unique<wire::SendBuffer>(m_sendBufferSize));
+        } else {
+            m_queuedBuffers.push_back(std::move(m_freeBuffers.back()));
+            m_freeBuffers.pop_back();
+        }
+    }
+    return *m_queuedBuffers.back();
+}
+
+bool SocketExchangeGateway::markWakePending()
+{
+    const bool wake = !m_wakePending;
+    m_wakePending = true;
+    return wake;
+}
+
+void SocketExchangeGateway::wakeUp()
+{
+    const uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = write(m_wakeFd, &one, sizeof(one));
+}
+
+void SocketExchangeGateway::send(const OrderRequest& request)
+{
+    sendBatch(std::span<const OrderRequest>(&request, 1));
+}
+
+void SocketExchangeGateway::sendBatch(std::span<const OrderRequest> requests)
+{
+    bool wake = false;
+    bool connected;
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        connected = m_state != ConnectionState::Disconnected;
+        if (connected) {
+            for (const auto& request : requests) {
+                wire::encode(request, tailBuffer(wire::NewOrderMessage::MESSAGE_SIZE));
+                m_unanswered.emplace(request.orderId, true);
+            }
+            m_ordersSent.fetch_add(requests.size(), std::memory_order_relaxed);
+            wake = markWakePending();
+        }
+    }
+    if (!connected) {
+        rejectLocally(requests);
+    } else if (wake) {
+        wakeUp();
+    }
+}
+
+void SocketExchangeGateway::sendReplace(const OrderRequest& request)
+{
+    bool wake = false;
+    bool connected;
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        connected = m_state != ConnectionState::Disconnected;
+        if (connected) {
+            wire::encodeReplace(request, tailBuffer(wire::CancelReplaceMessage::MESSAGE_SIZE));
+            // the response to the order it replaces has already arrived
+            m_unanswered.emplace(request.orderId, true);
+            m_ordersSent.fetch_add(1, std::memory_order_relaxed);
+            wake = markWakePending();
+        }
+    }
+    if (!connected) {
+        rejectLocally(std::span<const OrderRequest>(&request, 1));
+    } else if (wake) {
+        wakeUp();
+    }
+}
+
+void SocketExchangeGateway::rejectLocally(std::span<const OrderRequest> requests)
+{
+    m_localRejects.fetch_add(requests.size(), std::memory_order_relaxed);
+    for (const auto& request : requests) {
+        m_manager->onData(OrderResponse{request.orderId, ResponseType::Reject});
+    }
+}
+
+void SocketExchangeGateway::sendLogon(const Logon& logon)
+{
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        m_sessionWanted = true;
+        m_logon = logon;
+        if (m_state == ConnectionState::Connected) {
+            if (!wire::encode(logon, tailBuffer(wire::LogonMessage::MESSAGE_SIZE))) {
+                OM_LOG_ERROR("Username or password doesn't fit into the Logon message");
+            }
+        } else if (m_state == ConnectionState::Disconnected) {
+            // the gateway thread connects, orders are queued until then
+            m_state = ConnectionState::Connecting;
+        }
+        wake = markWakePending();
+    }
+    if (wake) {
+        wakeUp();
+    }
+}
+
+void SocketExchangeGateway::sendLogout(const Logout& logout)
+{
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        m_sessionWanted = false;
+        m_loggedOn = false;
+        // behind the orders sent before it, the connection stays open for their responses
+        if (m_state != ConnectionState::Disconnected) {
+            wire::encode(logout, tailBuffer(wire::LogoutMessage::MESSAGE_SIZE));
+            wake = markWakePending();
+        }
+    }
+    if (wake) {
+        wakeUp();
+    }
+}
+
+void SocketExchangeGateway::run()
+{
+    epoll_event events[MAX_EPOLL_EVENTS];
+    while (!m_terminate) {
+        int timeoutMs = -1;
+        if (m_nextConnectTimeNs != 0) {
+            const uint64_t currentTime = getCurrentTimeNs();
+            timeoutMs = currentTime >= m_nextConnectTimeNs
+                ? 0 : static_cast<int>((m_nextConnectTimeNs - currentTime) / 1000000 + 1);
+        }
+        const int count = epoll_wait(m_epollFd, events, MAX_EPOLL_EVENTS, timeoutMs);
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.fd == m_wakeFd) {
+                uint64_t value;
+                [[maybe_unused]] const ssize_t bytesRead = read(m_wakeFd, &value, sizeof(value));
+                continue;
+            }
+            // the socket could have been closed by an earlier event of this iteration
+            if (events[i].data.fd != m_socketFd) {
+                continue;
+            }
+            if (m_connecting && (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(m_socketFd, SOL_SOCKET, SO_ERROR, &error, &length);
+                if (error != 0) {
+                    disconnect(std::strerror(error));
+                } else {
+                    onConnected();
+                }
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                // a hang up is seen as the end of the stream once the responses before it have been read
+                readResponses();
+            }
+            if (m_socketFd >= 0 && (events[i].events & EPOLLOUT)) {
+                m_waitingForWritable = false;
+                updateEpollEvents();
+            }
+        }
+        if (m_nextConnectTimeNs != 0 && getCurrentTimeNs() >= m_nextConnectTimeNs) {
+            m_nextConnectTimeNs = 0;
+            std::lock_guard<std::mutex> lock(m_sendMutex);
+            if (m_sessionWanted) {
+                m_state = ConnectionState::Connecting;
+            }
+        }
+        bool connectRequested;
+        {
+            std::lock_guard<std::mutex> lock(m_sendMutex);
+            m_wakePending = false;
+            connectRequested = m_state == ConnectionState::Connecting && m_socketFd < 0;
+        }
+        if (connectRequested) {
+            connect();
+        }
+        flush();
+    }
+}
+
+void SocketExchangeGateway::connect()
+{
+    bool inProgress;
+    m_socketFd = connectSocket(m_address, inProgress);
+    if (m_socketFd < 0) {
+        disconnect(std::strerror(errno));
+        return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.fd = m_socketFd;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_socketFd, &event);
+    m_connecting = inProgress;
+    if (!inProgress) {
+        onConnected();
+    }
+}
+
+void SocketExchangeGateway::onConnected()
+{
+    m_connecting = false;
+    updateEpollEvents();
+    m_connects.fetch_add(1, std::memory_order_relaxed);
+    m_controlBuffer.clear();
+    m_controlOffset = 0;
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    m_state = ConnectionState::Connected;
+    // the Logon goes out ahead of the orders queued while connecting
+    if (!wire::encode(m_logon, m_controlBuffer)) {
+        OM_LOG_ERROR("Username or password doesn't fit into the Logon message");
+    }
+}
+
+void SocketExchangeGateway::disconnect(const char* reason)
+{
+    if (m_socketFd >= 0) {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, m_socketFd, nullptr);
+        close(m_socketFd);
+        m_socketFd = -1;
+    }
+    m_connecting = false;
+    m_waitingForWritable = false;
+    m_loggedOn = false;
+    m_readBytes = 0;
+    m_controlBuffer.clear();
+    m_controlOffset = 0;
+    m_writeOffset = 0;
+    bool reconnect;
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        m_state = ConnectionState::Disconnected;
+        reconnect = m_sessionWanted;
+        m_unanswered.forEach([this](uint64_t orderId, bool) { m_rejectedOrders.push_back(orderId); });
+        m_unanswered.clear();
+        for (auto* buffers : {&m_writeBuffers, &m_queuedBuffers}) {
+            for (auto& buffer : *buffers) {
+                buffer->clear();
+                m_freeBuffers.push_back(std::move(buffer));
+            }
+            buffers->clear();
+        }
+    }
+    m_nextConnectTimeNs = reconnect ? getCurrentTimeNs() + m_reconnectIntervalNs : 0;
+    OM_LOG_WARNING("Exchange connection lost: {}, {} unanswered orders rejected", reason, m_rejectedOrders.size());
+    m_localRejects.fetch_add(m_rejectedOrders.size(), std::memory_order_relaxed);
+    for (uint64_t orderId : m_rejectedOrders) {
+        m_manager->onData(OrderResponse{orderId, ResponseType::Reject});
+    }
+    m_rejectedOrders.clear();
+}
+
+void SocketExchangeGateway::updateEpollEvents()
+{
+    epoll_event event{};
+    event.events = EPOLLIN | (m_connecting || m_waitingForWritable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    event.data.fd = m_socketFd;
+    epoll_ctl(m_epollFd, EPOLL_CTL_MOD, m_socketFd, &event);
+}
+
+void SocketExchangeGateway::flush()
+{
+    if (m_socketFd < 0 || m_connecting || m_waitingForWritable) {
+        return;
+    }
+    iovec iovecs[MAX_WRITE_BUFFERS + 1];
+    size_t writtenBuffers = 0;
+    for (;;) {
+        {
+            // written buffers go back to the free list and everything queued since the last write is taken
+            std::lock_guard<std::mutex> lock(m_sendMutex);
+            for (size_t i = 0; i < writtenBuffers; ++i) {
+                m_writeBuffers[i]->clear();
+                m_freeBuffers.push_back(std::move(m_writeBuffers[i]));
+            }
+            m_writeBuffers.erase(m_writeBuffers.begin(), m_writeBuffers.begin() + writtenBuffers);
+            for (auto& buffer : m_queuedBuffers) {
+                m_writeBuffers.push_back(std::move(buffer));
+            }
+            m_queuedBuffers.clear();
+        }
+        writtenBuffers = 0;
+        size_t count = 0;
+        if (m_controlOffset < m_controlBuffer.size()) {
+            iovecs[count++] = iovec{const_cast<uint8_t*>(m_controlBuffer.data()) + m_controlOffset,
+                                    m_controlBuffer.size() - m_controlOffset};
+        }
+        size_t offset = m_writeOffset;
+        for (size_t i = 0; i < m_writeBuffers.size() && i < MAX_WRITE_BUFFERS; ++i) {
+            iovecs[count++] = iovec{const_cast<uint8_t*>(m_writeBuffers[i]->data()) + offset,
+                                    m_writeBuffers[i]->size() - offset};
+            offset = 0;
+        }
+        if (count == 0) {
+            return;
+        }
+        // sendmsg is writev that doesn't raise SIGPIPE when the exchange has gone away
+        msghdr message{};
+        message.msg_iov = iovecs;
+        message.msg_iovlen = count;
+        const ssize_t result = sendmsg(m_socketFd, &message, MSG_NOSIGNAL);
+        m_writeCalls.fetch_add(1, std::memory_order_relaxed);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                m_waitingForWritable = true;
+                updateEpollEvents();
+            } else {
+                disconnect(std::strerror(errno));
+            }
+            return;
+        }
+        m_bytesWritten.fetch_add(result, std::memory_order_relaxed);
+        size_t written = static_cast<size_t>(result);
+        if (m_controlOffset < m_controlBuffer.size()) {
+            const size_t controlBytes = std::min(written, m_controlBuffer.size() - m_controlOffset);
+            m_controlOffset += controlBytes;
+            written -= controlBytes;
+        }
+        while (written > 0) {
+            const size_t remaining = m_writeBuffers[writtenBuffers]->size() - m_writeOffset;
+            if (written < remaining) {
+                m_writeOffset += written;
+                break;
+            }
+            written -= remaining;
+            m_writeOffset = 0;
+            ++writtenBuffers;
+        }
+        if (writtenBuffers == 0 && m_controlOffset == m_controlBuffer.size() && m_writeBuffers.empty()) {
+            return;
+        }
+    }
+}
+
+void SocketExchangeGateway::readResponses()
+{
+    for (;;) {
+        const size_t requested = m_readBufferSize - m_readBytes;
+        const ssize_t result = read(m_socketFd, m_readBuffer.get() + m_readBytes, requested);
+        m_readCalls.fetch_add(1, std::memory_order_relaxed);
+        if (result == 0) {
+            disconnect("closed by the exchange");
+            return;
+        }
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                disconnect(std::strerror(errno));
+            }
+            return;
+        }
+        m_readBytes += result;
+        const size_t consumed = wire::forEachMessage(
+            std::span<const uint8_t>(m_readBuffer.get(), m_readBytes),
+            [this](const wire::MessageHeader& header, const uint8_t* message) {
+                if (header.templateId == wire::OrderResponseMessage::TEMPLATE_ID) {
+                    m_responses.push_back(wire::decodeOrderResponse(message));
+                } else if (header.templateId == wire::LogonMessage::TEMPLATE_ID) {
+                    m_loggedOn = true;
+                }
+            });
+        // the beginning of the next message waits at the start of the buffer for the rest of it
+        std::memmove(m_readBuffer.get(), m_readBuffer.get() + consumed, m_readBytes - consumed);
+        m_readBytes -= consumed;
+        if (!m_responses.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(m_sendMutex);
+                for (const auto& response : m_responses) {
+                    m_unanswered.erase(response.orderId);
+                }
+            }
+            m_responsesReceived.fetch_add(m_responses.size(), std::memory_order_relaxed);
+            for (auto& response : m_responses) {
+                m_manager->onData(std::move(response));
+            }
+            m_responses.clear();
+        }
+        // a short read means that the socket has been drained
+        if (static_cast<size_t>(result) < requested) {
+            return;
+        }
+    }
+}
+
+} // ordermanagement namespace
@@ -0,0 +1,145 @@
+#include "StatsBus.h"
+
+namespace ordermanagement {
+
+StatsBus::Subscriber::Subscriber(std::unique_ptr<IOrderStatsCollectorCallBack> callback, size_t queueSize,
+                                 OverflowPolicy overflowPolicy)
+    : callback(std::move(callback))
+    // delivery threads are not latency critical, they should not spin
+    , records(queueSize, overflowPolicy, WaitStrategyType::Park, 0, 0)
+{
+}
+
+StatsBus::StatsBus(const Config& config)
+    : m_defaultQueueSize(config.statsRingSize)
+    , m_flushIntervalNs(config.statsFlushIntervalMs * 1000000ull)
+    , m_overflowPolicy(config.statsOverflowPolicy)
+{
+}
+
+StatsBus::~StatsBus()
+{
+    for (SubscriberId id = 0; id < MAX_SUBSCRIBERS; ++id) {
+        unsubscribe(id);
+    }
+}
+
+SubscriberId StatsBus::subscribe(std::unique_ptr<IOrderStatsCollectorCallBack> callback, size_t queueSize)
+{
+    return addSubscriber(std::move(callback), queueSize);
+}
+
+SubscriberId StatsBus::subscribePolling(size_t queueSize)
+{
+    return addSubscriber(nullptr, queueSize);
+}
+
+SubscriberId StatsBus::addSubscriber(std::unique_ptr<IOrderStatsCollectorCallBack> callback, size_t queueSize)
+{
+    std::lock_guard<std::mutex> lock(m_subscribersMutex);
+    for (SubscriberId id = 0; id < MAX_SUBSCRIBERS; ++id) {
+        if (m_ownedSubscribers[id]) {
+            continue;
+        }
+        auto subscriber = std::make_unique<Subscriber>(std::move(callback),
+                                                       queueSize == 0 ? m_defaultQueueSize : queueSize,
+                                                       m_overflowPolicy);
+        if (IOrderStatsCollectorCallBack* statsCallback = subscriber->callback.get()) {
+            subscriber->records.startDelivery(
+                [statsCallback](std::span<StatsRecord> records) {
+                    for (auto& record : records) {
+                        statsCallback->processOrderStatisticsInfo(std::move(record.response), record.stats);
+                    }
+                },
+                [statsCallback] { statsCallback->flush(); },
+                m_flushIntervalNs, DELIVERY_BATCH_SIZE);
+        }
+        m_subscribers[id].store(subscriber.get(), std::memory_order_seq_cst);
+        m_ownedSubscribers[id] = std::move(subscriber);
+        return id;
+    }
+    return INVALID_SUBSCRIBER;
+}
+
+bool StatsBus::unsubscribe(SubscriberId id)
+{
+    std::lock_guard<std::mutex> lock(m_subscribersMutex);
+    if (id >= MAX_SUBSCRIBERS || !m_ownedSubscribers[id]) {
+        return false;
+    }
+    m_subscribers[id].store(nullptr, std::memory_order_seq_cst);
+    waitForPublishers();
+    // delivers what is still queued
+    m_ownedSubscribers[id]->records.stopDelivery();
+    m_ownedSubscribers[id].reset();
+    return true;
+}
+
+void StatsBus::waitForPublishers()
+{
+    const uint64_t oldEpoch = m_publisherEpoch.fetch_add(1, std::memory_order_seq_cst);
+    // new publishers register in the other counter, so this one drains even under a constant publishing load
+    while (m_activePublishers[oldEpoch & 1].load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void StatsBus::publish(const OrderResponse& response, const OrderStats& stats)
+{
+    uint64_t epoch = m_publisherEpoch.load(std::memory_order_seq_cst);
+    for (;;) {
+        m_activePublishers[epoch & 1].fetch_add(1, std::memory_order_seq_cst);
+        // the epoch has been flipped in between, an unsubscribe could already be waiting on the other counter
+        const uint64_t currentEpoch = m_publisherEpoch.load(std::memory_order_seq_cst);
+        if (currentEpoch == epoch) {
+            break;
+        }
+        m_activePublishers[epoch & 1].fetch_sub(1, std::memory_order_seq_cst);
+        epoch = currentEpoch;
+    }
+
+    const StatsRecord record{response, stats};
+    for (auto& slot : m_subscribers) {
+        Subscriber* subscriber = slot.load(std::memory_order_seq_cst);
+        if (subscriber == nullptr) {
+            continue;
+        }
+        // with a flush interval the delivery thread wakes up once per interval, or when the queue gets full,
+        // without one every record wakes it up
+        subscriber->records.push(record, m_flushIntervalNs == 0);
+    }
+
+    m_activePublishers[epoch & 1].fetch_sub(1, std::memory_order_seq_cst);
+}
+
+size_t StatsBus::poll(SubscriberId id, std::vector<StatsRecord>& records, size_t maxRecords)
+{
+    if (id >= MAX_SUBSCRIBERS) {
+        return 0;
+    }
+    Subscriber* subscriber = m_subscribers[id].load(std::memory_order_acquire);
+    if (subscriber == nullptr || subscriber->callback) {
+        return 0;
+    }
+    return subscriber->records.consume([&records](StatsRecord& record) { records.push_back(record); },
+                                       maxRecords);
+}
+
+SubscriberStats StatsBus::getSubscriberStats(SubscriberId id) const
+{
+    SubscriberStats stats;
+    // keeps the subscriber alive while its counters are read
+    std::lock_guard<std::mutex> lock(m_subscribersMutex);
+    if (id >= MAX_SUBSCRIBERS || !m_ownedSubscribers[id]) {
+        return stats;
+    }
+    const auto& records = m_ownedSubscribers[id]->records;
+    stats.delivered = records.delivered();
+    stats.dropped = records.dropped();
+    stats.published = records.published();
+    // published is read last, so that the lag never goes negative
+    stats.lag = stats.published - stats.delivered - stats.dropped;
+    return stats;
+}
+
+} // ordermanagement namespace
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "StressExchangeSimulator.h"
+#include "BinaryStatsFile.h"
+
+namespace ordermanagement {
+
+LatencyModel LatencyModel::fixed(uint64_t latencyNs)
+{
+    LatencyModel model(LatencyModelType::Fixed);
+    model.m_fixedNs = latencyNs;
+    return model;
+}
+
+LatencyModel LatencyModel::logNormal(uint64_t medianNs, double sigma)
+{
+    LatencyModel model(LatencyModelType::LogNormal);
+    // the median of a lognormal distribution is e^m
+    model.m_logNormal = std::lognormal_distribution<double>(std::log(std::max<double>(medianNs, 1.0)), sigma);
+    return model;
+}
+
+LatencyModel LatencyModel::fromHistogram(const LatencyHistogram& histogram)
+{
+    LatencyModel model(LatencyModelType::Histogram);
+    uint64_t cumulativeCount = 0;
+    for (size_t index = 0; index < LatencyHistogram::BUCKET_COUNT; ++index) {
+        if (histogram.bucketCount(index) == 0) {
+            continue;
+        }
+        cumulativeCount += histogram.bucketCount(index);
+        model.m_buckets.push_back(index);
+        model.m_cumulativeCounts.push_back(cumulativeCount);
+    }
+    if (model.m_buckets.empty()) {
+        throw std::runtime_error("Can't replay latencies of an empty histogram");
+    }
+    return model;
+}
+
+LatencyModel LatencyModel::fromStatsFile(const std::string& filename)
+{
+    MappedStatsFile statsFile(filename);
+    LatencyHistogram histogram;
+    for (const auto& record : statsFile.records()) {
+        if (record.requestSendTimeNs != 0 && record.responseReceivalTimeNs >= record.requestSendTimeNs) {
+            histogram.record(record.responseReceivalTimeNs - record.requestSendTimeNs);
+        }
+    }
+    return fromHistogram(histogram);
+}
+
+LatencyModel LatencyModel::fromConfig(const Config& config)
+{
+    switch (config.exchangeLatencyModel) {
+        case LatencyModelType::LogNormal:
+            return logNormal(config.exchangeLatencyNs, config.exchangeLatencySigma);
+        case LatencyModelType::Histogram:
+            return fromStatsFile(config.exchangeLatencyFile);
+        default:
+            return fixed(config.exchangeLatencyNs);
+    }
+}
+
+uint64_t LatencyModel::sample(std::mt19937_64& generator)
+{
+    switch (m_type) {
+        case LatencyModelType::LogNormal:
+            return static_cast<uint64_t>(std::min<double>(m_logNormal(generator), LatencyHistogram::MAX_VALUE));
+        case LatencyModelType::Histogram: {
+                const uint64_t position = generator() % m_cumulativeCounts.back();
+                const size_t bucket = std::upper_bound(m_cumulativeCounts.begin(), m_cumulativeCounts.end(), position)
+                                    - m_cumulativeCounts.begin();
+                const size_t index = m_buckets[bucket];
+                return LatencyHistogram::bucketLowestValue(index) + generator() % LatencyHistogram::bucketWidth(index);
+            }
+        default:
+            return m_fixedNs;
+    }
+}
+
+StressExchangeSimulator::Worker::Worker(size_t ringSize, const Config& config, const LatencyModel& latencyModel,
+                                        double rejectRatio, uint64_t seed)
+    : requests(ringSize)
+    , waitStrategy(config.waitStrategy, config.waitSpinIterations, config.waitYieldIterations)
+    , latencyModel(latencyModel)
+    , generator(seed)
+    , reject(std::clamp(rejectRatio, 0.0, 1.0))
+{
+    pending.reserve(ringSize);
+}
+
+StressExchangeSimulator::StressExchangeSimulator(OrderManagement* manager, uint32_t seed)
+    : StressExchangeSimulator(manager, LatencyModel::fromConfig(manager->getConfig()),
+                              manager->getConfig().exchangeRejectRatio,
+                              manager->getConfig().exchangeRateLimit,
+                              manager->getConfig().exchangeRateWindowMs * 1000000ull,
+                              manager->getConfig().exchangeResponseThreads, seed)
+{
+}
+
+StressExchangeSimulator::StressExchangeSimulator(OrderManagement* manager, LatencyModel latencyModel,
+                                                 double rejectRatio, uint32_t rateLimit, uint64_t rateWindowNs,
+                                                 uint32_t responseThreads, uint32_t seed)
+    : m_manager(manager)
+{
+    if (rateLimit > 0) {
+        m_rateLimit = std::make_unique<SlidingWindowCredits>(rateLimit, rateWindowNs, nullptr);
+    }
+    const Config& config = manager->getConfig();
+    // the manager never has more than InFlightTableSize orders waiting for a response,
+    // so a worker ring of that size doesn't get full
+    for (uint32_t i = 0; i < std::max(1u, responseThreads); ++i) {
+        m_workers.push_back(std::make_unique<Worker>(config.inFlightTableSize, config, latencyModel, rejectRatio,
+                                                     static_cast<uint64_t>(seed) + i));
+    }
+    for (auto& worker : m_workers) {
+        worker->thread = std::make_unique<std::thread>(&StressExchangeSimulator::respond, this, worker.get());
+    }
+}
+
+StressExchangeSimulator::~StressExchangeSimulator()
+{
+    m_terminated = true;
+    for (auto& worker : m_workers) {
+        worker->waitStrategy.interrupt();
+    }
+    for (auto& worker : m_workers) {
+        worker->thread->join();
+    }
+}
+
+void StressExchangeSimulator::sendLogon(const Logon&)
+{
+    m_loggedIn = true;
+}
+
+void StressExchangeSimulator::sendLogout(const Logout&)
+{
+    m_loggedIn = false;
+}
+
+uint64_t StressExchangeSimulator::getRespondedCount() const
+{
+    uint64_t responded = 0;
+    for (const auto& worker : m_workers) {
+        responded += worker->responded.load(std::memory_order_relaxed);
+    }
+    return responded;
+}
+
+void StressExchangeSimulator::send(const OrderRequest& request)
+{
+    addRequest(request, getCurrentTimeNs());
+    m_workers[request.orderId % m_workers.size()]->waitStrategy.notify();
+}
+
+void StressExchangeSimulator::sendBatch(std::span<const OrderRequest> requests)
+{
+    // the whole batch is received at the same time
+    const uint64_t currentTime = getCurrentTimeNs();
+    for (const auto& request : requests) {
+        addRequest(request, currentTime);
+    }
+    for (auto& worker : m_workers) {
+        worker->waitStrategy.notify();
+    }
+}
+
+void StressExchangeSimulator::addRequest(const OrderRequest& request, uint64_t currentTime)
+{
+    m_received.fetch_add(1, std::memory_order_relaxed);
+    ResponseType responseType = ResponseType::Accept;
+    if (m_rateLimit && m_rateLimit->acquire(currentTime, 1) == 0) {
+        responseType = ResponseType::Reject;
+        m_rateLimitRejects.fetch_add(1, std::memory_order_relaxed);
+    }
+    const PendingResponse response{request.orderId, currentTime, responseType};
+    Worker& worker = *m_workers[request.orderId % m_workers.size()];
+    while (!worker.requests.tryPush(response)) {
+        if (m_terminated) {
+            return;
+        }
+        worker.waitStrategy.notify();
+        cpuRelax();
+    }
+}
+
+void StressExchangeSimulator::respond(Worker* worker)
+{
+    // min heap by due time
+    const auto heapOrder = [](const PendingResponse& left, const PendingResponse& right) {
+        return left.dueTimeNs > right.dueTimeNs;
+    };
+    auto& pending = worker->pending;
+    while (!m_terminated) {
+        const uint64_t waitEpoch = worker->waitStrategy.prepareWait();
+        PendingResponse response;
+        while (worker->requests.tryPop(response)) {
+            response.dueTimeNs += worker->latencyModel.sample(worker->generator);
+            if (response.responseType == ResponseType::Accept && worker->reject(worker->generator)) {
+                response.responseType = ResponseType::Reject;
+            }
+            pending.push_back(response);
+            std::push_heap(pending.begin(), pending.end(), heapOrder);
+        }
+        const uint64_t currentTime = getCurrentTimeNs();
+        uint64_t responded = 0;
+        while (!pending.empty() && pending.front().dueTimeNs <= currentTime) {
+            std::pop_heap(pending.begin(), pending.end(), heapOrder);
+            const PendingResponse due = pending.back();
+            pending.pop_back();
+            m_manager->onData(OrderResponse{due.orderId, due.responseType});
+            ++responded;
+        }
+        if (responded > 0) {
+            worker->responded.fetch_add(responded, std::memory_order_relaxed);
+            continue;
+        }
+        // sleeps until the next response is due, send() wakes it up earlier
+        worker->waitStrategy.waitForWork(waitEpoch, pending.empty() ? WaitStrategy::NO_DEADLINE
+                                                                     : pending.front().dueTimeNs);
+    }
+}
+
+} // ordermanagement namespace
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "ThrottleCoordinator.h"
+#include "Config.h"
+
+namespace ordermanagement {
+
+SlidingWindowCredits::SlidingWindowCredits(uint32_t rate, uint64_t windowNs, const IClock* clock)
+    : m_clock(clock)
+    , m_windowNs(windowNs)
+    , m_rate(rate)
+{
+    if (rate == 0) {
+        throw std::runtime_error("Rate limiter rate can't be 0");
+    }
+    m_slots = std::make_unique<Slot[]>(rate);
+    for (uint32_t i = 0; i < rate; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        m_slots[i].grantTimeNs.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t SlidingWindowCredits::countPermitted(uint64_t credit, uint64_t nowNs, uint32_t maxCredits) const
+{
+    uint32_t count = 0;
+    while (count < maxCredits) {
+        const uint64_t next = credit + count;
+        const Slot& slot = m_slots[next % m_rate];
+        // until credit next - rate has been stamped there is nothing to check it against
+        if (slot.sequence.load(std::memory_order_acquire) != next) {
+            break;
+        }
+        if (next >= m_rate && slot.grantTimeNs.load(std::memory_order_relaxed) + m_windowNs > nowNs) {
+            break;
+        }
+        ++count;
+    }
+    return count;
+}
+
+uint64_t SlidingWindowCredits::nextPermittedTimeNs(uint64_t nowNs) const
+{
+    const uint64_t credit = m_nextCredit.load(std::memory_order_acquire);
+    const Slot& slot = m_slots[credit % m_rate];
+    if (slot.sequence.load(std::memory_order_acquire) != credit || credit < m_rate) {
+        // either nothing has been granted from the slot yet or its grant is being stamped right now,
+        // then it is worth trying again straight away
+        return nowNs;
+    }
+    return std::max(nowNs, slot.grantTimeNs.load(std::memory_order_relaxed) + m_windowNs);
+}
+
+uint32_t SlidingWindowCredits::availableCredits(uint64_t nowNs, uint32_t maxCredits) const
+{
+    return countPermitted(m_nextCredit.load(std::memory_order_acquire), nowNs, maxCredits);
+}
+
+uint32_t SlidingWindowCredits::acquire(uint64_t nowNs, uint32_t maxCredits)
+{
+    uint64_t credit = m_nextCredit.load(std::memory_order_acquire);
+    uint32_t count;
+    do {
+        count = countPermitted(credit, nowNs, maxCredits);
+        if (count == 0) {
+            return 0;
+        }
+    } while (!m_nextCredit.compare_exchange_weak(credit, credit + count, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire));
+    // the time is read after the CAS, so a grant is never stamped earlier than it happened
+    const uint64_t grantTime = std::max(nowNs, m_clock ? m_clock->nowNs() : getCurrentTimeNs());
+    for (uint32_t i = 0; i < count; ++i) {
+        Slot& slot = m_slots[(credit + i) % m_rate];
+        slot.grantTimeNs.store(grantTime, std::memory_order_relaxed);
+        slot.sequence.store(credit + i + m_rate, std::memory_order_release);
+    }
+    return count;
+}
+
+GcraCredits::GcraCredits(uint32_t rate, uint64_t periodNs, uint32_t burst)
+    : m_emissionIntervalNs(periodNs / std::max(rate, 1u))
+    , m_toleranceNs(m_emissionIntervalNs * (std::max(burst, 1u) - 1))
+    , m_burst(std::max(burst, 1u))
+{
+    if (rate == 0) {
+        throw std::runtime_error("Rate limiter rate can't be 0");
+    }
+}
+
+uint32_t GcraCredits::budget(uint64_t theoreticalArrivalTimeNs, uint64_t nowNs) const
+{
+    if (theoreticalArrivalTimeNs <= nowNs) {
+        return m_burst;
+    }
+    const uint64_t debtNs = theoreticalArrivalTimeNs - nowNs;
+    if (debtNs > m_toleranceNs) {
+        return 0;
+    }
+    return static_cast<uint32_t>((m_toleranceNs - debtNs) / m_emissionIntervalNs) + 1;
+}
+
+uint64_t GcraCredits::nextPermittedTimeNs(uint64_t nowNs) const
+{
+    const uint64_t theoreticalArrivalTime = m_theoreticalArrivalTimeNs.load(std::memory_order_acquire);
+    if (theoreticalArrivalTime <= nowNs + m_toleranceNs) {
+        return nowNs;
+    }
+    return theoreticalArrivalTime - m_toleranceNs;
+}
+
+uint32_t GcraCredits::availableCredits(uint64_t nowNs, uint32_t maxCredits) const
+{
+    return std::min(budget(m_theoreticalArrivalTimeNs.load(std::memory_order_acquire), nowNs), maxCredits);
+}
+
+uint32_t GcraCredits::acquire(uint64_t nowNs, uint32_t maxCredits)
+{
+    uint64_t theoreticalArrivalTime = m_theoreticalArrivalTimeNs.load(std::memory_order_acquire);
+    uint32_t count;
+    do {
+        count = std::min(budget(theoreticalArrivalTime, nowNs), maxCredits);
+        if (count == 0) {
+            return 0;
+        }
+        // every credit moves the theoretical arrival time one emission interval forward
+    } while (!m_theoreticalArrivalTimeNs.compare_exchange_weak(
+                 theoreticalArrivalTime,
+                 std::max(theoreticalArrivalTime, nowNs) + count * m_emissionIntervalNs,
+                 std::memory_order_acq_rel, std::memory_order_acquire));
+    return count;
+}
+
+ThrottleCoordinator::ThrottleCoordinator(const Config& config, const IClock* clock)
+{
+    auto makeLimit = [&config, clock](uint32_t rate, uint64_t windowNs) -> std::unique_ptr<ISendCredits> {
+        if (config.throttleMode == ThrottleMode::Gcra) {
+            return std::make_unique<GcraCredits>(rate, windowNs, config.throttleBurst);
+        }
+        return std::make_unique<SlidingWindowCredits>(rate, windowNs, clock);
+    };
+    m_limits.push_back(makeLimit(config.throttlingRate, config.windowSizeSec * NS_IN_SECOND));
+    if (config.ratePerSecond != 0) {
+        m_limits.push_back(makeLimit(config.ratePerSecond, NS_IN_SECOND));
+    }
+}
+
+uint64_t ThrottleCoordinator::nextPermittedTimeNs(uint64_t nowNs) const
+{
+    uint64_t permittedTime = nowNs;
+    for (const auto& limit : m_limits) {
+        permittedTime = std::max(permittedTime, limit->nextPermittedTimeNs(nowNs));
+    }
+    return permittedTime;
+}
+
+uint32_t ThrottleCoordinator::acquire(uint64_t nowNs, uint32_t maxCredits)
+{
+    // asks all the limits first, so that credits are only lost when another transmitter wins a race in between
+    uint32_t credits = maxCredits;
+    for (const auto& limit : m_limits) {
+        credits = limit->availableCredits(nowNs, credits);
+        if (credits == 0) {
+            return 0;
+        }
+    }
+    for (auto& limit : m_limits) {
+        credits = limit->acquire(nowNs, credits);
+        if (credits == 0) {
+            return 0;
+        }
+    }
+    return credits;
+}
+
+} // ordermanagement namespace
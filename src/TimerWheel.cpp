@@ -0,0 +1,143 @@
+#include <algorithm>
+
+#include "TimerWheel.h"
+
+namespace ordermanagement {
+
+TimerWheel::TimerWheel(uint64_t tickNs, uint64_t startTimeNs)
+    : m_tickNs(std::max<uint64_t>(tickNs, 1))
+    , m_currentTick(startTimeNs / m_tickNs)
+{
+}
+
+TimerWheel::TimerId TimerWheel::schedule(uint64_t deadlineNs, Callback callback)
+{
+    const TimerId timerId = m_nextTimerId++;
+    // round up to the tick boundary, so that the timer never fires before its deadline
+    uint64_t deadlineTick = deadlineNs / m_tickNs + (deadlineNs % m_tickNs != 0 ? 1 : 0);
+    deadlineTick = std::max(deadlineTick, m_currentTick);
+    m_timers.emplace(timerId, Timer{deadlineNs, deadlineTick, std::move(callback)});
+    insert(timerId, deadlineTick);
+    return timerId;
+}
+
+bool TimerWheel::cancel(TimerId timerId)
+{
+    // the id stays in its slot and is dropped when the slot is processed
+    return m_timers.erase(timerId) > 0;
+}
+
+void TimerWheel::insert(TimerId timerId, uint64_t deadlineTick)
+{
+    const uint64_t delta = deadlineTick - m_currentTick;
+    for (uint32_t level = 0; level < LEVELS; ++level) {
+        if (delta < (1ull << (SLOT_BITS * (level + 1)))) {
+            m_wheel[level][(deadlineTick >> (SLOT_BITS * level)) & SLOT_MASK].push_back(timerId);
+            ++m_levelSizes[level];
+            return;
+        }
+    }
+    m_overflow.push_back(timerId);
+}
+
+void TimerWheel::cascade(uint32_t level)
+{
+    auto& slot = m_wheel[level][(m_currentTick >> (SLOT_BITS * level)) & SLOT_MASK];
+    std::vector<TimerId> timerIds;
+    timerIds.swap(slot);
+    m_levelSizes[level] -= timerIds.size();
+    for (auto timerId : timerIds) {
+        auto timerIt = m_timers.find(timerId);
+        if (timerIt != m_timers.end()) {
+            insert(timerId, timerIt->second.deadlineTick);
+        }
+    }
+}
+
+void TimerWheel::fireSlot(std::vector<TimerId>& slot, std::vector<TimerId>& fired)
+{
+    m_levelSizes[0] -= slot.size();
+    for (auto timerId : slot) {
+        if (m_timers.count(timerId)) {
+            fired.push_back(timerId);
+        }
+    }
+    slot.clear();
+}
+
+void TimerWheel::advance(uint64_t nowNs, std::vector<Callback>& due)
+{
+    const uint64_t nowTick = nowNs / m_tickNs;
+    std::vector<TimerId> fired;
+    // timers scheduled for the current (or a past) tick
+    fireSlot(m_wheel[0][m_currentTick & SLOT_MASK], fired);
+
+    while (m_currentTick < nowTick) {
+        if (m_levelSizes[0] == 0) {
+            // nothing can fire before the next tick that cascades the lowest non empty level,
+            // jump right before it
+            uint32_t level = 1;
+            while (level < LEVELS && m_levelSizes[level] == 0) {
+                ++level;
+            }
+            if (level == LEVELS && m_overflow.empty()) {
+                m_currentTick = nowTick;
+                break;
+            }
+            const uint64_t span = 1ull << (SLOT_BITS * level);
+            const uint64_t nextBoundary = (m_currentTick / span + 1) * span;
+            if (nextBoundary > nowTick) {
+                m_currentTick = nowTick;
+                break;
+            }
+            m_currentTick = nextBoundary - 1;
+        }
+        ++m_currentTick;
+
+        if ((m_currentTick & ((1ull << (SLOT_BITS * LEVELS)) - 1)) == 0) {
+            std::vector<TimerId> overflow;
+            overflow.swap(m_overflow);
+            for (auto timerId : overflow) {
+                auto timerIt = m_timers.find(timerId);
+                if (timerIt != m_timers.end()) {
+                    insert(timerId, timerIt->second.deadlineTick);
+                }
+            }
+        }
+        // cascade the levels whose slot boundary has been reached, top level first
+        uint32_t topLevel = 0;
+        while (topLevel + 1 < LEVELS
+            && (m_currentTick & ((1ull << (SLOT_BITS * (topLevel + 1))) - 1)) == 0) {
+            ++topLevel;
+        }
+        for (uint32_t level = topLevel; level > 0; --level) {
+            cascade(level);
+        }
+        fireSlot(m_wheel[0][m_currentTick & SLOT_MASK], fired);
+    }
+
+    std::sort(fired.begin(), fired.end(), [this](TimerId lhs, TimerId rhs) {
+        const auto& lhsTimer = m_timers.at(lhs);
+        const auto& rhsTimer = m_timers.at(rhs);
+        return lhsTimer.deadlineNs != rhsTimer.deadlineNs
+            ? lhsTimer.deadlineNs < rhsTimer.deadlineNs : lhs < rhs;
+    });
+    for (auto timerId : fired) {
+        auto timerIt = m_timers.find(timerId);
+        due.emplace_back(std::move(timerIt->second.callback));
+        m_timers.erase(timerIt);
+    }
+}
+
+uint64_t TimerWheel::nextDeadlineNs() const
+{
+    // only a handful of timers (session events) are pending at any time, a scan is cheaper
+    // than maintaining an ordered structure on every schedule/cancel
+    uint64_t nextTick = NO_TIMERS;
+    for (const auto& [timerId, timer] : m_timers) {
+        nextTick = std::min(nextTick, timer.deadlineTick);
+    }
+    return nextTick == NO_TIMERS ? NO_TIMERS : nextTick * m_tickNs;
+}
+
+} // ordermanagement namespace
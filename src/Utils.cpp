@@ -1,4 +1,3 @@
-#include <chrono>
 #include <iostream>
 #include "Utils.h"
 
@@ -18,11 +17,4 @@ std::ostream& operator<<(std::ostream& ofs, const OrderResponse& response)
     return ofs;
 }
 
-std::uint64_t getCurrentTimeNs()
-{
-    auto now = std::chrono::time_point_cast<std::chrono::nanoseconds>
-        (std::chrono::high_resolution_clock::now());
-    return now.time_since_epoch().count();
-}
-
 } // ordermanagement namespace
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <filesystem>
+#include <set>
+#include <stdexcept>
+
+#include "VenueEngine.h"
+#include "Logger.h"
+
+namespace ordermanagement {
+
+VenueEngine::TransmitterThread::TransmitterThread(const Config& config)
+    : waitStrategy(config.waitStrategy, config.waitSpinIterations, config.waitYieldIterations)
+{
+}
+
+VenueEngine::VenueEngine(const std::string& configFileName,
+                         std::unique_ptr<IOrderStatsCollectorCallBack> statsCollector,
+                         const IClock* clock)
+    : m_config(configFileName)
+    , m_clock(clock)
+    , m_sessionWaitStrategy(m_config.waitStrategy, m_config.waitSpinIterations, m_config.waitYieldIterations)
+    , m_orderEvents(m_config)
+    , m_statsBus(m_config)
+{
+    if (m_config.venues.empty()) {
+        throw std::runtime_error("Invalid config, Venues is empty");
+    }
+    if (statsCollector) {
+        m_statsBus.subscribe(std::move(statsCollector));
+    }
+    for (uint32_t i = 0; i < m_config.transmitterThreads; ++i) {
+        m_transmitters.push_back(std::make_unique<TransmitterThread>(m_config));
+    }
+    std::vector<Config> venueConfigs;
+    std::set<std::filesystem::path> journalFiles;
+    for (const auto& name : m_config.venues) {
+        venueConfigs.emplace_back(configFileName, name);
+        // checked before any venue opens its journal, a shared one would be reset and replayed by every venue
+        const std::string& journalFile = venueConfigs.back().journalFile;
+        if (!journalFile.empty()
+            && !journalFiles.insert(std::filesystem::weakly_canonical(journalFile)).second) {
+            throw std::runtime_error("Invalid config, venue " + name + " has the JournalFile " + journalFile
+                                     + " of another venue");
+        }
+    }
+    size_t nextTransmitter = 0;
+    for (const auto& venueConfig : venueConfigs) {
+        VenueServices services{&m_statsBus, &m_orderEvents, m_clock, &m_sessionWaitStrategy, {}};
+        std::vector<TransmitterThread*> shardTransmitters;
+        for (uint32_t shard = 0; shard < venueConfig.shardCount; ++shard) {
+            TransmitterThread* transmitter = m_transmitters[nextTransmitter++ % m_transmitters.size()].get();
+            services.shardWaitStrategies.push_back(&transmitter->waitStrategy);
+            shardTransmitters.push_back(transmitter);
+        }
+        m_venues.push_back(std::make_unique<OrderManagement>(venueConfig, services));
+        for (size_t shard = 0; shard < shardTransmitters.size(); ++shard) {
+            shardTransmitters[shard]->shards.emplace_back(m_venues.back().get(), shard);
+        }
+    }
+}
+
+VenueEngine::~VenueEngine()
+{
+    shutDown();
+}
+
+void VenueEngine::start()
+{
+    for (auto& venue : m_venues) {
+        venue->startDriven();
+    }
+    m_sessionThread = std::make_unique<std::thread>(&VenueEngine::runSessionTimers, this);
+    for (auto& transmitter : m_transmitters) {
+        transmitter->thread = std::make_unique<std::thread>(&VenueEngine::transmit, this, transmitter.get());
+    }
+}
+
+void VenueEngine::shutDown()
+{
+    m_terminate = true;
+    // stops the in flight waits of the venue transmitters and interrupts the shared waits
+    for (auto& venue : m_venues) {
+        venue->shutDown();
+    }
+    m_sessionWaitStrategy.interrupt();
+    for (auto& transmitter : m_transmitters) {
+        transmitter->waitStrategy.interrupt();
+    }
+    if (m_sessionThread && m_sessionThread->joinable()) {
+        m_sessionThread->join();
+        for (auto& transmitter : m_transmitters) {
+            transmitter->thread->join();
+        }
+    }
+}
+
+VenueId VenueEngine::getVenueId(const std::string& name) const
+{
+    const auto it = std::find(m_config.venues.begin(), m_config.venues.end(), name);
+    if (it == m_config.venues.end()) {
+        throw std::runtime_error("Unknown venue " + name);
+    }
+    return static_cast<VenueId>(it - m_config.venues.begin());
+}
+
+void VenueEngine::onData(VenueId venue, OrderRequest && request, RequestType requestType, ClientId clientId)
+{
+    if (venue < m_venues.size()) {
+        m_venues[venue]->onData(std::move(request), requestType, clientId);
+    } else if (clientId == NO_CLIENT) {
+        OM_LOG_WARNING("Order {} was rejected: {} {}", request.orderId, rejectCodeText(RejectCode::UnknownVenue),
+                       venue);
+    } else {
+        m_orderEvents.publish(clientId, OrderEvent{request.orderId, now(), OrderEventType::Rejected,
+                                                   RejectCode::UnknownVenue});
+    }
+}
+
+void VenueEngine::onDataBatch(VenueId venue, std::span<const BatchRequest> requests, std::span<RejectCode> results,
+                              ClientId clientId)
+{
+    if (venue < m_venues.size()) {
+        m_venues[venue]->onDataBatch(requests, results, clientId);
+        return;
+    }
+    if (results.size() < requests.size()) {
+        throw std::runtime_error("onDataBatch needs a result for every request");
+    }
+    for (size_t i = 0; i < requests.size(); ++i) {
+        results[i] = RejectCode::UnknownVenue;
+        if (clientId == NO_CLIENT) {
+            OM_LOG_WARNING("Order {} was rejected: {} {}", requests[i].request.orderId,
+                           rejectCodeText(RejectCode::UnknownVenue), venue);
+        } else {
+            m_orderEvents.publish(clientId, OrderEvent{requests[i].request.orderId, now(), OrderEventType::Rejected,
+                                                       RejectCode::UnknownVenue});
+        }
+    }
+}
+
+void VenueEngine::runSessionTimers()
+{
+    const uint64_t calibrationIntervalNs = m_config.clockCalibrationIntervalMs * 1000000ull;
+    uint64_t nextCalibration = calibrationIntervalNs > 0 ? now() + calibrationIntervalNs : WaitStrategy::NO_DEADLINE;
+    while (!m_terminate) {
+        const uint64_t interruptEpoch = m_sessionWaitStrategy.prepareWaitUntil();
+        uint64_t nextDeadline = WaitStrategy::NO_DEADLINE;
+        for (auto& venue : m_venues) {
+            nextDeadline = std::min(nextDeadline, venue->runDueTimers());
+        }
+        // one calibration for the clock of all the venues
+        if (now() >= nextCalibration) {
+            calibrateClock();
+            nextCalibration = now() + calibrationIntervalNs;
+        }
+        // venues interrupt the wait when they schedule an action
+        m_sessionWaitStrategy.waitUntil(std::min(nextDeadline, nextCalibration), interruptEpoch);
+    }
+}
+
+void VenueEngine::transmit(TransmitterThread* transmitter)
+{
+    while (!m_terminate) {
+        // taken before looking at the queues, so that orders published after the check wake us up
+        const uint64_t waitEpoch = transmitter->waitStrategy.prepareWait();
+        const uint64_t stepTime = now();
+        uint64_t nextStepTime = WaitStrategy::NO_DEADLINE;
+        for (auto& [venue, shard] : transmitter->shards) {
+            nextStepTime = std::min(nextStepTime, venue->pollShard(shard));
+        }
+        if (nextStepTime == WaitStrategy::NO_DEADLINE) {
+            transmitter->waitStrategy.waitForWork(waitEpoch);
+        } else if (nextStepTime > stepTime) {
+            // throttled, but new orders of the other shards wake the thread up earlier
+            transmitter->waitStrategy.waitForWork(waitEpoch, nextStepTime);
+        }
+    }
+}
+
+} // ordermanagement namespace
@@ -0,0 +1,125 @@
+#include <chrono>
+#include <thread>
+
+#include "WaitStrategy.h"
+
+namespace ordermanagement {
+
+WaitStrategy::WaitStrategy(WaitStrategyType type, uint32_t spinIterations, uint32_t yieldIterations)
+    : m_type(type)
+    , m_spinIterations(spinIterations)
+    , m_yieldIterations(yieldIterations)
+{
+}
+
+void WaitStrategy::waitForWork(uint64_t epoch, uint64_t deadlineNs)
+{
+    switch (m_type) {
+        case WaitStrategyType::BusySpin:
+            spinOrYield(m_workEpoch, epoch, deadlineNs, std::numeric_limits<uint32_t>::max(), false);
+            break;
+        case WaitStrategyType::Yield:
+            spinOrYield(m_workEpoch, epoch, deadlineNs, std::numeric_limits<uint32_t>::max(), true);
+            break;
+        case WaitStrategyType::Park:
+            park(m_workEpoch, epoch, deadlineNs);
+            break;
+        case WaitStrategyType::Backoff:
+            if (spinOrYield(m_workEpoch, epoch, deadlineNs, m_spinIterations, false)
+                || spinOrYield(m_workEpoch, epoch, deadlineNs, m_yieldIterations, true)) {
+                return;
+            }
+            park(m_workEpoch, epoch, deadlineNs);
+            break;
+    }
+}
+
+void WaitStrategy::waitUntil(uint64_t deadlineNs, uint64_t epoch)
+{
+    switch (m_type) {
+        case WaitStrategyType::BusySpin:
+            spinOrYield(m_interruptEpoch, epoch, deadlineNs, std::numeric_limits<uint32_t>::max(), false);
+            break;
+        case WaitStrategyType::Yield:
+            spinOrYield(m_interruptEpoch, epoch, deadlineNs, std::numeric_limits<uint32_t>::max(), true);
+            break;
+        case WaitStrategyType::Park:
+            park(m_interruptEpoch, epoch, deadlineNs);
+            break;
+        case WaitStrategyType::Backoff: {
+                // park for the bulk of the wait and spin for the rest, as parking can overshoot
+                // the deadline by scheduler granularity
+                if (deadlineNs == NO_DEADLINE) {
+                    park(m_interruptEpoch, epoch, NO_DEADLINE);
+                    break;
+                }
+                const uint64_t currentTime = getCurrentTimeNs();
+                if (deadlineNs > currentTime + SPIN_THRESHOLD_NS) {
+                    park(m_interruptEpoch, epoch, deadlineNs - SPIN_THRESHOLD_NS);
+                }
+                spinOrYield(m_interruptEpoch, epoch, deadlineNs, std::numeric_limits<uint32_t>::max(), false);
+            }
+            break;
+    }
+}
+
+void WaitStrategy::notify()
+{
+    m_workEpoch.fetch_add(1, std::memory_order_seq_cst);
+    if (m_parkedWaiters.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_condition.notify_all();
+    }
+}
+
+void WaitStrategy::interrupt()
+{
+    m_interruptEpoch.fetch_add(1, std::memory_order_seq_cst);
+    m_workEpoch.fetch_add(1, std::memory_order_seq_cst);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_condition.notify_all();
+}
+
+bool WaitStrategy::spinOrYield(const std::atomic<uint64_t>& epochCounter, uint64_t epoch,
+                               uint64_t deadlineNs, uint32_t iterations, bool yield)
+{
+    for (uint32_t i = 0; i < iterations; ++i) {
+        if (epochCounter.load(std::memory_order_acquire) != epoch) {
+            return true;
+        }
+        if (deadlineNs != NO_DEADLINE && getCurrentTimeNs() >= deadlineNs) {
+            return true;
+        }
+        if (yield) {
+            std::this_thread::yield();
+        } else {
+            cpuRelax();
+        }
+    }
+    return false;
+}
+
+void WaitStrategy::park(const std::atomic<uint64_t>& epochCounter, uint64_t epoch, uint64_t deadlineNs)
+{
+    // m_parkedWaiters is incremented before the epoch is checked under the mutex and notify()
+    // increments the epoch before checking m_parkedWaiters, so either the waiter sees the new
+    // epoch or the notifier sees the parked waiter and signals the condition variable
+    m_parkedWaiters.fetch_add(1, std::memory_order_seq_cst);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (epochCounter.load(std::memory_order_seq_cst) == epoch) {
+            if (deadlineNs == NO_DEADLINE) {
+                m_condition.wait(lock);
+                continue;
+            }
+            const uint64_t currentTime = getCurrentTimeNs();
+            if (currentTime >= deadlineNs) {
+                break;
+            }
+            m_condition.wait_for(lock, std::chrono::nanoseconds(deadlineNs - currentTime));
+        }
+    }
+    m_parkedWaiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+} // ordermanagement namespace
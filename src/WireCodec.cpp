@@ -0,0 +1,115 @@
+#include <cmath>
+
+#include "WireCodec.h"
+
+namespace ordermanagement {
+namespace wire {
+
+namespace {
+const double PRICE_SCALE = std::pow(10.0, -PRICE_EXPONENT);
+
+// NewOrderMessage and CancelReplaceMessage have the same fields
+template <typename S>
+bool encodeOrder(const OrderRequest& request, SendBuffer& buffer)
+{
+    uint8_t* message = buffer.reserve<S>();
+    if (!message) {
+        return false;
+    }
+    Encoder<S>(message)
+        .template set<OrderId>(request.orderId)
+        .template set<PriceMantissa>(std::llround(request.price * PRICE_SCALE))
+        .template set<Quantity>(request.qty)
+        .template set<SymbolId>(request.symbolId)
+        .template set<OrderSide>(request.side);
+    return true;
+}
+} // unnamed namespace
+
+bool encode(const OrderRequest& request, SendBuffer& buffer)
+{
+    return encodeOrder<NewOrderMessage>(request, buffer);
+}
+
+bool encodeReplace(const OrderRequest& request, SendBuffer& buffer)
+{
+    return encodeOrder<CancelReplaceMessage>(request, buffer);
+}
+
+bool encode(const OrderResponse& response, SendBuffer& buffer)
+{
+    uint8_t* message = buffer.reserve<OrderResponseMessage>();
+    if (!message) {
+        return false;
+    }
+    Encoder<OrderResponseMessage>(message)
+        .set<OrderId>(response.orderId)
+        .set<ResponseKind>(static_cast<uint8_t>(response.responseType));
+    return true;
+}
+
+bool encode(const Logon& logon, SendBuffer& buffer)
+{
+    if (!Username::Wire::fits(logon.username) || !Password::Wire::fits(logon.password)) {
+        return false;
+    }
+    uint8_t* message = buffer.reserve<LogonMessage>();
+    if (!message) {
+        return false;
+    }
+    Encoder<LogonMessage>(message).set<Username>(logon.username).set<Password>(logon.password);
+    return true;
+}
+
+bool encode(const Logout& logout, SendBuffer& buffer)
+{
+    if (!Username::Wire::fits(logout.username)) {
+        return false;
+    }
+    uint8_t* message = buffer.reserve<LogoutMessage>();
+    if (!message) {
+        return false;
+    }
+    Encoder<LogoutMessage>(message).set<Username>(logout.username);
+    return true;
+}
+
+bool readHeader(std::span<const uint8_t> bytes, MessageHeader& header)
+{
+    if (bytes.size() < HEADER_SIZE) {
+        return false;
+    }
+    header.blockLength = WireType<uint16_t>::load(bytes.data());
+    header.templateId = WireType<uint16_t>::load(bytes.data() + 2);
+    header.schemaId = WireType<uint16_t>::load(bytes.data() + 4);
+    header.version = WireType<uint16_t>::load(bytes.data() + 6);
+    return true;
+}
+
+OrderRequest decodeOrderRequest(const uint8_t* message)
+{
+    const Decoder<NewOrderMessage> decoder(message);
+    return OrderRequest{decoder.get<SymbolId>(), decoder.get<PriceMantissa>() / PRICE_SCALE, decoder.get<Quantity>(),
+                        decoder.get<OrderSide>(), decoder.get<OrderId>()};
+}
+
+OrderResponse decodeOrderResponse(const uint8_t* message)
+{
+    const Decoder<OrderResponseMessage> decoder(message);
+    return OrderResponse{decoder.get<OrderId>(), static_cast<ResponseType>(decoder.get<ResponseKind>())};
+}
+
+Logon decodeLogon(const uint8_t* message)
+{
+    const Decoder<LogonMessage> decoder(message);
+    return Logon{std::string(decoder.get<Username>()), std::string(decoder.get<Password>())};
+}
+
+Logout decodeLogout(const uint8_t* message)
+{
+    const Decoder<LogoutMessage> decoder(message);
+    return Logout{std::string(decoder.get<Username>())};
+}
+
+} // wire namespace
+} // ordermanagement namespace
@@ -1,15 +1,44 @@
 #include <iostream>
 #include "OrderManagement.h"
 #include "OrderStatsCollector.h"
+#include "LatencyStatsCollector.h"
 #include "Config.h"
 #include "ExchangeSimulator.h"
 #include "MockOrdersGenerator.h"
+#include "Simulation.h"
+#include "VenueEngine.h"
+#include "Logger.h"
 #include <chrono>
 #include <iostream>
 #include <inttypes.h>
 
 using namespace ordermanagement;
 
+// Counts the order events of a client by event type
+class OrderEventCounter : public IOrderEventListener {
+public:
+    void onOrderEvents(std::span<const OrderEvent> events) override
+    {
+        for (const auto& event : events) {
+            m_counts[static_cast<size_t>(event.type)].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void print(std::ostream& out) const
+    {
+        static constexpr const char* EVENT_NAMES[] = {"Queued", "Modified", "Cancelled", "Sent", "Accepted", "Rejected",
+                                                     "AmendRejected"};
+        out << "Order events:";
+        for (size_t type = 0; type < m_counts.size(); ++type) {
+            out << " " << EVENT_NAMES[type] << "=" << m_counts[type].load(std::memory_order_relaxed);
+        }
+        out << std::endl;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, 7> m_counts{};
+};
+
 void test1()
 // Open and close times are read from config
 {
@@ -28,12 +57,15 @@ void test1()
 void test2()
 // set open time 2 seconds after current time, close time 8 seconds after
 // and check that orders are first rejected then accepted
-// then rejected again as exchange closes
+// then rejected again as exchange closes, the client sees it through its order events
 {
     std::unique_ptr<IOrderStatsCollectorCallBack> callBack = 
         std::make_unique<OrderStatsFileWriterCallback>("test2.txt");
     std::string configFilename = "../config/config.txt";
     OrderManagement manager(configFilename, std::move(callBack));
+    auto orderEvents = std::make_unique<OrderEventCounter>();
+    const OrderEventCounter& orderEventCounter = *orderEvents;
+    const ClientId clientId = manager.getOrderEvents().registerClient(std::move(orderEvents));
     Config& config = manager.getConfig();
     uint64_t currentTime = getCurrentTimeNs();
     config.dumpConfig();
@@ -44,18 +76,23 @@ void test2()
     ExchangeResponseSimulator simulator(&manager);
     manager.setExchangeSimulator(&simulator);
     manager.start();
-    MockOrdersGenerator client(&manager, 1);
+    MockOrdersGenerator client(&manager, 1, MockOrdersGenerator::DEFAULT_REQUEST_PAUSE_NS, true, clientId);
     std::this_thread::sleep_for(std::chrono::seconds(12));
+    orderEventCounter.print(std::cout);
     std::cout << "Terminating 2" << std::endl;
 }
 
 void test3()
 // 3 clients, simultaneously submitting orders to OrderManagement
+// stats are delivered to the file writer and to a latency histogram subscriber through the stats bus
 {
+    std::string configFilename = "../config/config.txt";
     std::unique_ptr<IOrderStatsCollectorCallBack> callBack = 
         std::make_unique<OrderStatsFileWriterCallback>("test3.txt");
-    std::string configFilename = "../config/config.txt";
     OrderManagement manager(configFilename, std::move(callBack));
+    auto latencyStats = std::make_unique<LatencyStatsCollectorCallback>();
+    const LatencyStatsCollectorCallback& latencySummary = *latencyStats;
+    const SubscriberId latencySubscriber = manager.getStatsBus().subscribe(std::move(latencyStats));
     Config& config = manager.getConfig();
     uint64_t currentTime = getCurrentTimeNs();
     const auto currentTimeOffsetFromDateStart = currentTime % NS_IN_DAY;
@@ -69,9 +106,87 @@ void test3()
     MockOrdersGenerator client2(&manager, 2);
     MockOrdersGenerator client3(&manager, 3);
     std::this_thread::sleep_for(std::chrono::seconds(12));
+    // the console log is written asynchronously, let it catch up before printing the summary
+    Logger::flush();
+    latencySummary.printSummary(std::cout, StatsWindow::Session);
+    manager.getStatsBus().unsubscribe(latencySubscriber);
     std::cout << "Terminating 3" << std::endl;
 }
 
+void test4()
+// a whole 9:30-16:00 session of flow from a client, throttled to Rate orders per MonitorWindowSec,
+// replayed on virtual time in a few seconds
+{
+    std::string configFilename = "../config/config.txt";
+    const uint64_t currentTime = getCurrentTimeNs();
+    const uint64_t dayStart = currentTime - currentTime % NS_IN_DAY;
+    const uint64_t openTime = dayStart + (9 * 3600 + 30 * 60) * NS_IN_SECOND;
+    const uint64_t closeTime = dayStart + 16 * 3600 * NS_IN_SECOND;
+    VirtualClock clock(openTime);
+    OrderManagement manager(configFilename, nullptr, &clock);
+    // virtual time runs much faster than the real time delivery threads, a whole day has to fit into the queues
+    manager.getStatsBus().subscribe(std::make_unique<OrderStatsFileWriterCallback>("test4.txt"), 1 << 20);
+    auto latencyStats = std::make_unique<LatencyStatsCollectorCallback>();
+    const LatencyStatsCollectorCallback& latencySummary = *latencyStats;
+    const SubscriberId latencySubscriber = manager.getStatsBus().subscribe(std::move(latencyStats), 1 << 20);
+    Config& config = manager.getConfig();
+    config.sessions = {TradingSession{openTime - dayStart, closeTime - dayStart}};
+    ExchangeResponseSimulator simulator(&manager, &clock, 50000, 1);
+    manager.setExchangeSimulator(&simulator);
+    manager.startSimulation();
+    MockOrdersGenerator client(&manager, 1, true);
+    Simulation simulation(clock, manager, simulator);
+    simulation.addOrdersGenerator(client, openTime);
+    const uint64_t steps = simulation.runUntil(closeTime + NS_IN_SECOND);
+    std::cout << "Simulated " << (closeTime - openTime) / NS_IN_SECOND << "s in " << steps << " steps, took "
+              << (getCurrentTimeNs() - currentTime) / 1000000 << "ms" << std::endl;
+    // the stats bus delivers on its own threads, in real time
+    while (manager.getStatsBus().getSubscriberStats(latencySubscriber).lag > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    Logger::flush();
+    latencySummary.printSummary(std::cout, StatsWindow::Session);
+    manager.getStatsBus().unsubscribe(latencySubscriber);
+    std::cout << "Terminating 4" << std::endl;
+}
+
+void test5()
+// two venues with their own throttles in one engine, sharing one transmitter thread and the order event queues,
+// NYSE sends 20 orders per second, LSE 5
+{
+    std::string configFilename = "../config/venues_config.txt";
+    VenueEngine engine(configFilename, nullptr);
+    const uint64_t currentTime = getCurrentTimeNs();
+    const auto currentTimeOffsetFromDateStart = currentTime % NS_IN_DAY;
+    std::vector<std::unique_ptr<ExchangeResponseSimulator>> simulators;
+    std::vector<const OrderEventCounter*> eventCounters;
+    std::vector<std::unique_ptr<MockOrdersGenerator>> clients;
+    for (VenueId venue = 0; venue < engine.getVenueCount(); ++venue) {
+        OrderManagement& manager = engine.getVenue(venue);
+        Config& config = manager.getConfig();
+        config.sessions = {TradingSession{currentTimeOffsetFromDateStart - NS_IN_SECOND,
+                                          currentTimeOffsetFromDateStart + 30 * NS_IN_SECOND}};
+        simulators.push_back(std::make_unique<ExchangeResponseSimulator>(&manager));
+        manager.setExchangeSimulator(simulators.back().get());
+    }
+    engine.start();
+    for (VenueId venue = 0; venue < engine.getVenueCount(); ++venue) {
+        auto orderEvents = std::make_unique<OrderEventCounter>();
+        eventCounters.push_back(orderEvents.get());
+        const ClientId clientId = engine.getOrderEvents().registerClient(std::move(orderEvents));
+        clients.push_back(std::make_unique<MockOrdersGenerator>(&engine.getVenue(venue), venue + 1, 10000000, false,
+                                                                clientId));
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(3));
+    clients.clear();
+    Logger::flush();
+    for (VenueId venue = 0; venue < engine.getVenueCount(); ++venue) {
+        std::cout << (venue == engine.getVenueId("NYSE") ? "NYSE " : "LSE ");
+        eventCounters[venue]->print(std::cout);
+    }
+    std::cout << "Terminating 5" << std::endl;
+}
+
 int main(int, char**)
 {
     
@@ -86,5 +201,7 @@ int main(int, char**)
     // I use dependency injection in the design to perform the testing.
     test2();
     test3();
+    test4();
+    test5();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,201 @@
+// Stand-in exchange process for SocketExchangeGateway: listens on a TCP or Unix domain socket, speaks the binary
+// wire format (WireCodec.h) and answers every NewOrder and CancelReplace with an OrderResponse, a Reject for
+// --reject-ratio of them and an Accept otherwise. A Logon is acknowledged by echoing it back, a Logout isn't answered.
+// One thread runs an epoll loop over all the clients, the responses to the messages of one read are encoded
+// into one buffer and written with one call, so the exchange side batches as much as the gateway does.
+// Stop it with Ctrl-C, or kill it to check that the gateway rejects the orders in flight and reconnects.
+//
+// Usage: StandInExchange [--listen tcp:127.0.0.1:9000|unix:<path>] [--reject-ratio R]
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "SocketAddress.h"
+#include "WireCodec.h"
+
+using namespace ordermanagement;
+
+namespace {
+
+constexpr size_t BUFFER_SIZE = 65536;
+constexpr int MAX_EPOLL_EVENTS = 64;
+
+struct Options {
+    std::string listenAddress = "tcp:127.0.0.1:9000";
+    double rejectRatio = 0.0;
+};
+
+struct Client {
+    uint8_t readBuffer[BUFFER_SIZE];
+    size_t readBytes = 0;
+    uint64_t orders = 0;
+};
+
+volatile std::sig_atomic_t terminateRequested = 0;
+
+void onSignal(int)
+{
+    terminateRequested = 1;
+}
+
+// Blocks until the whole buffer is written, the responses are small compared to the socket buffer
+bool writeAll(int fd, const wire::SendBuffer& buffer)
+{
+    size_t offset = 0;
+    while (offset < buffer.size()) {
+        const ssize_t result = ::send(fd, buffer.data() + offset, buffer.size() - offset, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                usleep(50);
+                continue;
+            }
+            return false;
+        }
+        offset += result;
+    }
+    return true;
+}
+
+// Returns false if the client has to be dropped
+bool serveClient(int fd, Client& client, wire::SendBuffer& responses, std::mt19937_64& generator,
+                 std::bernoulli_distribution& reject)
+{
+    for (;;) {
+        const size_t requested = BUFFER_SIZE - client.readBytes;
+        const ssize_t result = read(fd, client.readBuffer + client.readBytes, requested);
+        if (result == 0) {
+            return false;
+        }
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        client.readBytes += result;
+        responses.clear();
+        const size_t consumed = wire::forEachMessage(
+            std::span<const uint8_t>(client.readBuffer, client.readBytes),
+            [&](const wire::MessageHeader& header, const uint8_t* message) {
+                if (header.templateId == wire::NewOrderMessage::TEMPLATE_ID
+                    || header.templateId == wire::CancelReplaceMessage::TEMPLATE_ID) {
+                    ++client.orders;
+                    const wire::Decoder<wire::NewOrderMessage> order(message);
+                    wire::encode(OrderResponse{order.get<wire::OrderId>(),
+                                               reject(generator) ? ResponseType::Reject : ResponseType::Accept},
+                                 responses);
+                } else if (header.templateId == wire::LogonMessage::TEMPLATE_ID) {
+                    const Logon logon = wire::decodeLogon(message);
+                    std::cout << "Logon of " << logon.username << std::endl;
+                    wire::encode(logon, responses);
+                } else if (header.templateId == wire::LogoutMessage::TEMPLATE_ID) {
+                    std::cout << "Logout of " << wire::decodeLogout(message).username << " after " << client.orders
+                              << " orders" << std::endl;
+                }
+            });
+        std::memmove(client.readBuffer, client.readBuffer + consumed, client.readBytes - consumed);
+        client.readBytes -= consumed;
+        if (!writeAll(fd, responses)) {
+            return false;
+        }
+        if (static_cast<size_t>(result) < requested) {
+            return true;
+        }
+    }
+}
+
+void usage()
+{
+    std::cerr << "Usage: StandInExchange [--listen tcp:127.0.0.1:9000|unix:<path>] [--reject-ratio R]" << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int arg = 1; arg < argc; ++arg) {
+        if (arg + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++arg];
+        if (std::strcmp(argv[arg - 1], "--listen") == 0) {
+            options.listenAddress = value;
+        } else if (std::strcmp(argv[arg - 1], "--reject-ratio") == 0) {
+            options.rejectRatio = std::atof(value);
+        } else {
+            return false;
+        }
+    }
+    return options.rejectRatio >= 0.0 && options.rejectRatio <= 1.0;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 1;
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    int listenFd;
+    try {
+        listenFd = listenSocket(parseSocketAddress(options.listenAddress));
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    const int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    std::cout << "Listening on " << options.listenAddress << std::endl;
+
+    std::unordered_map<int, std::unique_ptr<Client>> clients;
+    wire::SendBuffer responses(BUFFER_SIZE);
+    std::mt19937_64 generator(std::random_device{}());
+    std::bernoulli_distribution reject(options.rejectRatio);
+    epoll_event events[MAX_EPOLL_EVENTS];
+    while (!terminateRequested) {
+        const int count = epoll_wait(epollFd, events, MAX_EPOLL_EVENTS, 100);
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                for (int clientFd = acceptSocket(listenFd); clientFd >= 0; clientFd = acceptSocket(listenFd)) {
+                    event.events = EPOLLIN;
+                    event.data.fd = clientFd;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &event);
+                    clients.emplace(clientFd, std::make_unique<Client>());
+                }
+                continue;
+            }
+            const auto client = clients.find(fd);
+            if (client != clients.end() && !serveClient(fd, *client->second, responses, generator, reject)) {
+                std::cout << "Client disconnected after " << client->second->orders << " orders" << std::endl;
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                close(fd);
+                clients.erase(client);
+            }
+        }
+    }
+    for (const auto& [fd, client] : clients) {
+        close(fd);
+    }
+    close(listenFd);
+    close(epollFd);
+    return 0;
+}
@@ -0,0 +1,201 @@
+// Reads a binary stats file written by BinaryStatsFileWriterCallback.
+// Prints record counts per response type, reject ratio, queue wait and round trip latency percentiles
+// and per second throughput (by response receival time). The file is mapped read only and scanned
+// by several threads, each one working on its own slice of the records.
+// With --csv the records are also converted to the CSV format written by OrderStatsFileWriterCallback.
+//
+// Usage: StatsReader <stats file> [--threads N] [--per-second] [--csv <output file>]
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BinaryStatsFile.h"
+
+using namespace ordermanagement;
+
+namespace {
+
+constexpr size_t RESPONSE_TYPES = 3;
+constexpr std::array<const char*, RESPONSE_TYPES> RESPONSE_TYPE_NAMES = {"Unknown", "Accept", "Reject"};
+constexpr std::array<double, 6> PERCENTILES = {50.0, 90.0, 99.0, 99.9, 99.99, 100.0};
+
+struct SliceSummary {
+    std::array<uint64_t, RESPONSE_TYPES> responseCounts{};
+    uint64_t firstResponseTimeNs = UINT64_MAX;
+    uint64_t lastResponseTimeNs = 0;
+    std::vector<uint64_t> perSecondCounts;
+};
+
+template <typename Function>
+void runOnSlices(size_t threads, size_t total, Function function)
+{
+    std::vector<std::thread> workers;
+    const size_t sliceSize = (total + threads - 1) / threads;
+    for (size_t thread = 0; thread < threads; ++thread) {
+        const size_t begin = std::min(total, thread * sliceSize);
+        const size_t end = std::min(total, begin + sliceSize);
+        workers.emplace_back(function, thread, begin, end);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+using Percentiles = std::array<int64_t, PERCENTILES.size()>;
+
+Percentiles computePercentiles(std::vector<int64_t>& values)
+{
+    Percentiles result{};
+    // percentiles are selected in increasing order, so every nth_element only works on the tail
+    auto begin = values.begin();
+    for (size_t percentile = 0; percentile < PERCENTILES.size(); ++percentile) {
+        const size_t rank = std::min(values.size() - 1,
+                                     static_cast<size_t>(PERCENTILES[percentile] / 100.0 * (values.size() - 1) + 0.5));
+        auto nth = values.begin() + rank;
+        std::nth_element(begin, nth, values.end());
+        begin = nth;
+        result[percentile] = *nth;
+    }
+    return result;
+}
+
+void printPercentiles(const std::string& name, const Percentiles& percentiles)
+{
+    std::cout << name << ":";
+    for (size_t percentile = 0; percentile < PERCENTILES.size(); ++percentile) {
+        std::cout << " p" << PERCENTILES[percentile] << "=" << percentiles[percentile];
+    }
+    std::cout << " (ns)" << std::endl;
+}
+
+void writeCsv(const std::string& filename, std::span<const BinaryStatsRecord> records)
+{
+    std::ofstream csvFile(filename);
+    csvFile << "#OrderId,ResponseType,OrderWaitTimeInQueue,OrderRoundTripLatency\n";
+    for (const auto& record : records) {
+        const OrderResponse response{record.orderId, static_cast<ResponseType>(record.responseType)};
+        const OrderStats stats{record.orderManagerReceiveTimeNs, record.requestSendTimeNs, record.responseReceivalTimeNs};
+        csvFile << response << "," << stats << "\n";
+    }
+}
+
+void usage()
+{
+    std::cerr << "Usage: StatsReader <stats file> [--threads N] [--per-second] [--csv <output file>]" << std::endl;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    std::string statsFilename = argv[1];
+    std::string csvFilename;
+    bool printPerSecond = false;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int arg = 2; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--csv") == 0 && arg + 1 < argc) {
+            csvFilename = argv[++arg];
+        } else if (std::strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++arg]));
+        } else if (std::strcmp(argv[arg], "--per-second") == 0) {
+            printPerSecond = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    try {
+        MappedStatsFile statsFile(statsFilename);
+        const auto records = statsFile.records();
+        std::cout << "Records: " << records.size() << std::endl;
+        if (records.empty()) {
+            return 0;
+        }
+        threads = std::min(threads, records.size());
+
+        // first pass: response counts, time range and latencies
+        std::vector<SliceSummary> summaries(threads);
+        std::vector<int64_t> waitTimesInQueue(records.size());
+        std::vector<int64_t> roundTripLatencies(records.size());
+        runOnSlices(threads, records.size(), [&](size_t thread, size_t begin, size_t end) {
+            auto& summary = summaries[thread];
+            for (size_t index = begin; index < end; ++index) {
+                const auto& record = records[index];
+                ++summary.responseCounts[std::min<size_t>(record.responseType, RESPONSE_TYPES - 1)];
+                summary.firstResponseTimeNs = std::min(summary.firstResponseTimeNs, record.responseReceivalTimeNs);
+                summary.lastResponseTimeNs = std::max(summary.lastResponseTimeNs, record.responseReceivalTimeNs);
+                waitTimesInQueue[index] = record.requestSendTimeNs - record.orderManagerReceiveTimeNs;
+                roundTripLatencies[index] = record.responseReceivalTimeNs - record.requestSendTimeNs;
+            }
+        });
+        std::array<uint64_t, RESPONSE_TYPES> responseCounts{};
+        uint64_t firstResponseTimeNs = UINT64_MAX;
+        uint64_t lastResponseTimeNs = 0;
+        for (const auto& summary : summaries) {
+            for (size_t type = 0; type < RESPONSE_TYPES; ++type) {
+                responseCounts[type] += summary.responseCounts[type];
+            }
+            firstResponseTimeNs = std::min(firstResponseTimeNs, summary.firstResponseTimeNs);
+            lastResponseTimeNs = std::max(lastResponseTimeNs, summary.lastResponseTimeNs);
+        }
+
+        // second pass: responses per second, now that the time range is known
+        const uint64_t firstSecond = firstResponseTimeNs / NS_IN_SECOND;
+        const size_t seconds = lastResponseTimeNs / NS_IN_SECOND - firstSecond + 1;
+        runOnSlices(threads, records.size(), [&](size_t thread, size_t begin, size_t end) {
+            auto& perSecondCounts = summaries[thread].perSecondCounts;
+            perSecondCounts.assign(seconds, 0);
+            for (size_t index = begin; index < end; ++index) {
+                ++perSecondCounts[records[index].responseReceivalTimeNs / NS_IN_SECOND - firstSecond];
+            }
+        });
+        std::vector<uint64_t> perSecondCounts(seconds, 0);
+        for (const auto& summary : summaries) {
+            for (size_t second = 0; second < seconds; ++second) {
+                perSecondCounts[second] += summary.perSecondCounts[second];
+            }
+        }
+
+        for (size_t type = 0; type < RESPONSE_TYPES; ++type) {
+            std::cout << RESPONSE_TYPE_NAMES[type] << ": " << responseCounts[type] << std::endl;
+        }
+        std::cout << "Reject ratio: "
+                  << static_cast<double>(responseCounts[static_cast<size_t>(ResponseType::Reject)]) / records.size()
+                  << std::endl;
+        const uint64_t peakThroughput = *std::max_element(perSecondCounts.begin(), perSecondCounts.end());
+        std::cout << "Throughput: mean=" << static_cast<double>(records.size()) / seconds
+                  << " peak=" << peakThroughput << " (responses/s over " << seconds << "s)" << std::endl;
+        if (printPerSecond) {
+            for (size_t second = 0; second < seconds; ++second) {
+                std::cout << "  " << (firstSecond + second) << " " << perSecondCounts[second] << std::endl;
+            }
+        }
+
+        Percentiles waitTimePercentiles;
+        std::thread waitTimeThread([&] { waitTimePercentiles = computePercentiles(waitTimesInQueue); });
+        const Percentiles roundTripPercentiles = computePercentiles(roundTripLatencies);
+        waitTimeThread.join();
+        printPercentiles("OrderWaitTimeInQueue", waitTimePercentiles);
+        printPercentiles("OrderRoundTripLatency", roundTripPercentiles);
+
+        if (!csvFilename.empty()) {
+            writeCsv(csvFilename, records);
+            std::cout << "CSV written to " << csvFilename << std::endl;
+        }
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}